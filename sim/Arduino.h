@@ -0,0 +1,168 @@
+#pragma once
+// Host stand-in for the ESP8266 Arduino core (env:native). Only what this
+// project and U8g2lib use; time is virtual, see sim.h.
+#include "Print.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x00
+#define OUTPUT 0x01
+#define INPUT_PULLUP 0x02
+
+// NodeMCU pin names
+#define D0 16
+#define D1 5
+#define D2 4
+#define D3 0
+#define D4 2
+#define D5 14
+#define D6 12
+#define D7 13
+#define D8 15
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+// flash data is plain memory on the host
+#define PROGMEM
+#define memcpy_P memcpy
+
+inline bool isDigit(int c) { return c >= '0' && c <= '9'; }
+
+uint32_t simRandom();
+#define RANDOM_REG32 (simRandom())
+
+class String
+{
+public:
+  String() {}
+  String(const char* s) : s_(s ? s : "") {}
+  String(const char* s, size_t n) : s_(s, n) {}
+
+  unsigned length() const { return (unsigned)s_.size(); }
+  const char* c_str() const { return s_.c_str(); }
+  bool reserve(unsigned n)
+  {
+    s_.reserve(n);
+    return true;
+  }
+  bool concat(const char* s, unsigned n)
+  {
+    s_.append(s, n);
+    return true;
+  }
+  char charAt(unsigned i) const { return i < s_.size() ? s_[i] : 0; }
+  int indexOf(const char* s) const
+  {
+    const size_t p = s_.find(s);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+  String substring(unsigned from) const { return substring(from, length()); }
+  String substring(unsigned from, unsigned to) const
+  {
+    if (from > s_.size())
+      from = (unsigned)s_.size();
+    if (to > s_.size())
+      to = (unsigned)s_.size();
+    return to > from ? String(s_.data() + from, to - from) : String();
+  }
+  long toInt() const { return atol(s_.c_str()); }
+
+  String& operator+=(const char* s)
+  {
+    s_ += s;
+    return *this;
+  }
+  String operator+(const char* s) const
+  {
+    String r(*this);
+    r += s;
+    return r;
+  }
+  bool operator==(const char* s) const { return s_ == s; }
+
+private:
+  std::string s_;
+};
+
+inline size_t Print::print(const String& s) { return write(s.c_str()); }
+
+class Stream : public Print
+{
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() { return -1; }
+  virtual void flush() {}
+  void setTimeout(unsigned long ms) { timeoutMs_ = ms; }
+
+protected:
+  unsigned long timeoutMs_ = 1000;
+};
+
+class HardwareSerial : public Stream
+{
+public:
+  void begin(unsigned long) {}
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buf, size_t n) override;
+  int available() override { return 0; }
+  int read() override { return -1; }
+};
+extern HardwareSerial Serial;
+
+struct ip_addr;
+typedef struct ip_addr ip_addr_t;
+
+class IPAddress
+{
+public:
+  IPAddress() : addr_(0) {}
+  IPAddress(uint32_t a) : addr_(a) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+      : addr_((uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24))
+  {
+  }
+  explicit IPAddress(const ip_addr_t* ip);
+
+  operator uint32_t() const { return addr_; }
+  uint8_t operator[](int i) const { return (uint8_t)(addr_ >> (8 * i)); }
+  bool isSet() const { return addr_ != 0; }
+  String toString() const
+  {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(buf);
+  }
+
+private:
+  uint32_t addr_; // network order, first octet in the low byte like lwIP
+};
+
+struct rst_info;
+
+class EspClass
+{
+public:
+  uint32_t getCycleCount();
+  uint8_t getCpuFreqMHz() { return 80; }
+  uint32_t getFreeHeap();
+  uint32_t getMaxFreeBlockSize();
+  uint8_t getHeapFragmentation();
+  bool rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size);
+  bool rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size);
+  rst_info* getResetInfoPtr();
+};
+extern EspClass ESP;
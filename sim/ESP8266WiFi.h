@@ -0,0 +1,96 @@
+#pragma once
+// Host stand-in for ESP8266WiFi: one scripted access point, see SimConfig.
+#include "WiFiUdp.h"
+#include <Arduino.h>
+#include <functional>
+#include <memory>
+#include <user_interface.h>
+
+typedef enum
+{
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_DISCONNECTED = 6,
+} wl_status_t;
+
+enum WiFiMode_t
+{
+  WIFI_OFF = 0,
+  WIFI_STA = 1,
+};
+
+enum WiFiSleepType_t
+{
+  WIFI_NONE_SLEEP = 0,
+  WIFI_LIGHT_SLEEP = 1,
+  WIFI_MODEM_SLEEP = 2,
+};
+
+enum WiFiDisconnectReason
+{
+  WIFI_DISCONNECT_REASON_ASSOC_LEAVE = 8,
+  WIFI_DISCONNECT_REASON_BEACON_TIMEOUT = 200,
+  WIFI_DISCONNECT_REASON_NO_AP_FOUND = 201,
+};
+
+struct WiFiEventStationModeConnected
+{
+  String ssid;
+  uint8_t bssid[6];
+  uint8_t channel;
+};
+
+struct WiFiEventStationModeDisconnected
+{
+  String ssid;
+  uint8_t bssid[6];
+  WiFiDisconnectReason reason;
+};
+
+struct WiFiEventStationModeGotIP
+{
+  IPAddress ip;
+  IPAddress mask;
+  IPAddress gw;
+};
+
+// Like the core, the stack only keeps weak references: a handler whose
+// returned handle is dropped is never called.
+struct WiFiEventHandlerOpaque
+{
+  virtual ~WiFiEventHandlerOpaque() {}
+};
+typedef std::shared_ptr<WiFiEventHandlerOpaque> WiFiEventHandler;
+
+class ESP8266WiFiClass
+{
+public:
+  bool mode(WiFiMode_t m);
+  void persistent(bool) {}
+  bool setAutoReconnect(bool on);
+  bool setSleepMode(WiFiSleepType_t) { return true; }
+  void setOutputPower(float) {}
+
+  wl_status_t begin(const char* ssid, const char* pass, int32_t channel = 0, const uint8_t* bssid = nullptr,
+                    bool connect = true);
+  bool config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1 = (uint32_t)0,
+              IPAddress dns2 = (uint32_t)0);
+  bool disconnect(bool wifiOff = false);
+
+  wl_status_t status();
+  String SSID() const;
+  uint8_t* BSSID();
+  int32_t channel();
+  int32_t RSSI();
+  IPAddress localIP();
+  IPAddress gatewayIP();
+  IPAddress subnetMask();
+  IPAddress dnsIP(uint8_t n = 0);
+
+  WiFiEventHandler onStationModeConnected(std::function<void(const WiFiEventStationModeConnected&)> f);
+  WiFiEventHandler onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected&)> f);
+  WiFiEventHandler onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)> f);
+};
+extern ESP8266WiFiClass WiFi;
@@ -0,0 +1,50 @@
+#pragma once
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+class String;
+
+// Host stand-in for the Arduino Print class (subset used here and by U8g2lib).
+class Print
+{
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t n)
+  {
+    size_t i = 0;
+    while (i < n && write(buf[i]))
+      i++;
+    return i;
+  }
+  size_t write(const char* s) { return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+  size_t write(const char* s, size_t n) { return write((const uint8_t*)s, n); }
+
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)))
+  {
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n < 0)
+      return 0;
+    return write((const uint8_t*)buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+  }
+
+  size_t print(const char* s) { return write(s); }
+  size_t print(const String& s);
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(long v) { return printf("%ld", v); }
+  size_t print(int v) { return printf("%d", v); }
+  size_t print(unsigned long v) { return printf("%lu", v); }
+  size_t print(unsigned v) { return printf("%u", v); }
+  size_t print(double v) { return printf("%.2f", v); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(T v) { return print(v) + println(); }
+};
@@ -0,0 +1,43 @@
+#pragma once
+// Host stand-in for the Arduino SPI library, so U8g2's hardware SPI driver
+// links in env:native. Transfers cost virtual time at the set clock and are
+// recorded in simBus().
+#include <Arduino.h>
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x01
+#define SPI_MODE2 0x02
+#define SPI_MODE3 0x03
+
+class SPISettings
+{
+public:
+  SPISettings(uint32_t clock = 1000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0)
+      : clock(clock), bitOrder(bitOrder), dataMode(dataMode)
+  {
+  }
+  uint32_t clock;
+  uint8_t bitOrder;
+  uint8_t dataMode;
+};
+
+class SPIClass
+{
+public:
+  void begin() {}
+  void end() {}
+  void beginTransaction(SPISettings s);
+  void endTransaction() {}
+  void setBitOrder(uint8_t) {}
+  void setDataMode(uint8_t) {}
+  void setClockDivider(uint32_t) {}
+  void setFrequency(uint32_t hz) { clock_ = hz ? hz : 1000000; }
+  uint8_t transfer(uint8_t data);
+  void transfer(void* buf, size_t n);
+
+private:
+  uint32_t clock_ = 1000000;
+};
+extern SPIClass SPI;
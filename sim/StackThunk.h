@@ -0,0 +1,12 @@
+#pragma once
+// Host stand-in for the ESP8266 core's StackThunk.h: the separate BearSSL
+// stack is only reference counted, and the thunk_br_ssl_engine_* entry
+// points the core defines for WiFiClientSecure call the engine directly.
+#include <stdint.h>
+
+extern "C"
+{
+  void stack_thunk_add_ref();
+  void stack_thunk_del_ref();
+  uint32_t stack_thunk_get_refcnt();
+}
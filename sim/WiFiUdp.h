@@ -0,0 +1,41 @@
+#pragma once
+// Host stand-in for WiFiUDP. Packets to port 123 of a resolved pool.ntp.org
+// address get an NTPv4 server reply carrying the reference UTC.
+#include <Arduino.h>
+
+class WiFiUDP : public Stream
+{
+public:
+  uint8_t begin(uint16_t port);
+  void stop();
+  int beginPacket(IPAddress ip, uint16_t port);
+  int beginPacket(const char* host, uint16_t port);
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buf, size_t n) override;
+  int endPacket();
+  int parsePacket();
+  int available() override;
+  int read() override;
+  int read(uint8_t* buf, size_t n);
+  void flush() override;
+  IPAddress remoteIP() const { return rxFrom_; }
+
+private:
+  static constexpr size_t kMaxPacket = 48;
+
+  IPAddress txTo_;
+  uint16_t txPort_ = 0;
+  uint8_t tx_[kMaxPacket];
+  size_t txLen_ = 0;
+
+  // one reply in flight
+  bool pending_ = false;
+  uint64_t pendingAtUs_ = 0;
+  IPAddress pendingFrom_;
+  uint8_t pendingData_[kMaxPacket];
+
+  IPAddress rxFrom_;
+  uint8_t rx_[kMaxPacket];
+  size_t rxLen_ = 0;
+  size_t rxPos_ = 0;
+};
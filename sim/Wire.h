@@ -0,0 +1,27 @@
+#pragma once
+// Host stand-in for the Arduino Wire library, so U8g2's hardware I2C driver
+// links in env:native. Each byte costs 9 bit times of virtual time, and the
+// traffic is recorded in simBus().
+#include <Arduino.h>
+
+class TwoWire
+{
+public:
+  void begin() {}
+  void begin(int sda, int scl)
+  {
+    (void)sda;
+    (void)scl;
+  }
+  void end() {}
+  void setClock(uint32_t hz) { clock_ = hz ? hz : 100000; }
+  void beginTransmission(uint8_t address);
+  void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+  size_t write(uint8_t data);
+  size_t write(const uint8_t* data, size_t n);
+  uint8_t endTransmission(bool sendStop = true);
+
+private:
+  uint32_t clock_ = 100000;
+};
+extern TwoWire Wire;
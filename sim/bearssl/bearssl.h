@@ -0,0 +1,115 @@
+#pragma once
+// Host stand-in for the BearSSL client API the firmware uses (subset, same
+// names and signatures as the ESP8266 core's copy). There is no crypto: the
+// "handshake" is two line-framed flights each way that the fake time API in
+// sim_net.cpp answers, after which application data goes through as is.
+//
+//   client: SIM_TLS_HELLO <server name> \n      server: 0x16, certificate-sized filler, \n
+//   client: SIM_TLS_FINISHED \n                 server: SIM_TLS_FINISHED \n
+//
+// The server's flight ends the key exchange, which runs as one uninterrupted
+// call on the device; the engine charges SimConfig::tlsKeyExchangeMs of
+// virtual time there. An SIM_TLS_ALERT line from the server fails the engine.
+#include <stddef.h>
+#include <stdint.h>
+
+#define SIM_TLS_HELLO "\x16SIM-CLIENT-HELLO "
+#define SIM_TLS_FINISHED "\x16SIM-FINISHED"
+#define SIM_TLS_ALERT "\x15SIM-ALERT"
+
+#define BR_SSL_CLOSED 0x0001
+#define BR_SSL_SENDREC 0x0002
+#define BR_SSL_RECVREC 0x0004
+#define BR_SSL_SENDAPP 0x0008
+#define BR_SSL_RECVAPP 0x0010
+
+#define BR_SSL_BUFSIZE_MONO 16709
+
+#define BR_ERR_OK 0
+#define BR_ERR_BAD_PARAM 1
+#define BR_ERR_UNEXPECTED 10
+#define BR_ERR_X509_EMPTY_CHAIN 35
+#define BR_ERR_RECV_FATAL_ALERT 256
+
+#define BR_KEYTYPE_KEYX 0x10
+#define BR_KEYTYPE_SIGN 0x20
+
+typedef struct
+{
+  unsigned char key_type;
+} br_x509_pkey;
+
+typedef struct br_x509_class_ br_x509_class;
+struct br_x509_class_
+{
+  size_t context_size;
+  void (*start_chain)(const br_x509_class** ctx, const char* server_name);
+  void (*start_cert)(const br_x509_class** ctx, uint32_t length);
+  void (*append)(const br_x509_class** ctx, const unsigned char* buf, size_t len);
+  void (*end_cert)(const br_x509_class** ctx);
+  unsigned (*end_chain)(const br_x509_class** ctx);
+  const br_x509_pkey* (*get_pkey)(const br_x509_class* const* ctx, unsigned* usages);
+};
+
+typedef struct
+{
+  br_x509_pkey pkey;
+  int err;
+} br_x509_decoder_context;
+
+// The core's fork takes issuer DN callbacks as well as the subject's.
+void br_x509_decoder_init(br_x509_decoder_context* ctx, void (*append_dn)(void* ctx, const void* buf, size_t len),
+                          void* append_dn_ctx, void (*append_in)(void* ctx, const void* buf, size_t len),
+                          void* append_in_ctx);
+void br_x509_decoder_push(br_x509_decoder_context* ctx, const void* data, size_t len);
+static inline br_x509_pkey* br_x509_decoder_get_pkey(br_x509_decoder_context* ctx) { return &ctx->pkey; }
+static inline int br_x509_decoder_last_error(br_x509_decoder_context* ctx) { return ctx->err; }
+
+typedef struct
+{
+  int unused;
+} br_x509_minimal_context;
+
+typedef struct
+{
+  unsigned char* buf; // application data received, at the front
+  size_t bufLen;
+  size_t appIn;       // bytes of it not yet taken by recvapp_ack
+  unsigned char out[600]; // handshake flight or flushed application data
+  size_t outLen;
+  size_t outOff;
+  size_t appOut; // application data written, not yet flushed
+  uint8_t phase; // hello out, server flight, finished out, server finished, open, closed
+  size_t lineLen;
+  int err;
+  const br_x509_class** x509;
+} br_ssl_engine_context;
+
+typedef struct
+{
+  br_ssl_engine_context eng;
+} br_ssl_client_context;
+
+typedef struct br_x509_trust_anchor_ br_x509_trust_anchor;
+
+void br_ssl_client_init_full(br_ssl_client_context* cc, br_x509_minimal_context* xc,
+                             const br_x509_trust_anchor* trust_anchors, size_t trust_anchors_num);
+int br_ssl_client_reset(br_ssl_client_context* cc, const char* server_name, int resume_session);
+void br_ssl_engine_set_buffer(br_ssl_engine_context* cc, void* iobuf, size_t iobuf_len, int bidi);
+static inline void br_ssl_engine_set_x509(br_ssl_engine_context* cc, const br_x509_class** x509ctx)
+{
+  cc->x509 = x509ctx;
+}
+unsigned br_ssl_engine_current_state(const br_ssl_engine_context* cc);
+static inline int br_ssl_engine_last_error(const br_ssl_engine_context* cc) { return cc->err; }
+void br_ssl_engine_flush(br_ssl_engine_context* cc, int force);
+void br_ssl_engine_close(br_ssl_engine_context* cc);
+
+unsigned char* br_ssl_engine_sendrec_buf(const br_ssl_engine_context* cc, size_t* len);
+void br_ssl_engine_sendrec_ack(br_ssl_engine_context* cc, size_t len);
+unsigned char* br_ssl_engine_recvrec_buf(const br_ssl_engine_context* cc, size_t* len);
+void br_ssl_engine_recvrec_ack(br_ssl_engine_context* cc, size_t len);
+unsigned char* br_ssl_engine_sendapp_buf(const br_ssl_engine_context* cc, size_t* len);
+void br_ssl_engine_sendapp_ack(br_ssl_engine_context* cc, size_t len);
+unsigned char* br_ssl_engine_recvapp_buf(const br_ssl_engine_context* cc, size_t* len);
+void br_ssl_engine_recvapp_ack(br_ssl_engine_context* cc, size_t len);
@@ -0,0 +1,190 @@
+#include "font_bench.h"
+#include "glyph_cache.h"
+#include "oled.h"
+#include "ui_fonts.h"
+#include <U8g2lib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+static constexpr int kRounds = 2000;
+static constexpr int kDrawRounds = 20000;
+static constexpr size_t kFrameBytes = 128 * 64 / 8;
+static constexpr uint32_t kLastCodePoint = 0x2fff; // highest glyph any subset could hold
+// Font header bytes 1..16: bbx mode, bit widths, max box, ascent/descent.
+// Byte 0 is the glyph count, 17..22 the offsets; both change with the subset.
+static constexpr size_t kFontMetricsFirst = 1;
+static constexpr size_t kFontMetricsEnd = 17;
+
+static uint64_t hostNs()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static double lookupNs(U8G2& g, const uint8_t* font, const std::vector<uint16_t>& glyphs)
+{
+  g.setFont(font);
+  u8g2_t* u = g.getU8g2();
+  uintptr_t sink = 0; // keeps the lookups from being optimised away
+  for (uint16_t e : glyphs)
+    sink += (uintptr_t)u8g2_font_get_glyph_data(u, e); // warm the caches
+  const uint64_t t0 = hostNs();
+  for (int r = 0; r < kRounds; r++)
+    for (uint16_t e : glyphs)
+      sink += (uintptr_t)u8g2_font_get_glyph_data(u, e);
+  const uint64_t ns = hostNs() - t0;
+  if (sink == 1)
+    printf(" ");
+  return glyphs.empty() ? 0.0 : (double)ns / kRounds / glyphs.size();
+}
+
+// Glyphs of sub whose record differs from src's, or that src lacks. The
+// glyph data pointer sits past the encoding and the record size byte.
+static unsigned differingGlyphs(U8G2& g, const uint8_t* sub, const uint8_t* src, const std::vector<uint16_t>& glyphs)
+{
+  unsigned bad = 0;
+  for (uint16_t e : glyphs)
+  {
+    g.setFont(sub);
+    const uint8_t* a = u8g2_font_get_glyph_data(g.getU8g2(), e);
+    g.setFont(src);
+    const uint8_t* b = u8g2_font_get_glyph_data(g.getU8g2(), e);
+    const uint8_t head = e <= 0xff ? 2 : 3;
+    if (!a || !b || a[-1] != b[-1] || a[-1] < head || memcmp(a, b, a[-1] - head) != 0)
+      bad++;
+  }
+  return bad;
+}
+
+static bool benchPair(U8G2& g, const char* name, const uint8_t* sub, const char* srcName, const uint8_t* src,
+                      unsigned subBytes, unsigned srcBytes, unsigned subGlyphs, unsigned srcGlyphs)
+{
+  std::vector<uint16_t> glyphs;
+  g.setFont(sub);
+  for (uint32_t e = 0x20; e <= kLastCodePoint; e++)
+    if (u8g2_font_get_glyph_data(g.getU8g2(), (uint16_t)e))
+      glyphs.push_back((uint16_t)e);
+
+  const double full = lookupNs(g, src, glyphs);
+  const double cut = lookupNs(g, sub, glyphs);
+  printf("%-18s %-28s %3u/%3u glyphs %5u/%5u bytes (-%4.1f%%)  lookup %6.1f -> %6.1f ns (x%.2f)\n", name,
+         srcName, subGlyphs, srcGlyphs, subBytes, srcBytes, 100.0 * (srcBytes - subBytes) / srcBytes, full, cut,
+         cut > 0 ? full / cut : 0.0);
+  bool ok = true;
+  if (glyphs.size() != subGlyphs)
+  {
+    printf("  %s: %u glyph(s) found, expected %u\n", name, (unsigned)glyphs.size(), subGlyphs);
+    ok = false;
+  }
+  if (memcmp(sub + kFontMetricsFirst, src + kFontMetricsFirst, kFontMetricsEnd - kFontMetricsFirst) != 0)
+  {
+    printf("  %s: font metrics differ from %s\n", name, srcName);
+    ok = false;
+  }
+  const unsigned bad = differingGlyphs(g, sub, src, glyphs);
+  if (bad)
+  {
+    printf("  %s: %u glyph record(s) differ from %s\n", name, bad, srcName);
+    ok = false;
+  }
+  return ok;
+}
+
+int runFontBench(Oled& oled)
+{
+  oled.init();
+  U8G2& g = oled.gfx();
+  int bad = 0;
+#define UI_FONT_BENCH(sub, src, subBytes, srcBytes, subGlyphs, srcGlyphs)                                          \
+  bad += !benchPair(g, #sub, sub, #src, src, subBytes, srcBytes, subGlyphs, srcGlyphs);
+  UI_FONT_SUBSETS(UI_FONT_BENCH)
+#undef UI_FONT_BENCH
+  oled.invalidate();
+  return bad ? 1 : 0;
+}
+
+// u8g2 draws with the full source font, as the firmware did before the
+// subsets and the cache; the cache draws with the subset now in use.
+struct GlyphCase
+{
+  const char* name;
+  const uint8_t* source;
+  const uint8_t* font;
+  bool utf8;
+  const char* text;
+};
+
+static const GlyphCase kGlyphCases[] = {
+    {"status_date", u8g2_font_6x12_tf, ui_font_6x12, false, "2026-10-17"},
+    {"status_time", u8g2_font_6x12_tf, ui_font_6x12, false, " 12:34:56"},
+    {"status_wifi", u8g2_font_6x12_tf, ui_font_6x12, false, "WiFi:asusyo24 -61dBm"},
+    {"ascii_utf8", u8g2_font_6x12_tf, ui_font_6x12, true, "The quick brown fox jumps"},
+    {"cyrillic_utf8", u8g2_font_6x12_t_cyrillic, ui_font_6x12_cyr, true,
+     "\xd0\xa1\xd1\x8a\xd0\xb5\xd1\x88\xd1\x8c \xd0\xb6\xd0\xb5 \xd0\xb5\xd1\x89\xd1\x91 "
+     "\xd1\x8d\xd1\x82\xd0\xb8\xd1\x85 \xd0\xbc\xd1\x8f\xd0\xb3\xd0\xba\xd0\xb8\xd1\x85"},
+};
+
+static int countGlyphs(const GlyphCase& c)
+{
+  int n = 0;
+  for (const char* p = c.text; *p; p++)
+    if (!c.utf8 || ((uint8_t)*p & 0xC0) != 0x80)
+      n++;
+  return n;
+}
+
+template <typename DrawFn>
+static double glyphsPerSec(U8G2& g, int glyphs, DrawFn draw)
+{
+  // same string at the same spot: the buffer stays the same after round one
+  g.clearBuffer();
+  const uint64_t t0 = hostNs();
+  for (int r = 0; r < kDrawRounds; r++)
+    draw();
+  const uint64_t ns = hostNs() - t0;
+  return ns ? (double)glyphs * kDrawRounds * 1e9 / (double)ns : 0.0;
+}
+
+int runGlyphBench(Oled& oled)
+{
+  oled.init();
+  U8G2& g = oled.gfx();
+  GlyphCache& cache = glyphCache();
+  static uint8_t plain[kFrameBytes];
+  int bad = 0;
+
+  printf("%-14s %6s %14s %14s %7s %s\n", "case", "glyphs", "u8g2 glyph/s", "cache glyph/s", "speedup", "diff px");
+  printf("%-14s %6s %14s %14s\n", "", "", "source font", "subset");
+  for (const GlyphCase& c : kGlyphCases)
+  {
+    const int n = countGlyphs(c);
+    auto drawPlain = [&]() { c.utf8 ? g.drawUTF8(0, 30, c.text) : g.drawStr(0, 30, c.text); };
+    auto drawCached = [&]() { c.utf8 ? cache.drawUTF8(g, 0, 30, c.text) : cache.drawStr(g, 0, 30, c.text); };
+
+    g.setFont(c.source);
+    g.clearBuffer();
+    drawPlain();
+    memcpy(plain, g.getBufferPtr(), kFrameBytes);
+    g.setFont(c.font);
+    g.clearBuffer();
+    drawCached();
+    int diff = 0;
+    for (size_t i = 0; i < kFrameBytes; i++)
+      diff += __builtin_popcount(plain[i] ^ g.getBufferPtr()[i]);
+    if (diff)
+      bad++;
+
+    g.setFont(c.source);
+    const double a = glyphsPerSec(g, n, drawPlain);
+    g.setFont(c.font);
+    const double b = glyphsPerSec(g, n, drawCached);
+    printf("%-14s %6d %14.0f %14.0f %6.2fx %d\n", c.name, n, a, b, a > 0 ? b / a : 0.0, diff);
+  }
+  printf("cache: %u hits, %u decodes, %u drawn by u8g2\n", (unsigned)cache.hits(), (unsigned)cache.misses(),
+         (unsigned)cache.fallbacks());
+  oled.invalidate();
+  return bad ? 1 : 0;
+}
@@ -0,0 +1,15 @@
+#pragma once
+class Oled;
+
+// Glyph lookup cost of each font subset (src/ui_fonts.h) against the full
+// font it was cut from: every glyph the subset keeps is looked up in both,
+// through u8g2's own u8g2_font_get_glyph_data(). Prints flash size and ns
+// per lookup for each pair. Returns 1 unless every kept glyph record and the
+// font metrics are byte-identical to the source font's.
+int runFontBench(Oled& oled);
+
+// Glyphs per second drawn by plain u8g2 drawStr()/drawUTF8() with the full
+// source font and by GlyphCache with its subset, on the status screen
+// strings and a Cyrillic paragraph, plus the number of pixels where the two
+// disagree (must be 0).
+int runGlyphBench(Oled& oled);
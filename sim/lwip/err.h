@@ -0,0 +1,11 @@
+#pragma once
+// Host stand-in for lwIP's error codes.
+#include <stdint.h>
+
+typedef int8_t err_t;
+#define ERR_OK 0
+#define ERR_MEM -1
+#define ERR_INPROGRESS -5
+#define ERR_ABRT -13
+#define ERR_RST -14
+#define ERR_ARG -16
@@ -0,0 +1,12 @@
+#pragma once
+// Host stand-in for lwIP's IPv4 address: network order, first octet in the
+// low byte, the same layout IPAddress uses.
+#include <Arduino.h>
+
+struct ip_addr
+{
+  uint32_t addr;
+};
+
+#define IP_ADDR4(ipaddr, a, b, c, d)                                                                              \
+  ((ipaddr)->addr = (uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
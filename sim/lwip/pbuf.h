@@ -0,0 +1,22 @@
+#pragma once
+// Host stand-in for lwIP's packet buffers: reference-counted chains, with
+// tot_len of each pbuf covering it and everything after it.
+#include "lwip/err.h"
+#include <stdint.h>
+
+struct pbuf
+{
+  pbuf* next;
+  void* payload;
+  uint16_t tot_len;
+  uint16_t len;
+  uint16_t ref;
+};
+
+// One pbuf holding a copy of len bytes (host only; lwIP has pbuf_alloc()).
+pbuf* simPbufFrom(const void* data, uint16_t len);
+
+void pbuf_ref(pbuf* p);
+uint8_t pbuf_free(pbuf* p);
+void pbuf_cat(pbuf* head, pbuf* tail);
+uint16_t pbuf_copy_partial(const pbuf* p, void* dataptr, uint16_t len, uint16_t offset);
@@ -0,0 +1,33 @@
+#pragma once
+// Host stand-in for lwIP's raw TCP API. The only server is the time API: a
+// SYN to its address on port 443 is answered after SimConfig::tcpRttMs, each
+// flight of the fake TLS handshake (see bearssl/bearssl.h) one round trip
+// later, and an HTTP GET gets a worldtimeapi.org style JSON body after
+// SimConfig::httpLatencyMs, delivered in MSS-sized segments and followed by
+// a FIN. SYNs to anything else, or while SimConfig::httpDown is set, are
+// never answered. Callbacks run from simRunEvents(), like lwIP's on the
+// device.
+#include "lwip/err.h"
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+
+struct tcp_pcb;
+
+typedef err_t (*tcp_connected_fn)(void* arg, tcp_pcb* tpcb, err_t err);
+typedef err_t (*tcp_recv_fn)(void* arg, tcp_pcb* tpcb, pbuf* p, err_t err);
+typedef void (*tcp_err_fn)(void* arg, err_t err);
+
+#define TCP_WRITE_FLAG_COPY 0x01
+
+tcp_pcb* tcp_new();
+void tcp_arg(tcp_pcb* pcb, void* arg);
+void tcp_recv(tcp_pcb* pcb, tcp_recv_fn recv);
+void tcp_err(tcp_pcb* pcb, tcp_err_fn err);
+void tcp_nagle_disable(tcp_pcb* pcb);
+err_t tcp_connect(tcp_pcb* pcb, const ip_addr_t* ipaddr, uint16_t port, tcp_connected_fn connected);
+uint16_t tcp_sndbuf(const tcp_pcb* pcb);
+err_t tcp_write(tcp_pcb* pcb, const void* dataptr, uint16_t len, uint8_t apiflags);
+err_t tcp_output(tcp_pcb* pcb);
+void tcp_recved(tcp_pcb* pcb, uint16_t len);
+err_t tcp_close(tcp_pcb* pcb);
+void tcp_abort(tcp_pcb* pcb);
@@ -0,0 +1,579 @@
+#include "render_suite.h"
+#include "frame_capture.h"
+#include "glyph_cache.h"
+#include "marquee.h"
+#include "oled.h"
+#include "oled_transport.h"
+#include "sim.h"
+#include "telemetry.h"
+#include "text_wrap.h"
+#include "ui_fonts.h"
+#include <U8g2lib.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+
+static constexpr int kTimingRuns = 200;
+static constexpr int kTicks = 3600; // seconds rendered by the tick runs
+static constexpr size_t kFrameBytes = 128 * 64 / 8;
+
+struct StatusCase
+{
+  const char* name;
+  UiStatus status;
+};
+
+struct TextCase
+{
+  const char* name;
+  const uint8_t* font;
+  int lineH;
+  const char* text;
+};
+
+static const StatusCase kStatusCases[] = {
+    {"status_connected", {"12:34:56", "2026-10-17", true, "asusyo24", -61}},
+    {"status_connecting", {"12:34:57", "2026-10-17", false, "asusyo24", 0}},
+    {"status_unsynced", {"--:--:--", "----------", false, "asusyo24", 0}},
+    {"status_null_fields", {nullptr, nullptr, true, nullptr, 0}},
+    {"status_long_ssid", {"23:59:59", "2026-12-31", true, "a-very-long-network-name-32-char", -88}},
+    {"status_rssi_range", {"00:00:00", "2027-01-01", true, "asusyo24", -100}},
+    {"status_rssi_zero", {"07:07:07", "2026-02-28", true, "x", 0}},
+    {"status_ticker", {"12:34:56", "2026-10-17", true, "asusyo24", -61, "SSID asusyo24  IP 192.168.1.23"}},
+};
+
+static const TextCase kTextCases[] = {
+    {"wrap_ascii", ui_font_6x12, 12,
+     "The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor jugs."},
+    {"wrap_long_word", ui_font_6x12, 12, "Supercalifragilisticexpialidocious-and-then-some-more-text ok"},
+    {"wrap_whitespace", ui_font_6x12, 12, "  leading,   runs of   spaces\tand\ttabs,\nnewline   end  "},
+    {"wrap_overflow", ui_font_6x12, 12,
+     "one two three four five six seven eight nine ten eleven twelve thirteen fourteen fifteen sixteen "
+     "seventeen eighteen nineteen twenty twenty-one twenty-two twenty-three twenty-four"},
+    {"wrap_cyrillic", ui_font_6x12_cyr, 12,
+     "\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82, \xd0\xbc\xd0\xb8\xd1\x80! "
+     "\xd0\xa1\xd1\x8a\xd0\xb5\xd1\x88\xd1\x8c \xd0\xb6\xd0\xb5 \xd0\xb5\xd1\x89\xd1\x91 "
+     "\xd1\x8d\xd1\x82\xd0\xb8\xd1\x85 \xd0\xbc\xd1\x8f\xd0\xb3\xd0\xba\xd0\xb8\xd1\x85 "
+     "\xd1\x84\xd1\x80\xd0\xb0\xd0\xbd\xd1\x86\xd1\x83\xd0\xb7\xd1\x81\xd0\xba\xd0\xb8\xd1\x85 "
+     "\xd0\xb1\xd1\x83\xd0\xbb\xd0\xbe\xd0\xba"},
+    {"wrap_empty", ui_font_6x12, 12, ""},
+};
+
+class FilePrint : public Print
+{
+public:
+  explicit FilePrint(FILE* f) : f_(f) {}
+  size_t write(uint8_t c) override { return fputc(c, f_) == EOF ? 0 : 1; }
+  size_t write(const uint8_t* buf, size_t n) override { return fwrite(buf, 1, n, f_); }
+
+private:
+  FILE* f_;
+};
+
+// Collects a PBM in memory so the comparison works on exactly the file bytes.
+class BufferPrint : public Print
+{
+public:
+  size_t write(uint8_t c) override
+  {
+    data.push_back((char)c);
+    return 1;
+  }
+  std::string data;
+};
+
+static uint64_t hostNs()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static bool readFile(const std::string& path, std::string& out)
+{
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f)
+    return false;
+  char buf[4096];
+  size_t n;
+  out.clear();
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    out.append(buf, n);
+  fclose(f);
+  return true;
+}
+
+static bool writeFile(const std::string& path, const std::string& data)
+{
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f)
+    return false;
+  FilePrint p(f);
+  p.write((const uint8_t*)data.data(), data.size());
+  return fclose(f) == 0;
+}
+
+// Differing pixels between two P4 images of the same header, -1 if not comparable.
+static int diffPbm(const std::string& a, const std::string& b)
+{
+  if (a.size() != b.size() || a.size() < kFrameBytes)
+    return -1;
+  const size_t body = a.size() - kFrameBytes;
+  if (a.compare(0, body, b, 0, body) != 0)
+    return -1;
+  int bits = 0;
+  for (size_t i = body; i < a.size(); i++)
+    bits += __builtin_popcount((uint8_t)(a[i] ^ b[i]));
+  return bits;
+}
+
+struct SuiteRun
+{
+  const char* dir;
+  bool update;
+  FILE* csv;
+  int failed;
+  int written;
+};
+
+// same: frame the case must reproduce exactly (the retained render), or null
+template <typename RenderFn>
+static void runCase(SuiteRun& run, Oled& oled, const char* name, RenderFn render, const std::string* same = nullptr)
+{
+  render();
+  BufferPrint pbm;
+  oled.capture(pbm);
+  if (same && diffPbm(*same, pbm.data) != 0)
+  {
+    printf("  %s: retained render differs from a full redraw by %d pixel(s)\n", name, diffPbm(*same, pbm.data));
+    run.failed++;
+  }
+
+  // time the same render; the buffer ends up identical each round
+  const uint64_t t0 = hostNs();
+  for (int i = 0; i < kTimingRuns; i++)
+    render();
+  const double us = (double)(hostNs() - t0) / kTimingRuns / 1000.0;
+
+  const std::string golden = std::string(run.dir) + "/" + name + ".pbm";
+  std::string expected;
+  const char* result;
+  if (run.update)
+  {
+    result = writeFile(golden, pbm.data) ? "written" : "write-failed";
+    run.written++;
+  }
+  else if (!readFile(golden, expected))
+  {
+    // a missing image is a failure, not a new baseline: --update-golden writes it
+    result = "MISSING";
+    run.failed++;
+    writeFile(std::string(run.dir) + "/" + name + ".actual.pbm", pbm.data);
+  }
+  else
+  {
+    const int diff = diffPbm(expected, pbm.data);
+    if (diff == 0)
+    {
+      result = "ok";
+    }
+    else
+    {
+      result = "MISMATCH";
+      run.failed++;
+      writeFile(std::string(run.dir) + "/" + name + ".actual.pbm", pbm.data);
+      printf("  %s: %d pixel(s) differ%s\n", name, diff, diff < 0 ? " (size/header)" : "");
+    }
+  }
+  printf("%-20s %9.2f us  %s\n", name, us, result);
+  if (run.csv)
+    fprintf(run.csv, "%s,%.3f,%s\n", name, us, result);
+}
+
+// Renders kTicks consecutive seconds incrementally, as the firmware does, and
+// checks the last frame against a full redraw of the same second.
+static void runTicks(SuiteRun& run, Oled& oled, const char* name)
+{
+  char hms[16];
+  UiStatus s{hms, "2026-10-17", true, "asusyo24", -61};
+  auto at = [&](int t) { snprintf(hms, sizeof(hms), "%02d:%02d:%02d", (12 + t / 3600) % 24, t / 60 % 60, t % 60); };
+
+  at(0);
+  oled.invalidate();
+  oled.render(s);
+  uint32_t redrawn = 0;
+  const uint64_t t0 = hostNs();
+  for (int t = 1; t <= kTicks; t++)
+  {
+    at(t);
+    redrawn += oled.render(s);
+  }
+  const double us = (double)(hostNs() - t0) / kTicks / 1000.0;
+
+  BufferPrint retained, full;
+  oled.capture(retained);
+  oled.invalidate();
+  oled.render(s);
+  oled.capture(full);
+  const int diff = diffPbm(full.data, retained.data);
+  if (diff != 0)
+    run.failed++;
+
+  char result[48];
+  snprintf(result, sizeof(result), "%s, %.2f redrawn/tick", diff == 0 ? "ok" : "MISMATCH", (double)redrawn / kTicks);
+  printf("%-20s %9.2f us  %s\n", name, us, result);
+  if (run.csv)
+    fprintf(run.csv, "%s,%.3f,%s\n", name, us, result);
+}
+
+// Sends kTicks consecutive seconds through drawStatus(), as the firmware
+// does, and reports the bytes and bus time per tick against the full frame
+// that an unconditional sendBuffer() would push; then what the bus recorder
+// saw on the wire for each (addressing and commands included).
+static void runTickBytes(SuiteRun& run, Oled& oled, const char* name)
+{
+  char hms[16];
+  UiStatus s{hms, "2026-10-17", true, "asusyo24", -61};
+  auto at = [&](int t) { snprintf(hms, sizeof(hms), "%02d:%02d:%02d", (12 + t / 3600) % 24, t / 60 % 60, t % 60); };
+
+  oled.setAsync(false);
+  at(0);
+  oled.invalidate();
+  const SimBusStats bus0 = simBus();
+  oled.drawStatus(s);
+  const SimBusStats bus1 = simBus();
+  const uint16_t fullBytes = oled.lastFrameBytes();
+  const uint32_t fullUs = oled.lastSendUs();
+  uint32_t bytes = 0, sendUs = 0;
+  uint16_t maxBytes = 0;
+  for (int t = 1; t <= kTicks; t++)
+  {
+    at(t);
+    oled.drawStatus(s);
+    bytes += oled.lastFrameBytes();
+    sendUs += oled.lastSendUs();
+    maxBytes = oled.lastFrameBytes() > maxBytes ? oled.lastFrameBytes() : maxBytes;
+  }
+  oled.setAsync(true);
+  const SimBusStats bus2 = simBus();
+
+  // the first frame after invalidate() is the full send, and a tick has to beat it
+  const bool ok = fullBytes == kFrameBytes && maxBytes < kFrameBytes;
+  if (!ok)
+    run.failed++;
+  char result[96];
+  snprintf(result, sizeof(result), "%s, %.1f B/tick (max %u) vs %u B full, %.1f%%; full send %u us", ok ? "ok" : "FAIL",
+           (double)bytes / kTicks, maxBytes, fullBytes, 100.0 * bytes / kTicks / kFrameBytes, fullUs);
+  const double us = (double)sendUs / kTicks;
+  printf("%-20s %9.2f us  %s\n", name, us, result);
+  printf("%-20s %12s  %s: wire %.1f B, %.0f cycles per tick; full frame %llu B, %llu cycles\n", "", "",
+         OledTransport::kName, (double)(bus2.bytes - bus1.bytes) / kTicks, (double)(bus2.cycles - bus1.cycles) / kTicks,
+         (unsigned long long)(bus1.bytes - bus0.bytes), (unsigned long long)(bus1.cycles - bus0.cycles));
+  if (run.csv)
+    fprintf(run.csv, "%s,%.3f,%s\n", name, us, result);
+}
+
+// The ticker keeps a frame on the bus most of the time, the way App pumps it:
+// a few slices per step, so a full frame spans several steps and the next
+// ticker frame is queued behind it. invalidate() in the middle of one, and
+// the redraw that follows it, have to cost a full frame, after which the
+// ticker is back to the tiles under its strip.
+static void runTickerInvalidate(SuiteRun& run, Oled& oled, const char* name)
+{
+  static constexpr int kPumpsPerStep = 8; // 32 tiles; a full frame is 128
+  static constexpr int kSteps = 60;
+  UiStatus s{"12:00:00", "2026-10-17", true, "asusyo24", -61,
+             "SSID a-very-long-network-name-32-char  IP 192.168.100.200"};
+
+  oled.invalidate();
+  oled.drawStatus(s);
+  while (oled.pump())
+  {
+  }
+
+  uint32_t nowMs = 0;
+  uint16_t fullFrames = 0;
+  auto step = [&]() {
+    nowMs += Marquee::kStepMs;
+    oled.animate(nowMs);
+    const uint32_t frames = oled.frames();
+    for (int i = 0; i < kPumpsPerStep && oled.pump(); i++)
+    {
+    }
+    if (oled.frames() != frames && oled.lastFrameBytes() == kFrameBytes)
+      fullFrames++;
+  };
+
+  for (int i = 0; i < kSteps; i++)
+    step();
+  const uint16_t before = oled.lastFrameBytes();
+  while (!oled.busy())
+    step();
+  fullFrames = 0;
+  oled.invalidate();
+  s.time_hms = "12:00:01"; // the ticker waits for the next UI frame
+  oled.drawStatus(s);
+  for (int i = 0; i < kSteps; i++)
+    step();
+  const uint16_t after = oled.lastFrameBytes();
+  while (oled.pump())
+  {
+  }
+
+  const bool ok = before < kFrameBytes / 4 && fullFrames == 1 && after < kFrameBytes / 4;
+  if (!ok)
+    run.failed++;
+  char result[112];
+  snprintf(result, sizeof(result), "%s, ticker frame %u B before, %u full frame(s), %u B after", ok ? "ok" : "FAIL",
+           before, fullFrames, after);
+  printf("%-20s %12s  %s\n", name, "", result);
+  if (run.csv)
+    fprintf(run.csv, "%s,,%s\n", name, result);
+}
+
+// The ticker's strip copy at a few scroll positions, including the wrap
+// through the gap, against drawing the text itself at the same offset; then
+// the golden and copy time of one position, and the one-off strip render.
+static void runTicker(SuiteRun& run, Oled& oled)
+{
+  static const char kText[] = "SSID a-very-long-network-name-32-char  IP 192.168.100.200";
+  static constexpr uint8_t kPage = 5;
+  U8G2& g = oled.gfx();
+  g.setFont(ui_font_6x12);
+  static Marquee m;
+  m.place(0, 128, kPage);
+
+  const uint64_t t0 = hostNs();
+  for (int i = 0; i < kTimingRuns; i++)
+  {
+    m.setText(g, "");
+    m.setText(g, kText);
+  }
+  const double renderUs = (double)(hostNs() - t0) / kTimingRuns / 2 / 1000.0;
+
+  const uint16_t period = m.width() + Marquee::kGap;
+  const u8g2_t* u = g.getU8g2();
+  const int baseline = kPage * 8 + u->font_info.max_char_height + u->font_info.y_offset;
+  const uint16_t offsets[] = {0, 1, 57, (uint16_t)(m.width() - 1), (uint16_t)(period - 5)};
+  uint32_t nowMs = 0;
+  m.advance(nowMs);
+  int bad = 0;
+  for (uint16_t off : offsets)
+  {
+    while (m.offset() != off)
+      m.advance(nowMs += Marquee::kStepMs);
+    BufferPrint copied, drawn;
+    g.clearBuffer();
+    m.draw(g);
+    oled.capture(copied);
+    g.clearBuffer();
+    g.setClipWindow(0, kPage * 8, 128, (kPage + Marquee::kPages) * 8);
+    glyphCache().drawUTF8(g, -off, baseline, kText);
+    glyphCache().drawUTF8(g, period - off, baseline, kText);
+    g.setMaxClipWindow();
+    oled.capture(drawn);
+    const int diff = diffPbm(drawn.data, copied.data);
+    if (diff != 0)
+    {
+      printf("  ticker at offset %u: %d pixel(s) differ from the drawn text\n", off, diff);
+      bad++;
+    }
+  }
+  run.failed += bad;
+
+  runCase(run, oled, "ticker_wrap", [&]() {
+    g.clearBuffer();
+    m.draw(g);
+  });
+
+  char result[48];
+  snprintf(result, sizeof(result), "%s, %u columns", bad ? "MISMATCH" : "ok", m.width());
+  printf("%-20s %9.2f us  %s\n", "ticker_set_text", renderUs, result);
+  if (run.csv)
+    fprintf(run.csv, "%s,%.3f,%s\n", "ticker_set_text", renderUs, result);
+}
+
+// A ticker short enough to fit its window stands still: the text once at the
+// left edge and blank to the right, over whatever was under the window.
+static void runTickerShort(SuiteRun& run, Oled& oled)
+{
+  static const char kText[] = "IP 10.0.0.7";
+  static constexpr uint8_t kPage = 5, kX = 8, kW = 112;
+  U8G2& g = oled.gfx();
+  g.setFont(ui_font_6x12);
+  static Marquee m;
+  m.place(kX, kW, kPage);
+  m.setText(g, kText);
+  m.advance(0);
+  m.advance(100 * Marquee::kStepMs); // must not move
+
+  const u8g2_t* u = g.getU8g2();
+  const int baseline = kPage * 8 + u->font_info.max_char_height + u->font_info.y_offset;
+  BufferPrint copied, drawn;
+  g.clearBuffer();
+  g.drawBox(0, 0, 128, 64);
+  m.draw(g);
+  oled.capture(copied);
+  g.drawBox(0, 0, 128, 64);
+  g.setDrawColor(0);
+  g.drawBox(kX, kPage * 8, kW, Marquee::kPages * 8);
+  g.setDrawColor(1);
+  g.setClipWindow(kX, kPage * 8, kX + kW, (kPage + Marquee::kPages) * 8);
+  glyphCache().drawUTF8(g, kX, baseline, kText);
+  g.setMaxClipWindow();
+  oled.capture(drawn);
+  const int diff = diffPbm(drawn.data, copied.data);
+  if (m.scrolling() || m.offset() != 0 || diff != 0)
+  {
+    printf("  short ticker: %s, offset %u, %d pixel(s) differ from the drawn text\n",
+           m.scrolling() ? "scrolling" : "still", m.offset(), diff);
+    run.failed++;
+  }
+
+  runCase(run, oled, "ticker_short", [&]() {
+    g.clearBuffer();
+    g.drawBox(0, 0, 128, 64);
+    m.draw(g);
+  });
+}
+
+// Text longer than Marquee::kMaxText is kept up to the last whole codepoint:
+// the strip holds and shows exactly the first kCutBytes bytes, and setting
+// the same text again is no change.
+static void runTickerCut(SuiteRun& run, Oled& oled)
+{
+  static const char kText[] = "Сеть: ПриветПриветПриветПриветПривет"; // byte 63 is inside "и"
+  static constexpr size_t kCutBytes = 62;
+  static constexpr uint8_t kPage = 5;
+  U8G2& g = oled.gfx();
+  g.setFont(ui_font_6x12_cyr);
+  static Marquee m;
+  m.place(0, 128, kPage);
+  m.setText(g, kText);
+  const bool again = m.setText(g, kText);
+  m.advance(0);
+
+  char cut[kCutBytes + 1];
+  memcpy(cut, kText, kCutBytes);
+  cut[kCutBytes] = '\0';
+  const u8g2_t* u = g.getU8g2();
+  const int baseline = kPage * 8 + u->font_info.max_char_height + u->font_info.y_offset;
+  BufferPrint copied, drawn;
+  g.clearBuffer();
+  m.draw(g);
+  oled.capture(copied);
+  g.clearBuffer();
+  g.setClipWindow(0, kPage * 8, 128, (kPage + Marquee::kPages) * 8);
+  const uint16_t advance = glyphCache().drawUTF8(g, 0, baseline, cut);
+  g.setMaxClipWindow();
+  oled.capture(drawn);
+  const int diff = diffPbm(drawn.data, copied.data);
+  const size_t kept = strlen(m.text());
+  const bool ok = kept == kCutBytes && !again && m.width() == advance && diff == 0;
+  if (!ok)
+    run.failed++;
+  char result[112];
+  snprintf(result, sizeof(result), "%s, %u bytes kept, %u columns, %d pixel(s) differ%s", ok ? "ok" : "FAIL",
+           (unsigned)kept, m.width(), diff, again ? ", re-rendered" : "");
+  printf("%-20s %12s  %s\n", "ticker_cut", "", result);
+  if (run.csv)
+    fprintf(run.csv, "%s,,%s\n", "ticker_cut", result);
+}
+
+// Sparklines of one synthetic series at every tier: 25 hours of a triangle
+// wave with a second-by-second wobble and a gap.
+static void runSparkline(SuiteRun& run, Oled& oled)
+{
+  static Telemetry tm;
+  for (uint32_t sec = 0; sec <= 25 * 3600; sec++)
+  {
+    const int32_t tri = (int32_t)(sec / 60 % 40);
+    const int32_t slow = (int32_t)(sec / 3600 % 12);
+    if (sec % 3600 < 3000 || sec > 24 * 3600)
+      for (int32_t k = 0; k < 3; k++)
+        tm.record(Telemetry::Rssi, -80 + (tri < 20 ? tri : 40 - tri) + slow + (int32_t)((sec * 7 + k * 3) % 5));
+    tm.tick(sec * 1000);
+  }
+
+  U8G2& g = oled.gfx();
+  runCase(run, oled, "sparkline_tiers", [&]() {
+    g.clearBuffer();
+    for (uint8_t t = 0; t < Telemetry::kTiers; t++)
+    {
+      const int y = t * 21;
+      g.drawFrame(0, y, 128, 20);
+      tm.drawSparkline(g, Telemetry::Rssi, (Telemetry::Tier)t, 1, y + 1, 126, 18);
+    }
+  });
+}
+
+int runRenderSuite(Oled& oled, const char* dir, bool update)
+{
+  oled.init();
+  U8G2& g = oled.gfx();
+
+  SuiteRun run{dir, update, nullptr, 0, 0};
+  run.csv = fopen((std::string(dir) + "/timings.csv").c_str(), "w");
+  if (run.csv)
+    fprintf(run.csv, "case,us_per_render,result\n");
+  printf("%-20s %12s  %s\n", "case", "render", "golden");
+
+  // Each screen is first reached incrementally from the previous one; that
+  // frame must match a full redraw, which is also what gets timed.
+  for (const StatusCase& c : kStatusCases)
+  {
+    oled.render(c.status);
+    BufferPrint retained;
+    oled.capture(retained);
+    runCase(
+        run, oled, c.name,
+        [&]() {
+          oled.invalidate();
+          oled.render(c.status);
+        },
+        &retained.data);
+  }
+
+  // the same inputs on the big-digit clock
+  oled.setScreen(Oled::Screen::Clock);
+  for (const StatusCase& c : kStatusCases)
+  {
+    const std::string name = std::string("clock") + strchr(c.name, '_');
+    oled.render(c.status);
+    BufferPrint retained;
+    oled.capture(retained);
+    runCase(
+        run, oled, name.c_str(),
+        [&]() {
+          oled.invalidate();
+          oled.render(c.status);
+        },
+        &retained.data);
+  }
+  runTicks(run, oled, "clock_tick");
+  runTickBytes(run, oled, "clock_tick_send");
+  oled.setScreen(Oled::Screen::Status);
+  runTicks(run, oled, "status_tick");
+  runTickBytes(run, oled, "status_tick_send");
+  runTickerInvalidate(run, oled, "ticker_invalidate");
+
+  for (const TextCase& c : kTextCases)
+  {
+    runCase(run, oled, c.name, [&]() {
+      g.clearBuffer();
+      g.setFont(c.font);
+      drawWrappedUTF8(g, 0, c.lineH - 2, 128, 64, c.lineH, c.text);
+    });
+  }
+  runTicker(run, oled);
+  runTickerShort(run, oled);
+  runTickerCut(run, oled);
+  runSparkline(run, oled);
+  oled.invalidate(); // the status widgets no longer match the buffer
+
+  if (run.csv)
+    fclose(run.csv);
+  printf("%d case(s) failed, %d golden image(s) written to %s\n", run.failed, run.written, dir);
+  return run.failed ? 1 : 0;
+}
@@ -0,0 +1,11 @@
+#pragma once
+class Oled;
+
+// Renders a fixed set of UiStatus inputs on the status and clock screens,
+// wrapped UTF-8 texts, the scrolling ticker and telemetry sparklines. Each
+// frame is compared with <dir>/<case>.pbm. A missing golden image, or update = true,
+// writes a new one. A mismatch writes <case>.actual.pbm next to it. The
+// render time of every case goes to stdout and <dir>/timings.csv, along with
+// the per-tick cost of an hour of seconds on each screen.
+// Returns non-zero if any case differs.
+int runRenderSuite(Oled& oled, const char* dir, bool update);
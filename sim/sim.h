@@ -0,0 +1,84 @@
+#pragma once
+#include <stdint.h>
+
+// Host simulation controls for env:native.
+//
+// The Arduino/ESP8266 stand-ins in this directory run on a virtual clock:
+// delay(), delayMicroseconds() and yield() move it forward instead of
+// sleeping, so days of App::loop() take seconds. WiFi, DNS, the time API and
+// the NTP servers are scripted from SimConfig and answer with the reference
+// UTC below, seen through a device crystal that is off by driftPpm.
+struct SimConfig
+{
+  int32_t driftPpm = 40;           // device millis() runs this much fast (+) or slow (-)
+  int64_t startUtcMs = 1790000000000LL;
+  int32_t utcOffsetSec = 3 * 3600; // what the time API reports
+
+  uint32_t joinFastMs = 250;  // directed join, BSSID and channel known
+  uint32_t joinScanMs = 1800; // full scan + auth
+  uint32_t dhcpMs = 600;
+  uint32_t dropEveryS = 0; // scripted AP outage period, 0 = never
+  uint32_t dropForS = 20;
+
+  uint32_t dnsMs = 30;
+  uint32_t tcpRttMs = 60;      // SYN to SYN-ACK
+  uint32_t httpLatencyMs = 150;
+  uint32_t httpFailPct = 0;    // share of time API requests answered with 503
+  bool httpDown = false;       // time API never answers a SYN
+  const char* httpBody = nullptr; // replaces the time API's JSON body
+  uint32_t tlsKeyExchangeMs = 600; // device CPU in BearSSL's key exchange, one call (estimate, 80 MHz)
+  bool tlsAlert = false;           // time API refuses the TLS handshake
+  uint32_t ntpLatencyMs = 40;  // one way is half, plus up to ntpJitterMs
+  uint32_t ntpJitterMs = 10;
+  uint32_t ntpServerMs[3] = {0, 0, 0}; // extra one-way latency of n.pool.ntp.org, each way
+
+  uint32_t resetReason = 0; // rst_reason from ESP.getResetInfoPtr(), 0 = power on
+  bool echoSerial = false;
+};
+
+SimConfig& simConfig();
+
+// Device time since boot, what millis()/micros() read.
+uint64_t simDeviceUs();
+// Reference UTC that the fake servers answer with.
+int64_t simTrueUtcMs();
+// The same at an earlier device time (simDeviceUs() units).
+int64_t simTrueUtcMsAt(uint64_t deviceUs);
+// Moves virtual time forward without running any events.
+void simAdvanceUs(uint64_t us);
+// Runs due WiFi, DNS and TCP events; called from delay() and yield(), where the
+// SDK would run them on the device.
+void simRunEvents();
+
+// Station state reads so far (status, RSSI, SSID, local IP, station config).
+uint32_t simWifiQueries();
+
+// What went over the display bus so far, recorded at the Wire and SPI
+// stand-ins or decoded from the SCL/SDA writes of the bit-banged driver.
+struct SimBusStats
+{
+  uint64_t bytes;        // on the wire: I2C address and control bytes, commands and pixel data
+  uint64_t cycles;       // bus clock cycles, I2C ACK and START/STOP included
+  uint32_t transactions; // I2C START..STOP, SPI beginTransaction()
+};
+const SimBusStats& simBus();
+
+// The last request each fake NTP server (n.pool.ntp.org) answered: the
+// one-way latencies it drew and the reference UTC it stamped.
+struct SimNtpExchange
+{
+  uint32_t answered; // requests so far
+  uint32_t upMs;
+  uint32_t downMs;
+  int64_t serverUtcMs;
+};
+const SimNtpExchange& simNtpExchange(uint8_t server);
+
+// Deterministic PRNG behind RANDOM_REG32 and the scripted jitter.
+uint32_t simRandom();
+
+// Internal hooks between the stand-ins
+void simWifiPump(uint64_t nowUs);
+void simDnsPump(uint64_t nowUs);
+void simTcpPump(uint64_t nowUs);
+bool simWifiUp();
@@ -0,0 +1,229 @@
+#include "oled_transport.h"
+#include "sim.h"
+#include <Arduino.h>
+#include <SPI.h>
+#include <Wire.h>
+#include <user_interface.h>
+
+static SimConfig config;
+static uint64_t deviceUs = 0;
+static uint32_t rngState = 0x2545F491UL;
+static SimBusStats bus;
+
+// Each yield() is a pass through the SDK, not free on the device either.
+static constexpr uint64_t kYieldUs = 20;
+
+HardwareSerial Serial;
+EspClass ESP;
+SPIClass SPI;
+TwoWire Wire;
+
+SimConfig& simConfig() { return config; }
+uint64_t simDeviceUs() { return deviceUs; }
+const SimBusStats& simBus() { return bus; }
+void simAdvanceUs(uint64_t us) { deviceUs += us; }
+
+int64_t simTrueUtcMs() { return simTrueUtcMsAt(deviceUs); }
+
+int64_t simTrueUtcMsAt(uint64_t us)
+{
+  // a crystal driftPpm fast counts 1e6 + driftPpm device us per true 1e6 us
+  const int64_t trueUs = (int64_t)us * 1000000 / (1000000 + config.driftPpm);
+  return config.startUtcMs + trueUs / 1000;
+}
+
+void simRunEvents()
+{
+  simWifiPump(deviceUs);
+  simDnsPump(deviceUs);
+  simTcpPump(deviceUs);
+}
+
+uint32_t simRandom()
+{
+  // xorshift32
+  uint32_t x = rngState;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  rngState = x;
+  return x;
+}
+
+// ---- time ----
+
+unsigned long millis() { return (unsigned long)(uint32_t)(deviceUs / 1000); }
+unsigned long micros() { return (unsigned long)(uint32_t)deviceUs; }
+
+void delay(unsigned long ms)
+{
+  deviceUs += (uint64_t)ms * 1000;
+  simRunEvents();
+}
+
+void delayMicroseconds(unsigned int us) { deviceUs += us; }
+
+void yield()
+{
+  deviceUs += kYieldUs;
+  simRunEvents();
+}
+
+// ---- GPIO (display bit-banging lands here) ----
+
+// Software I2C decoder on the display's pins: SDA falling while SCL is high
+// is a START, rising a STOP; every SCL rise clocks one bit, nine to a byte
+// with the ACK.
+struct I2cDecoder
+{
+  bool scl = true;
+  bool sda = true;
+  bool open = false;
+  uint8_t bits = 0;
+
+  void set(uint8_t pin, bool level)
+  {
+#if OLED_TRANSPORT == OLED_TRANSPORT_SW_I2C
+    if (pin == OLED_PIN_SCL && level != scl)
+    {
+      scl = level;
+      if (!scl)
+        return;
+      bus.cycles++;
+      if (open && ++bits == 9)
+      {
+        bits = 0;
+        bus.bytes++;
+      }
+    }
+    else if (pin == OLED_PIN_SDA && level != sda)
+    {
+      sda = level;
+      if (!scl)
+        return;
+      if (!sda)
+      {
+        bus.transactions++;
+        bus.cycles++; // START and STOP take about a clock each
+        open = true;
+        bits = 0;
+      }
+      else if (open)
+      {
+        bus.cycles++;
+        open = false;
+      }
+    }
+#else
+    (void)pin;
+    (void)level;
+#endif
+  }
+};
+static I2cDecoder swI2c;
+
+// u8g2 drives the lines push-pull, but open-drain style (input = released) is decoded too
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  if (mode != OUTPUT)
+    swI2c.set(pin, true);
+}
+void digitalWrite(uint8_t pin, uint8_t val) { swI2c.set(pin, val != LOW); }
+int digitalRead(uint8_t) { return HIGH; } // no clock stretching, ACK always read as released
+
+// ---- Serial ----
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  if (config.echoSerial)
+    fputc(c, stdout);
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t n)
+{
+  if (config.echoSerial)
+    fwrite(buf, 1, n, stdout);
+  return n;
+}
+
+// ---- ESP ----
+
+static uint32_t rtcMemory[128]; // 512 bytes of RTC user memory
+static rst_info resetInfo;
+
+uint32_t EspClass::getCycleCount() { return (uint32_t)(deviceUs * getCpuFreqMHz()); }
+uint32_t EspClass::getFreeHeap() { return 40000; }
+uint32_t EspClass::getMaxFreeBlockSize() { return 32000; }
+uint8_t EspClass::getHeapFragmentation() { return 20; }
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size)
+{
+  if (offset * 4 + size > sizeof(rtcMemory) || (size & 3))
+    return false;
+  memcpy(data, rtcMemory + offset, size);
+  return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size)
+{
+  if (offset * 4 + size > sizeof(rtcMemory) || (size & 3))
+    return false;
+  memcpy(rtcMemory + offset, data, size);
+  return true;
+}
+
+rst_info* EspClass::getResetInfoPtr()
+{
+  resetInfo.reason = config.resetReason;
+  return &resetInfo;
+}
+
+// ---- display buses ----
+
+void SPIClass::beginTransaction(SPISettings s)
+{
+  clock_ = s.clock ? s.clock : 1000000;
+  bus.transactions++;
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+  transfer(&data, 1);
+  return data;
+}
+
+void SPIClass::transfer(void*, size_t n)
+{
+  bus.bytes += n;
+  bus.cycles += (uint64_t)n * 8;
+  deviceUs += (uint64_t)n * 8000000ULL / clock_;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+  // START, then the address byte and its ACK
+  (void)address;
+  bus.transactions++;
+  bus.bytes++;
+  bus.cycles += 10;
+  deviceUs += 10000000ULL / clock_;
+}
+
+size_t TwoWire::write(uint8_t data) { return write(&data, 1); }
+
+size_t TwoWire::write(const uint8_t* data, size_t n)
+{
+  (void)data;
+  bus.bytes += n;
+  bus.cycles += (uint64_t)n * 9;
+  deviceUs += (uint64_t)n * 9000000ULL / clock_;
+  return n;
+}
+
+uint8_t TwoWire::endTransmission(bool)
+{
+  bus.cycles++; // STOP
+  deviceUs += 1000000ULL / clock_;
+  return 0;
+}
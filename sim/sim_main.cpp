@@ -0,0 +1,264 @@
+// env:native entry point: runs the real App on the virtual clock.
+//
+//   pio run -e native && .pio/build/native/program --days 3 --drift-ppm 60 --drop-every 7200
+//
+// Prints what the firmware would print (with --verbose), then a summary of
+// per-frame CPU time, display traffic and clock error against the reference.
+// Exits with 1 if the displayed clock was ever further than
+// ClockDiscipline::kMaxErrorMs from the reference once synced, or if a UI
+// frame showed anything but the second after the previous one.
+//
+//   .pio/build/native/program --render-suite sim/golden [--update-golden]
+//
+// renders the screen/text cases of render_suite.cpp against golden images
+// instead of running the firmware. sim/golden holds the committed images; a
+// missing one fails its case unless --update-golden is given.
+//
+//   .pio/build/native/program --font-bench
+//   .pio/build/native/program --glyph-bench
+//
+// compare glyph lookups in the font subsets with their full source fonts, and
+// text drawing through GlyphCache with plain u8g2.
+#include "app.h"
+#include "font_bench.h"
+#include "oled_transport.h"
+#include "profiler.h"
+#include "render_suite.h"
+#include "sim.h"
+#include "telemetry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <user_interface.h>
+
+// pio test -e native links sim/ too and brings its own main()
+#ifndef PIO_UNIT_TESTING
+
+static App app;
+static const char* renderDir = nullptr;
+static bool updateGolden = false;
+static bool fontBench = false;
+static bool glyphBench = false;
+
+static uint64_t hostNs()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(const char* argv0)
+{
+  printf("usage: %s [--days N] [--drift-ppm P] [--drop-every S] [--drop-for S] [--http-fail PCT]\n"
+         "          [--ntp-latency MS] [--warm-boot] [--verbose]\n"
+         "       %s --render-suite DIR [--update-golden]\n"
+         "       %s --font-bench | --glyph-bench\n",
+         argv0, argv0, argv0);
+}
+
+static bool parseArgs(int argc, char** argv, double& days)
+{
+  SimConfig& c = simConfig();
+  for (int i = 1; i < argc; i++)
+  {
+    const char* a = argv[i];
+    const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(a, "--verbose") == 0)
+      c.echoSerial = true;
+    else if (strcmp(a, "--warm-boot") == 0)
+      c.resetReason = REASON_SOFT_RESTART;
+    else if (strcmp(a, "--update-golden") == 0)
+      updateGolden = true;
+    else if (strcmp(a, "--font-bench") == 0)
+      fontBench = true;
+    else if (strcmp(a, "--glyph-bench") == 0)
+      glyphBench = true;
+    else if (!v)
+      return false;
+    else if (strcmp(a, "--days") == 0)
+      days = atof(v), i++;
+    else if (strcmp(a, "--drift-ppm") == 0)
+      c.driftPpm = atoi(v), i++;
+    else if (strcmp(a, "--drop-every") == 0)
+      c.dropEveryS = (uint32_t)atoi(v), i++;
+    else if (strcmp(a, "--drop-for") == 0)
+      c.dropForS = (uint32_t)atoi(v), i++;
+    else if (strcmp(a, "--http-fail") == 0)
+      c.httpFailPct = (uint32_t)atoi(v), i++;
+    else if (strcmp(a, "--render-suite") == 0)
+      renderDir = v, i++;
+    else if (strcmp(a, "--ntp-latency") == 0)
+      c.ntpLatencyMs = (uint32_t)atoi(v), i++;
+    else
+      return false;
+  }
+  return days > 0;
+}
+
+int main(int argc, char** argv)
+{
+  double days = 1.0;
+  if (!parseArgs(argc, argv, days))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+  if (renderDir)
+    return runRenderSuite(app.oled, renderDir, updateGolden);
+  if (fontBench)
+    return runFontBench(app.oled);
+  if (glyphBench)
+    return runGlyphBench(app.oled);
+
+  const SimConfig& cfg = simConfig();
+  const uint64_t endUs = (uint64_t)(days * 86400.0 * 1e6);
+
+  const uint64_t t0 = hostNs();
+  app.setup();
+
+  uint64_t loops = 0;
+  uint64_t frameNs = 0, frameNsMax = 0, sendUs = 0;
+  uint32_t frames = app.oled.frames();
+  uint32_t tickerFrames = app.oled.tickerFrames();
+  uint64_t tickerNs = 0, tickerNsMax = 0;
+  int64_t errMaxMs = 0, errSumMs = 0;
+  uint32_t errSamples = 0;
+  uint32_t uiSeq = app.uiFrame().seq;
+  int64_t shownSec = -1;
+  uint32_t secSkips = 0, secRepeats = 0, badText = 0;
+  while (simDeviceUs() < endUs)
+  {
+    const uint64_t l0 = hostNs();
+    app.loop();
+    const uint64_t ns = hostNs() - l0;
+    loops++;
+
+    // a ticker step: strip copy and the start of its frame
+    if (app.oled.tickerFrames() != tickerFrames)
+    {
+      tickerFrames = app.oled.tickerFrames();
+      tickerNs += ns;
+      if (ns > tickerNsMax)
+        tickerNsMax = ns;
+    }
+
+    // Every UI frame, once it has a time to show: the second in it has to
+    // be the one after the last frame's, its text has to say so, and the
+    // clock it was read from is checked against the reference at that
+    // moment. In UTC: a zone offset still missing because the time API
+    // failed (or arriving late) is neither clock error nor a skip.
+    const App::UiFrame& f = app.uiFrame();
+    if (f.seq != uiSeq)
+    {
+      uiSeq = f.seq;
+      if (f.sec >= 0)
+      {
+        const uint64_t atUs = simDeviceUs() - (uint32_t)(micros() - f.atUs);
+        int64_t err = f.utcMs - simTrueUtcMsAt(atUs);
+        if (err < 0)
+          err = -err;
+        if (err > errMaxMs)
+          errMaxMs = err;
+        errSumMs += err;
+        errSamples++;
+
+        const uint32_t sod = (uint32_t)(f.sec % 86400);
+        char want[16];
+        snprintf(want, sizeof(want), "%02u:%02u:%02u", sod / 3600, sod / 60 % 60, sod % 60);
+        if (strcmp(want, f.time) != 0)
+          badText++;
+
+        const int64_t sec = f.utcMs / 1000;
+        if (shownSec >= 0)
+        {
+          if (sec == shownSec)
+            secRepeats++;
+          else if (sec != shownSec + 1)
+            secSkips++;
+        }
+        shownSec = sec;
+      }
+    }
+
+    if (app.oled.frames() == frames)
+      continue;
+    frames = app.oled.frames();
+    sendUs += app.oled.lastSendUs();
+    frameNs += ns;
+    if (ns > frameNsMax)
+      frameNsMax = ns;
+  }
+  const double hostS = (double)(hostNs() - t0) / 1e9;
+
+  const uint32_t n = app.oled.frames();
+  printf("\n==== sim: %.2f days in %.2f s host time (%.0fx), %llu loop passes\n", days, hostS,
+         days * 86400.0 / (hostS > 0 ? hostS : 1e-9), (unsigned long long)loops);
+  printf("frames            %u\n", n);
+  if (n)
+  {
+    printf("cpu per frame     avg %.1f us, max %.1f us (host)\n", (double)frameNs / n / 1000.0,
+           (double)frameNsMax / 1000.0);
+    printf("display bytes     %llu total, %.1f per frame, last frame %u\n",
+           (unsigned long long)app.oled.totalBytes(), (double)app.oled.totalBytes() / n, app.oled.lastFrameBytes());
+    printf("display send      %.1f us per frame (virtual bus time)\n", (double)sendUs / n);
+    printf("display bus       %s: %.1f bytes, %.0f clock cycles per frame on the wire, %.1f transactions\n",
+           OledTransport::kName, (double)simBus().bytes / n, (double)simBus().cycles / n,
+           (double)simBus().transactions / n);
+    printf("display latency   last %u us, max %u us; longest blocking slice %u us\n", app.oled.lastLatencyUs(),
+           app.oled.maxLatencyUs(), app.oled.maxSliceUs());
+    printf("widgets redrawn   %.2f per drawn frame, %u frame(s) skipped unchanged\n",
+           (double)app.oled.totalWidgets() / n, app.oled.skippedFrames());
+  }
+  if (tickerFrames)
+  {
+    const double simS = days * 86400.0;
+    printf("ticker            %.1f steps/s, %.1f frames/s reached the panel; cpu per step avg %.2f us, max %.1f us "
+           "(host)\n",
+           tickerFrames / simS, n / simS, (double)tickerNs / tickerFrames / 1000.0, (double)tickerNsMax / 1000.0);
+  }
+  printf("clock error       avg %.1f ms, max %lld ms over %u frames, drift estimate %ld ppb (true %ld)\n",
+         errSamples ? (double)errSumMs / errSamples : 0.0, (long long)errMaxMs, errSamples,
+         (long)app.timeMgr.clock().driftPpb(), -(long)cfg.driftPpm * 1000);
+  printf("seconds shown     %u skipped, %u repeated, %u with the wrong text; ui woke early %u time(s), "
+         "counted %u skipped\n",
+         secSkips, secRepeats, badText, app.uiEarly(), app.uiSkipped());
+  printf("wifi              last connect %u ms (%s), %.2f station state reads/s, snapshot seq %u\n",
+         app.wifi.lastConnectMs(), app.wifi.lastConnectFast() ? "fast" : "full", simWifiQueries() / (days * 86400.0),
+         app.wifi.seq());
+  // telemetry: the hourly points of the last day folded once more
+  const Telemetry& tm = telemetry();
+  for (uint8_t s = 0; s < Telemetry::kSeries; s++)
+  {
+    const Telemetry::Series series = (Telemetry::Series)s;
+    int32_t lo = INT32_MAX, hi = INT32_MIN;
+    int64_t sum = 0;
+    uint32_t hours = 0;
+    for (uint8_t age = 0; age < tm.count(Telemetry::Hours); age++)
+    {
+      const Telemetry::Point p = tm.at(series, Telemetry::Hours, age);
+      if (p.empty())
+        continue;
+      lo = lo < Telemetry::scale(series, p.min) ? lo : Telemetry::scale(series, p.min);
+      hi = hi > Telemetry::scale(series, p.max) ? hi : Telemetry::scale(series, p.max);
+      sum += Telemetry::scale(series, p.avg);
+      hours++;
+    }
+    if (hours)
+      printf("telemetry %-7s min %ld, mean of hours %ld, max %ld (%u h with samples)\n", Telemetry::name(series),
+             (long)lo, (long)(sum / hours), (long)hi, hours);
+  }
+
+  simConfig().echoSerial = true;
+  Profiler::dump(Serial);
+
+  const bool errOk = errMaxMs <= (int64_t)ClockDiscipline::kMaxErrorMs;
+  if (!errOk)
+    printf("FAIL: clock error %lld ms exceeds %u ms\n", (long long)errMaxMs, ClockDiscipline::kMaxErrorMs);
+  const bool secOk = !secSkips && !secRepeats && !badText && !app.uiEarly() && !app.uiSkipped();
+  if (!secOk)
+    printf("FAIL: %u second(s) skipped, %u repeated, %u misformatted; ui woke early %u time(s), skipped %u\n",
+           secSkips, secRepeats, badText, app.uiEarly(), app.uiSkipped());
+  return errOk && secOk ? 0 : 1;
+}
+#endif
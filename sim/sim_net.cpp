@@ -0,0 +1,489 @@
+#include "sim.h"
+#include <ESP8266WiFi.h>
+#include <algorithm>
+#include <bearssl/bearssl.h>
+#include <lwip/dns.h>
+#include <lwip/tcp.h>
+#include <time.h>
+#include <vector>
+
+// Hosts the firmware talks to and the addresses the fake resolver gives them
+struct SimHost
+{
+  const char* name;
+  IPAddress ip;
+};
+static const SimHost kHosts[] = {
+    {"worldtimeapi.org", IPAddress(213, 188, 196, 246)},
+    {"0.pool.ntp.org", IPAddress(162, 159, 200, 1)},
+    {"1.pool.ntp.org", IPAddress(195, 13, 1, 153)},
+    {"2.pool.ntp.org", IPAddress(91, 206, 8, 34)},
+};
+static constexpr size_t kHostCount = sizeof(kHosts) / sizeof(kHosts[0]);
+static constexpr size_t kTimeApiHost = 0;
+static constexpr uint64_t kDnsTtlUs = 300ULL * 1000000;
+static constexpr uint32_t kNtpToUnix = 2208988800UL;
+
+IPAddress::IPAddress(const ip_addr_t* ip) : addr_(ip ? ip->addr : 0) {}
+
+static int hostIndex(const char* name)
+{
+  for (size_t i = 0; i < kHostCount; i++)
+  {
+    if (strcmp(kHosts[i].name, name) == 0)
+      return (int)i;
+  }
+  return -1;
+}
+
+static constexpr size_t kFirstNtpHost = 1;
+
+// 0..2 for n.pool.ntp.org, -1 for anything else
+static int ntpServerIndex(IPAddress ip)
+{
+  for (size_t i = kFirstNtpHost; i < kHostCount; i++)
+  {
+    if ((uint32_t)kHosts[i].ip == (uint32_t)ip)
+      return (int)(i - kFirstNtpHost);
+  }
+  return -1;
+}
+
+// ---- DNS ----
+
+struct DnsQuery
+{
+  bool busy;
+  int host;
+  uint64_t atUs;
+  dns_found_callback found;
+  void* arg;
+};
+static DnsQuery queries[4];
+static uint64_t cachedUntilUs[kHostCount];
+
+err_t dns_gethostbyname(const char* hostname, ip_addr_t* addr, dns_found_callback found, void* arg)
+{
+  const int h = hostIndex(hostname);
+  const uint64_t now = simDeviceUs();
+  if (h >= 0 && now < cachedUntilUs[h])
+  {
+    addr->addr = (uint32_t)kHosts[h].ip;
+    return ERR_OK;
+  }
+  for (DnsQuery& q : queries)
+  {
+    if (q.busy)
+      continue;
+    // unknown names and queries without a link time out quietly, like a lost packet
+    q = DnsQuery{true, h, now + (uint64_t)simConfig().dnsMs * 1000, found, arg};
+    return ERR_INPROGRESS;
+  }
+  return ERR_ARG;
+}
+
+void simDnsPump(uint64_t nowUs)
+{
+  for (DnsQuery& q : queries)
+  {
+    if (!q.busy || nowUs < q.atUs)
+      continue;
+    if (q.host < 0 || !simWifiUp())
+    {
+      // dropped; keep the slot a while as a stand-in for the retransmit timer
+      if (nowUs - q.atUs > 5000000)
+        q.busy = false;
+      continue;
+    }
+    q.busy = false;
+    cachedUntilUs[q.host] = nowUs + kDnsTtlUs;
+    ip_addr_t a{(uint32_t)kHosts[q.host].ip};
+    q.found(kHosts[q.host].name, &a, q.arg);
+  }
+}
+
+// ---- pbufs ----
+
+pbuf* simPbufFrom(const void* data, uint16_t len)
+{
+  pbuf* p = (pbuf*)malloc(sizeof(pbuf) + len);
+  p->next = nullptr;
+  p->payload = p + 1;
+  p->tot_len = len;
+  p->len = len;
+  p->ref = 1;
+  memcpy(p->payload, data, len);
+  return p;
+}
+
+void pbuf_ref(pbuf* p)
+{
+  if (p)
+    p->ref++;
+}
+
+uint8_t pbuf_free(pbuf* p)
+{
+  // like lwIP: drop one reference and keep walking the chain while that frees
+  uint8_t freed = 0;
+  while (p && --p->ref == 0)
+  {
+    pbuf* next = p->next;
+    free(p);
+    freed++;
+    p = next;
+  }
+  return freed;
+}
+
+void pbuf_cat(pbuf* head, pbuf* tail)
+{
+  pbuf* p = head;
+  for (; p->next; p = p->next)
+    p->tot_len += tail->tot_len;
+  p->tot_len += tail->tot_len;
+  p->next = tail;
+}
+
+uint16_t pbuf_copy_partial(const pbuf* p, void* dataptr, uint16_t len, uint16_t offset)
+{
+  uint16_t copied = 0;
+  for (; p && copied < len; p = p->next)
+  {
+    if (offset >= p->len)
+    {
+      offset -= p->len;
+      continue;
+    }
+    const uint16_t n = std::min<uint16_t>(p->len - offset, len - copied);
+    memcpy((uint8_t*)dataptr + copied, (const uint8_t*)p->payload + offset, n);
+    copied += n;
+    offset = 0;
+  }
+  return copied;
+}
+
+// ---- TCP + HTTP (time API) ----
+
+static constexpr uint16_t kMss = 536;
+static constexpr uint16_t kWnd = 4 * kMss;
+static constexpr uint16_t kSndBuf = 2 * kMss;
+static constexpr size_t kCertChainBytes = 2900; // the server's TLS flight, certificates mostly
+
+struct tcp_pcb
+{
+  enum class St : uint8_t
+  {
+    Idle,
+    SynSent,
+    Open,
+    Closed,
+  } st = St::Idle;
+  void* arg = nullptr;
+  tcp_connected_fn connected = nullptr;
+  tcp_recv_fn recv = nullptr;
+  tcp_err_fn err = nullptr;
+  bool reachable = false; // SYN goes to the time API while it is up
+  uint64_t atUs = 0;      // SYN-ACK due
+  std::string request;
+  size_t served = 0; // request bytes answered
+  uint8_t tlsFlights = 0;
+  bool answered = false; // HTTP response queued, FIN after it
+  std::string response;
+  uint64_t readyAtUs = 0;
+  size_t sent = 0;
+  uint16_t wnd = kWnd; // what the receiver still accepts
+  bool finSent = false;
+};
+
+static std::vector<tcp_pcb*> pcbs;
+
+static void dropPcb(tcp_pcb* pcb)
+{
+  pcbs.erase(std::remove(pcbs.begin(), pcbs.end(), pcb), pcbs.end());
+  delete pcb;
+}
+
+tcp_pcb* tcp_new()
+{
+  pcbs.push_back(new tcp_pcb);
+  return pcbs.back();
+}
+
+void tcp_arg(tcp_pcb* pcb, void* arg) { pcb->arg = arg; }
+void tcp_recv(tcp_pcb* pcb, tcp_recv_fn recv) { pcb->recv = recv; }
+void tcp_err(tcp_pcb* pcb, tcp_err_fn err) { pcb->err = err; }
+void tcp_nagle_disable(tcp_pcb*) {}
+
+err_t tcp_connect(tcp_pcb* pcb, const ip_addr_t* ipaddr, uint16_t port, tcp_connected_fn connected)
+{
+  if (pcb->st != tcp_pcb::St::Idle)
+    return ERR_ARG;
+  // unanswered SYNs just stay pending; the caller's timeout gives up on them
+  pcb->reachable = ipaddr->addr == (uint32_t)kHosts[kTimeApiHost].ip && port == 443;
+  pcb->connected = connected;
+  pcb->atUs = simDeviceUs() + (uint64_t)simConfig().tcpRttMs * 1000;
+  pcb->st = tcp_pcb::St::SynSent;
+  return ERR_OK;
+}
+
+uint16_t tcp_sndbuf(const tcp_pcb* pcb) { return pcb->st == tcp_pcb::St::Open ? kSndBuf : 0; }
+
+// Queues data for the client once the latency has passed; the client only
+// speaks after the previous flight, so one due time is enough.
+static void reply(tcp_pcb* pcb, const std::string& data, uint32_t latencyMs)
+{
+  pcb->response += data;
+  pcb->readyAtUs = simDeviceUs() + (uint64_t)latencyMs * 1000;
+}
+
+static void respond(tcp_pcb* pcb, const std::string& request)
+{
+  const SimConfig& c = simConfig();
+  pcb->answered = true;
+
+  if (request.compare(0, 4, "GET ") != 0 || simRandom() % 100 < c.httpFailPct)
+  {
+    reply(pcb, "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+          c.httpLatencyMs);
+    return;
+  }
+
+  // the server reads its clock halfway through the latency
+  const int64_t utcMs = simTrueUtcMs() + c.httpLatencyMs / 2;
+  const int64_t localSec = utcMs / 1000 + c.utcOffsetSec;
+  const int32_t off = c.utcOffsetSec < 0 ? -c.utcOffsetSec : c.utcOffsetSec;
+  char offset[12];
+  snprintf(offset, sizeof(offset), "%c%02d:%02d", c.utcOffsetSec < 0 ? '-' : '+', (int)(off / 3600),
+           (int)(off % 3600 / 60));
+
+  const time_t t = (time_t)localSec;
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  char body[512];
+  const int n = snprintf(body, sizeof(body),
+                         "{\"abbreviation\":\"SIM\",\"client_ip\":\"198.51.100.7\","
+                         "\"datetime\":\"%04d-%02d-%02dT%02d:%02d:%02d.%03d000%s\","
+                         "\"day_of_week\":%d,\"day_of_year\":%d,\"dst\":false,\"dst_from\":null,"
+                         "\"dst_offset\":0,\"dst_until\":null,\"raw_offset\":%d,\"timezone\":\"Etc/Sim\","
+                         "\"unixtime\":%lld,\"utc_datetime\":\"\",\"utc_offset\":\"%s\",\"week_number\":1}",
+                         tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+                         (int)(utcMs % 1000), offset, tm.tm_wday, tm.tm_yday + 1, (int)c.utcOffsetSec,
+                         (long long)(utcMs / 1000), offset);
+
+  const char* json = c.httpBody ? c.httpBody : body;
+  char head[160];
+  snprintf(head, sizeof(head),
+           "HTTP/1.1 200 OK\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: %d\r\n"
+           "Connection: close\r\n\r\n",
+           c.httpBody ? (int)strlen(json) : n);
+  reply(pcb, std::string(head) + json, c.httpLatencyMs);
+}
+
+// The fake TLS handshake of bearssl/bearssl.h, then HTTP in the clear
+static void serve(tcp_pcb* pcb)
+{
+  const SimConfig& c = simConfig();
+  while (pcb->tlsFlights < 2 && !pcb->answered)
+  {
+    const size_t eol = pcb->request.find('\n', pcb->served);
+    if (eol == std::string::npos)
+      return;
+    const std::string line = pcb->request.substr(pcb->served, eol - pcb->served);
+    pcb->served = eol + 1;
+    const std::string hello = std::string(SIM_TLS_HELLO) + kHosts[kTimeApiHost].name;
+    if (c.tlsAlert || line != (pcb->tlsFlights == 0 ? hello : std::string(SIM_TLS_FINISHED)))
+    {
+      pcb->answered = true; // and closed after the alert
+      reply(pcb, SIM_TLS_ALERT "\n", c.tcpRttMs);
+      return;
+    }
+    if (pcb->tlsFlights++ == 0)
+      reply(pcb, "\x16" + std::string(kCertChainBytes, 'c') + "\n", c.tcpRttMs);
+    else
+      reply(pcb, SIM_TLS_FINISHED "\n", c.tcpRttMs);
+  }
+  if (!pcb->answered && pcb->request.find("\r\n\r\n", pcb->served) != std::string::npos)
+    respond(pcb, pcb->request.substr(pcb->served));
+}
+
+err_t tcp_write(tcp_pcb* pcb, const void* dataptr, uint16_t len, uint8_t)
+{
+  if (pcb->st != tcp_pcb::St::Open || len > kSndBuf)
+    return ERR_MEM;
+  pcb->request.append((const char*)dataptr, len);
+  serve(pcb);
+  return ERR_OK;
+}
+
+err_t tcp_output(tcp_pcb*) { return ERR_OK; }
+
+void tcp_recved(tcp_pcb* pcb, uint16_t len) { pcb->wnd = (uint16_t)std::min<uint32_t>(kWnd, pcb->wnd + len); }
+
+err_t tcp_close(tcp_pcb* pcb)
+{
+  dropPcb(pcb);
+  return ERR_OK;
+}
+
+void tcp_abort(tcp_pcb* pcb)
+{
+  if (pcb->err)
+    pcb->err(pcb->arg, ERR_ABRT);
+  dropPcb(pcb);
+}
+
+void simTcpPump(uint64_t nowUs)
+{
+  // by index: a callback may open another pcb
+  for (size_t i = 0; i < pcbs.size(); i++)
+  {
+    tcp_pcb* pcb = pcbs[i];
+    if (pcb->st == tcp_pcb::St::SynSent && nowUs >= pcb->atUs && pcb->reachable && simWifiUp() &&
+        !simConfig().httpDown)
+    {
+      pcb->st = tcp_pcb::St::Open;
+      if (pcb->connected)
+        pcb->connected(pcb->arg, pcb, ERR_OK);
+      continue;
+    }
+    if (pcb->st != tcp_pcb::St::Open || pcb->sent == pcb->response.size() || nowUs < pcb->readyAtUs || !pcb->recv)
+      continue;
+
+    // the server closes once the response is out
+    while (pcb->sent < pcb->response.size() && pcb->wnd > 0)
+    {
+      const uint16_t n = (uint16_t)std::min<size_t>({pcb->response.size() - pcb->sent, kMss, pcb->wnd});
+      pbuf* p = simPbufFrom(pcb->response.data() + pcb->sent, n);
+      pcb->sent += n;
+      pcb->wnd -= n;
+      pcb->recv(pcb->arg, pcb, p, ERR_OK);
+    }
+    if (pcb->sent == pcb->response.size() && pcb->answered && !pcb->finSent)
+    {
+      pcb->finSent = true;
+      pcb->st = tcp_pcb::St::Closed;
+      pcb->recv(pcb->arg, pcb, nullptr, ERR_OK);
+    }
+  }
+}
+
+// ---- UDP (NTP) ----
+
+static void writeBe32(uint8_t* p, uint32_t v)
+{
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static void writeNtpTime(uint8_t* p, int64_t unixMs)
+{
+  writeBe32(p, (uint32_t)(unixMs / 1000 + kNtpToUnix));
+  writeBe32(p + 4, (uint32_t)(((uint64_t)(unixMs % 1000) << 32) / 1000));
+}
+
+static SimNtpExchange ntpExchanges[3];
+
+const SimNtpExchange& simNtpExchange(uint8_t server) { return ntpExchanges[server]; }
+
+uint8_t WiFiUDP::begin(uint16_t) { return 1; }
+
+void WiFiUDP::stop()
+{
+  pending_ = false;
+  rxLen_ = rxPos_ = 0;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+  txTo_ = ip;
+  txPort_ = port;
+  txLen_ = 0;
+  return 1;
+}
+
+int WiFiUDP::beginPacket(const char* host, uint16_t port)
+{
+  const int h = hostIndex(host);
+  return h >= 0 ? beginPacket(kHosts[h].ip, port) : 0;
+}
+
+size_t WiFiUDP::write(uint8_t c) { return write(&c, 1); }
+
+size_t WiFiUDP::write(const uint8_t* buf, size_t n)
+{
+  if (txLen_ + n > kMaxPacket)
+    n = kMaxPacket - txLen_;
+  memcpy(tx_ + txLen_, buf, n);
+  txLen_ += n;
+  return n;
+}
+
+int WiFiUDP::endPacket()
+{
+  if (!simWifiUp())
+    return 0;
+  // anything that is not an NTP client request to a known server is lost
+  const int server = ntpServerIndex(txTo_);
+  if (txPort_ != 123 || txLen_ < kMaxPacket || (tx_[0] & 0x07) != 3 || server < 0)
+    return 1;
+
+  const SimConfig& c = simConfig();
+  const uint32_t oneWayMs = c.ntpLatencyMs / 2 + c.ntpServerMs[server];
+  const uint32_t upMs = oneWayMs + (c.ntpJitterMs ? simRandom() % c.ntpJitterMs : 0);
+  const uint32_t downMs = oneWayMs + (c.ntpJitterMs ? simRandom() % c.ntpJitterMs : 0);
+  const int64_t rxMs = simTrueUtcMs() + upMs;
+  SimNtpExchange& x = ntpExchanges[server];
+  x.answered++;
+  x.upMs = upMs;
+  x.downMs = downMs;
+  x.serverUtcMs = rxMs;
+
+  uint8_t* p = pendingData_;
+  memset(p, 0, kMaxPacket);
+  p[0] = 0x24; // LI=0, VN=4, Mode=4 (server)
+  p[1] = 2;    // stratum
+  p[2] = tx_[2];
+  p[3] = 0xE9; // precision 2^-23
+  memcpy(p + 24, tx_ + 40, 8); // origin = client transmit
+  writeNtpTime(p + 32, rxMs);
+  writeNtpTime(p + 40, rxMs);
+  pending_ = true;
+  pendingAtUs_ = simDeviceUs() + (uint64_t)(upMs + downMs) * 1000;
+  pendingFrom_ = txTo_;
+  return 1;
+}
+
+int WiFiUDP::parsePacket()
+{
+  if (!pending_ || simDeviceUs() < pendingAtUs_)
+    return 0;
+  pending_ = false;
+  memcpy(rx_, pendingData_, kMaxPacket);
+  rxLen_ = kMaxPacket;
+  rxPos_ = 0;
+  rxFrom_ = pendingFrom_;
+  return (int)rxLen_;
+}
+
+int WiFiUDP::available() { return (int)(rxLen_ - rxPos_); }
+
+int WiFiUDP::read()
+{
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiUDP::read(uint8_t* buf, size_t n)
+{
+  const size_t avail = rxLen_ - rxPos_;
+  if (n > avail)
+    n = avail;
+  memcpy(buf, rx_ + rxPos_, n);
+  rxPos_ += n;
+  return (int)n;
+}
+
+void WiFiUDP::flush() { rxPos_ = rxLen_; }
@@ -0,0 +1,236 @@
+#include "sim.h"
+#include <ESP8266WiFi.h>
+#include <vector>
+
+ESP8266WiFiClass WiFi;
+
+// The one access point and the lease its DHCP server hands out
+static const uint8_t kApBssid[6] = {0x10, 0x7B, 0x44, 0x2A, 0x91, 0x0C};
+static constexpr int32_t kApChannel = 6;
+static const IPAddress kLeaseIp(192, 168, 1, 57);
+static const IPAddress kGateway(192, 168, 1, 1);
+static const IPAddress kMask(255, 255, 255, 0);
+
+template <typename Event> struct Handler : WiFiEventHandlerOpaque
+{
+  std::function<void(const Event&)> fn;
+};
+
+template <typename Event> struct HandlerList
+{
+  std::vector<std::weak_ptr<Handler<Event>>> list;
+
+  WiFiEventHandler add(std::function<void(const Event&)> fn)
+  {
+    auto h = std::make_shared<Handler<Event>>();
+    h->fn = fn;
+    list.push_back(h);
+    return h;
+  }
+
+  void fire(const Event& e)
+  {
+    for (size_t i = 0; i < list.size();)
+    {
+      if (auto h = list[i].lock())
+      {
+        h->fn(e);
+        i++;
+      }
+      else
+      {
+        list.erase(list.begin() + i);
+      }
+    }
+  }
+};
+
+static HandlerList<WiFiEventStationModeConnected> onConnected;
+static HandlerList<WiFiEventStationModeDisconnected> onDisconnected;
+static HandlerList<WiFiEventStationModeGotIP> onGotIp;
+
+enum class Link : uint8_t
+{
+  Idle,
+  Joining,  // scan/auth in progress, done at eventAtUs
+  Dhcp,     // associated, lease at eventAtUs
+  Up,
+};
+
+static Link link = Link::Idle;
+static uint32_t queries = 0; // status/RSSI/SSID/IP reads, see simWifiQueries()
+static uint64_t eventAtUs = 0;
+static bool autoReconnect = false;
+static bool staticIp = false;
+static IPAddress cfgIp, cfgGw, cfgMask, cfgDns;
+static std::string ssid;
+static bool began = false;
+
+static bool apDown(uint64_t nowUs)
+{
+  const SimConfig& c = simConfig();
+  if (c.dropEveryS == 0)
+    return false;
+  const uint64_t period = (uint64_t)c.dropEveryS * 1000000;
+  const uint64_t phase = nowUs % period;
+  return nowUs >= period && phase < (uint64_t)c.dropForS * 1000000;
+}
+
+static void fillDisconnected(WiFiEventStationModeDisconnected& e, WiFiDisconnectReason reason)
+{
+  e.ssid = String(ssid.c_str());
+  memcpy(e.bssid, kApBssid, sizeof(e.bssid));
+  e.reason = reason;
+}
+
+static void startJoin(uint64_t nowUs, bool directed)
+{
+  const SimConfig& c = simConfig();
+  link = Link::Joining;
+  eventAtUs = nowUs + (uint64_t)(directed ? c.joinFastMs : c.joinScanMs) * 1000;
+}
+
+void simWifiPump(uint64_t nowUs)
+{
+  const bool down = apDown(nowUs);
+  if (down && link != Link::Idle)
+  {
+    const bool wasUp = link == Link::Up;
+    link = Link::Idle;
+    WiFiEventStationModeDisconnected e;
+    fillDisconnected(e, wasUp ? WIFI_DISCONNECT_REASON_BEACON_TIMEOUT : WIFI_DISCONNECT_REASON_NO_AP_FOUND);
+    onDisconnected.fire(e);
+    return;
+  }
+  if (down)
+    return;
+
+  // the SDK retries on its own once the AP is back
+  if (link == Link::Idle && began && autoReconnect)
+    startJoin(nowUs, false);
+
+  if (link == Link::Joining && nowUs >= eventAtUs)
+  {
+    WiFiEventStationModeConnected e;
+    e.ssid = String(ssid.c_str());
+    memcpy(e.bssid, kApBssid, sizeof(e.bssid));
+    e.channel = (uint8_t)kApChannel;
+    onConnected.fire(e);
+    link = Link::Dhcp;
+    eventAtUs = staticIp ? nowUs : nowUs + (uint64_t)simConfig().dhcpMs * 1000;
+  }
+  if (link == Link::Dhcp && nowUs >= eventAtUs)
+  {
+    link = Link::Up;
+    WiFiEventStationModeGotIP e;
+    e.ip = staticIp ? cfgIp : kLeaseIp;
+    e.gw = staticIp ? cfgGw : kGateway;
+    e.mask = staticIp ? cfgMask : kMask;
+    onGotIp.fire(e);
+  }
+}
+
+bool simWifiUp() { return link == Link::Up; }
+uint32_t simWifiQueries() { return queries; }
+
+bool ESP8266WiFiClass::mode(WiFiMode_t) { return true; }
+
+bool ESP8266WiFiClass::setAutoReconnect(bool on)
+{
+  autoReconnect = on;
+  return true;
+}
+
+wl_status_t ESP8266WiFiClass::begin(const char* s, const char*, int32_t ch, const uint8_t* bssid, bool connect)
+{
+  ssid = s ? s : "";
+  began = true;
+  if (!connect)
+    return status();
+  // a directed join only helps when it names the right AP
+  const bool directed = ch == kApChannel && bssid && memcmp(bssid, kApBssid, sizeof(kApBssid)) == 0;
+  startJoin(simDeviceUs(), directed);
+  return status();
+}
+
+bool ESP8266WiFiClass::config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1, IPAddress)
+{
+  staticIp = local.isSet();
+  cfgIp = local;
+  cfgGw = gateway;
+  cfgMask = subnet;
+  cfgDns = dns1.isSet() ? dns1 : gateway;
+  return true;
+}
+
+bool ESP8266WiFiClass::disconnect(bool)
+{
+  const bool wasUp = link == Link::Up;
+  link = Link::Idle;
+  began = false;
+  if (wasUp)
+  {
+    WiFiEventStationModeDisconnected e;
+    fillDisconnected(e, WIFI_DISCONNECT_REASON_ASSOC_LEAVE);
+    onDisconnected.fire(e);
+  }
+  return true;
+}
+
+wl_status_t ESP8266WiFiClass::status()
+{
+  queries++;
+  if (link == Link::Up)
+    return WL_CONNECTED;
+  return apDown(simDeviceUs()) ? WL_NO_SSID_AVAIL : WL_DISCONNECTED;
+}
+
+String ESP8266WiFiClass::SSID() const
+{
+  queries++;
+  return String(ssid.c_str());
+}
+uint8_t* ESP8266WiFiClass::BSSID() { return (uint8_t*)kApBssid; }
+int32_t ESP8266WiFiClass::channel() { return kApChannel; }
+
+int32_t ESP8266WiFiClass::RSSI()
+{
+  queries++;
+  // slow wander between -55 and -70 dBm
+  const uint32_t s = (uint32_t)(simDeviceUs() / 10000000) % 30;
+  return -55 - (int32_t)(s < 15 ? s : 30 - s);
+}
+
+IPAddress ESP8266WiFiClass::localIP()
+{
+  queries++;
+  return link == Link::Up ? (staticIp ? cfgIp : kLeaseIp) : IPAddress();
+}
+IPAddress ESP8266WiFiClass::gatewayIP() { return link == Link::Up ? (staticIp ? cfgGw : kGateway) : IPAddress(); }
+IPAddress ESP8266WiFiClass::subnetMask() { return link == Link::Up ? (staticIp ? cfgMask : kMask) : IPAddress(); }
+IPAddress ESP8266WiFiClass::dnsIP(uint8_t) { return staticIp ? cfgDns : kGateway; }
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeConnected(
+    std::function<void(const WiFiEventStationModeConnected&)> f)
+{
+  return onConnected.add(f);
+}
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeDisconnected(
+    std::function<void(const WiFiEventStationModeDisconnected&)> f)
+{
+  return onDisconnected.add(f);
+}
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)> f)
+{
+  return onGotIp.add(f);
+}
+
+bool wifi_station_get_config(struct station_config* conf)
+{
+  queries++;
+  memset(conf, 0, sizeof(*conf));
+  memcpy(conf->ssid, ssid.data(), ssid.size() < sizeof(conf->ssid) ? ssid.size() : sizeof(conf->ssid));
+  return true;
+}
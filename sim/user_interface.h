@@ -0,0 +1,35 @@
+#pragma once
+// Host stand-in for the NONOS SDK user_interface.h (subset).
+#include <Arduino.h>
+
+enum rst_reason
+{
+  REASON_DEFAULT_RST = 0,
+  REASON_WDT_RST = 1,
+  REASON_EXCEPTION_RST = 2,
+  REASON_SOFT_WDT_RST = 3,
+  REASON_SOFT_RESTART = 4,
+  REASON_DEEP_SLEEP_AWAKE = 5,
+  REASON_EXT_SYS_RST = 6,
+};
+
+struct rst_info
+{
+  uint32_t reason;
+  uint32_t exccause;
+  uint32_t epc1;
+  uint32_t epc2;
+  uint32_t epc3;
+  uint32_t excvaddr;
+  uint32_t depc;
+};
+
+struct station_config
+{
+  uint8_t ssid[32];
+  uint8_t password[64];
+  uint8_t bssid_set;
+  uint8_t bssid[6];
+};
+
+bool wifi_station_get_config(struct station_config* config);
@@ -0,0 +1,94 @@
+#include "alloc_trace.h"
+
+static volatile uint32_t allocCount = 0;
+static volatile int32_t liveCount = 0;
+
+#ifdef ALLOC_TRACE
+extern "C"
+{
+  void* __real_malloc(size_t size);
+  void* __real_calloc(size_t n, size_t size);
+  void* __real_realloc(void* ptr, size_t size);
+  void __real_free(void* ptr);
+
+  void* __wrap_malloc(size_t size)
+  {
+    void* p = __real_malloc(size);
+    if (p)
+    {
+      allocCount++;
+      liveCount++;
+    }
+    return p;
+  }
+
+  void* __wrap_calloc(size_t n, size_t size)
+  {
+    void* p = __real_calloc(n, size);
+    if (p)
+    {
+      allocCount++;
+      liveCount++;
+    }
+    return p;
+  }
+
+  void* __wrap_realloc(void* ptr, size_t size)
+  {
+    void* p = __real_realloc(ptr, size);
+    // growing or moving a block is an allocation too; realloc(p, 0) frees
+    if (p)
+    {
+      allocCount++;
+      if (!ptr)
+        liveCount++;
+    }
+    else if (ptr && size == 0)
+    {
+      liveCount--;
+    }
+    return p;
+  }
+
+  void __wrap_free(void* ptr)
+  {
+    if (ptr)
+      liveCount--;
+    __real_free(ptr);
+  }
+}
+#endif
+
+AllocTrace::AllocTrace() : loopStart_(0), lastLoop_(0), maxLoop_(0), loops_(0), dirtyLoops_(0) {}
+
+bool AllocTrace::enabled()
+{
+#ifdef ALLOC_TRACE
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint32_t AllocTrace::totalAllocs() { return allocCount; }
+int32_t AllocTrace::liveAllocs() { return liveCount; }
+
+void AllocTrace::beginLoop() { loopStart_ = allocCount; }
+
+void AllocTrace::endLoop()
+{
+  lastLoop_ = allocCount - loopStart_;
+  if (lastLoop_ > maxLoop_)
+    maxLoop_ = lastLoop_;
+  if (lastLoop_)
+    dirtyLoops_++;
+  loops_++;
+}
+
+void AllocTrace::report(Print& out) const
+{
+  out.printf("[Heap] allocs/loop last=%u max=%u dirty=%u/%u total=%u live=%d%s free=%u maxBlock=%u frag=%u%%\n",
+             (unsigned)lastLoop_, (unsigned)maxLoop_, (unsigned)dirtyLoops_, (unsigned)loops_,
+             (unsigned)allocCount, (int)liveCount, enabled() ? "" : " (ALLOC_TRACE off)",
+             (unsigned)ESP.getFreeHeap(), (unsigned)ESP.getMaxFreeBlockSize(), (unsigned)ESP.getHeapFragmentation());
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <Arduino.h>
+
+// Heap allocation accounting for the main loop.
+//
+// With -DALLOC_TRACE and -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free
+// (see env:nodemcuv2_alloctrace) every malloc/calloc/realloc, and therefore
+// every new and String growth, is counted. Without it the counters stay 0 and
+// only the heap figures are reported.
+class AllocTrace
+{
+public:
+  AllocTrace();
+
+  void beginLoop();
+  void endLoop();
+
+  uint32_t lastLoopAllocs() const { return lastLoop_; }
+  uint32_t maxLoopAllocs() const { return maxLoop_; }
+
+  // One line of counters plus free heap and largest free block.
+  void report(Print& out) const;
+
+  static bool enabled();
+  static uint32_t totalAllocs();
+  static int32_t liveAllocs();
+
+private:
+  uint32_t loopStart_;
+  uint32_t lastLoop_;
+  uint32_t maxLoop_;
+  uint32_t loops_;
+  uint32_t dirtyLoops_; // loops that allocated at all
+};
@@ -1,29 +1,46 @@
 #include "app.h"
+#include "alloc_trace.h"
 #include "oled.h"
+#include "profiler.h"
+#include "scheduler.h"
+#include "telemetry.h"
 #include "time_mgr.h"
-#include "timer.h"
 #include "wifi_mgr.h"
 #include <Arduino.h>
 #include <string.h> // <--- added to fix memcpy/strcpy compilation errors
 
-// Use Timer to trigger UI refresh every second
+// Task periods. TimeMgr runs in short slices while a sync is in flight and
+// only checks its poll deadline otherwise.
+static constexpr uint32_t kWifiPeriodMs = 100;
+static constexpr uint32_t kTimeIdlePeriodMs = 250;
+static constexpr uint32_t kTimeSyncPeriodMs = 5;
+static constexpr uint32_t kUiPeriodMs = 1000; // fallback while unsynced
+static constexpr uint32_t kConsolePeriodMs = 200;
+static constexpr uint32_t kTickerPeriodMs = Marquee::kStepMs;
+// The UI frame is drawn this long after the local second rolls over, so the
+// new second is current even with ms rounding and drift correction.
+static constexpr uint32_t kUiLagMs = 2;
 
 // Buffers live in App translation unit, stable pointers for OLED draw
 static char g_time[16];
 static char g_date[16];
 static char g_ssid[33];
 static char g_ip[20];
+static char g_ticker[Marquee::kMaxText];
+static uint32_t g_wifiSeq = 0; // WifiMgr::seq() the WiFi strings were formatted at
+static bool g_wifiFormatted = false;
 
-static void copyToBuf(char* dst, size_t cap, const String& s)
-{
-  if (cap == 0)
-    return;
-  size_t n = s.length();
-  if (n >= cap)
-    n = cap - 1;
-  memcpy(dst, s.c_str(), n);
-  dst[n] = '\0';
-}
+// UI ticks between heap/allocation reports
+static constexpr uint32_t kHeapReportTicks = 60;
+static uint32_t g_ticks = 0;
+
+// Second-boundary lock: last drawn second and rollover-to-pixels latency
+static int64_t g_lastSec = -1;
+static uint32_t g_latencyMs = 0;
+static uint32_t g_latencyMaxMs = 0;
+static uint32_t g_skipped = 0; // seconds never shown
+static uint32_t g_repeats = 0; // woke before the rollover, frame skipped
+static int64_t g_shownSec = -1; // second of the frame on its way to the panel
 
 void App::setup()
 {
@@ -34,7 +51,10 @@ void App::setup()
 
   // use OOP-style init
   oled.init();
+  wifi.attachStore(&rtc);
   wifi.init();
+  timeMgr.attachStore(&rtc);
+  timeMgr.attachWifi(&wifi);
   timeMgr.init();
 
   // Init placeholders
@@ -43,25 +63,157 @@ void App::setup()
   strcpy(g_ssid, "asusyo24");
   strcpy(g_ip, "-");
 
-  // start 1s UI timer
-  timerBegin(1000);
+  // first frame right away: a warm boot already has the restored time
+  drawUi();
+
+  sched.every("wifi", kWifiPeriodMs, wifiTask, this);
+  timeTask_ = sched.every("time", kTimeIdlePeriodMs, timeTask, this);
+  uiTask_ = sched.every("ui", kUiPeriodMs, uiTask, this, timeMgr.msToNextSecond() + kUiLagMs);
+  sched.every("serial", kConsolePeriodMs, consoleTask, this);
+  sched.every("ticker", kTickerPeriodMs, tickerTask, this);
+  Serial.println("Serial: 'p' = profile, 'r' = reset profile, "
+                 "'c' = capture frame (PBM), 't' = telemetry dump, 'v' = big clock/status");
 }
 
 void App::loop()
 {
-  wifi.loop();
-  timeMgr.update();
+  allocs.beginLoop();
+  const uint32_t t0 = micros();
+  uint32_t waitMs;
+  {
+    PROF_SCOPE("pass");
+    waitMs = sched.runDue();
+  }
+  // one slice of a pending frame per pass, then straight back for the next
+  if (oled.busy())
+  {
+    if (!oled.pump())
+      frameShown();
+    waitMs = 0;
+  }
+  allocs.endLoop();
+  telemetry().record(Telemetry::LoopUs, (int32_t)(micros() - t0));
+  telemetry().tick(millis());
 
-  timerUpdate();
-  if (!timerExpired())
-    return;
-  timerReset();
+  sched.idle(waitMs);
+}
 
-  // Format strings (outside OLED)
-  copyToBuf(g_time, sizeof(g_time), timeMgr.timeString());
-  copyToBuf(g_date, sizeof(g_date), timeMgr.dateString());
-  copyToBuf(g_ssid, sizeof(g_ssid), wifi.ssid());
-  copyToBuf(g_ip, sizeof(g_ip), wifi.ip());
+void App::wifiTask(void* ctx)
+{
+  PROF_SCOPE("wifi");
+  static_cast<App*>(ctx)->wifi.loop();
+}
+
+void App::timeTask(void* ctx)
+{
+  App* app = static_cast<App*>(ctx);
+  {
+    PROF_SCOPE("time");
+    app->timeMgr.update();
+  }
+  app->sched.setPeriod(app->timeTask_, app->timeMgr.isSyncing() ? kTimeSyncPeriodMs : kTimeIdlePeriodMs);
+
+  // A sync moved the clock under the ui task's wake-up: time it again
+  if (app->timeMgr.clockSeq() != app->clockSeq_)
+  {
+    app->clockSeq_ = app->timeMgr.clockSeq();
+    const int64_t nowMs = app->timeMgr.nowEpochMs();
+    const int64_t sec = nowMs / 1000;
+    uint32_t waitMs = app->timeMgr.msToNextSecond() + kUiLagMs;
+    if (g_lastSec >= 0 && sec > g_lastSec)
+      waitMs = 0; // jumped past a second not yet shown: draw it now
+    else if (g_lastSec >= 0 && sec == g_lastSec - 1)
+      waitMs = (uint32_t)((g_lastSec + 1) * 1000 - nowMs) + kUiLagMs; // the next rollover is the second on screen
+    app->sched.runIn(app->uiTask_, waitMs);
+  }
+}
+
+void App::uiTask(void* ctx)
+{
+  App* app = static_cast<App*>(ctx);
+  telemetry().record(Telemetry::FreeHeap, (int32_t)ESP.getFreeHeap());
+  telemetry().record(Telemetry::MaxFreeBlock, (int32_t)ESP.getMaxFreeBlockSize());
+  app->drawUi();
+  // next frame right after the next rollover, not 1000 ms after this one
+  app->sched.runIn(app->uiTask_, app->timeMgr.msToNextSecond() + kUiLagMs);
+}
+
+void App::tickerTask(void* ctx)
+{
+  PROF_SCOPE("ticker");
+  static_cast<App*>(ctx)->oled.animate(millis());
+}
+
+void App::consoleTask(void* ctx)
+{
+  App* app = static_cast<App*>(ctx);
+  while (Serial.available() > 0)
+  {
+    switch (Serial.read())
+    {
+    case 'p':
+      Profiler::dump(Serial);
+      break;
+    case 'r':
+      Profiler::reset();
+      Serial.println("[Prof] reset");
+      break;
+    case 'c':
+      // plain P1 between markers, cut it out of the log and save as .pbm
+      Serial.println("[OLED] frame begin");
+      app->oled.capture(Serial, true);
+      Serial.println("[OLED] frame end");
+      break;
+    case 't':
+      // binary records (see Telemetry::dump) between markers
+      Serial.println("[Tele] dump begin");
+      for (uint8_t s = 0; s < Telemetry::kSeries; s++)
+        for (uint8_t t = 0; t < Telemetry::kTiers; t++)
+          telemetry().dump(Serial, (Telemetry::Series)s, (Telemetry::Tier)t);
+      Serial.println("[Tele] dump end");
+      break;
+    case 'v':
+      // takes effect with the next second's frame
+      app->oled.setScreen(app->oled.screen() == Oled::Screen::Clock ? Oled::Screen::Status : Oled::Screen::Clock);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+void App::drawUi()
+{
+  const bool locked = timeMgr.isSynced();
+  const uint32_t atUs = micros();
+  const int64_t nowMs = locked ? timeMgr.nowEpochMs() : 0;
+  const int64_t sec = locked ? nowMs / 1000 : -1;
+  if (locked && g_lastSec >= 0)
+  {
+    if (sec == g_lastSec)
+    {
+      g_repeats++;
+      return;
+    }
+    if (sec == g_lastSec + 2)
+      g_skipped++; // larger gaps are clock steps, not missed frames
+  }
+
+  // Format strings (outside OLED), straight into the fixed buffers
+  {
+    PROF_SCOPE("format");
+    // from the same reading as sec, so the frame shows the second checked above
+    timeMgr.formatTime(nowMs, g_time, sizeof(g_time));
+    timeMgr.formatDate(nowMs, g_date, sizeof(g_date));
+    if (!g_wifiFormatted || wifi.seq() != g_wifiSeq)
+    {
+      g_wifiSeq = wifi.seq();
+      g_wifiFormatted = true;
+      wifi.ssid(g_ssid, sizeof(g_ssid));
+      wifi.ip(g_ip, sizeof(g_ip));
+      snprintf(g_ticker, sizeof(g_ticker), "SSID %s  IP %s", g_ssid, g_ip);
+    }
+  }
 
   UiStatus s;
   s.time_hms = g_time;
@@ -69,7 +221,52 @@ void App::loop()
   s.wifi_connected = wifi.isConnected();
   s.wifi_ssid = g_ssid;
   s.wifi_rssi = wifi.rssi();
+  s.ticker = g_ticker;
 
   // use OOP-style draw
-  oled.drawStatus(s);
-}
\ No newline at end of file
+  {
+    PROF_SCOPE("draw");
+    oled.drawStatus(s);
+  }
+
+  if (locked)
+  {
+    if (g_lastSec >= 0)
+      g_shownSec = sec;
+    g_lastSec = sec;
+  }
+  uiFrame_.seq++;
+  uiFrame_.sec = sec;
+  uiFrame_.time = g_time;
+  uiFrame_.utcMs = locked ? nowMs - (int64_t)timeMgr.utcOffsetSec() * 1000 : 0;
+  uiFrame_.atUs = atUs;
+  if (!oled.busy())
+    frameShown();
+
+  if (++g_ticks % kHeapReportTicks == 0)
+  {
+    Serial.printf("[UI] rollover->pixels last=%u max=%u ms, skipped=%u early=%u, widgets last=%u total=%u "
+                  "unchanged=%u\n",
+                  g_latencyMs, g_latencyMaxMs, g_skipped, g_repeats, oled.lastWidgets(), oled.totalWidgets(),
+                  oled.skippedFrames());
+    Serial.printf("[UI] frame send latency last=%u max=%u us, longest slice=%u us\n", oled.lastLatencyUs(),
+                  oled.maxLatencyUs(), oled.maxSliceUs());
+    allocs.report(Serial);
+    sched.report(Serial);
+  }
+}
+
+// The frame drawn for g_shownSec is fully on the panel (or had nothing to send).
+void App::frameShown()
+{
+  if (g_shownSec < 0)
+    return;
+  const int64_t lat = timeMgr.nowEpochMs() - g_shownSec * 1000;
+  g_latencyMs = lat > 0 ? (uint32_t)lat : 0;
+  if (g_latencyMs > g_latencyMaxMs)
+    g_latencyMaxMs = g_latencyMs;
+  g_shownSec = -1;
+}
+
+uint32_t App::uiSkipped() const { return g_skipped; }
+uint32_t App::uiEarly() const { return g_repeats; }
@@ -1,5 +1,8 @@
 #pragma once
+#include "alloc_trace.h"
 #include "oled.h"
+#include "rtc_store.h"
+#include "scheduler.h"
 #include "time_mgr.h"
 #include "wifi_mgr.h"
 
@@ -9,7 +12,40 @@ public:
   void setup();
   void loop();
 
+  // What the last drawn UI frame shows: the local epoch second formatted
+  // into it (-1 while unsynced) and its "HH:MM:SS", with the clock's UTC and
+  // micros() at the reading. seq counts drawn frames.
+  struct UiFrame
+  {
+    uint32_t seq;
+    int64_t sec;
+    const char* time;
+    int64_t utcMs;
+    uint32_t atUs;
+  };
+  const UiFrame& uiFrame() const { return uiFrame_; }
+  // Seconds never shown, and ui wake-ups before the rollover (frame not drawn).
+  uint32_t uiSkipped() const;
+  uint32_t uiEarly() const;
+
   TimeMgr timeMgr;
   Oled oled;
   WifiMgr wifi;
+  AllocTrace allocs;
+  EspRtcStore rtc;
+  StaticScheduler<8> sched; // wifi, time, ui, serial, ticker + spares
+
+private:
+  static void wifiTask(void* ctx);
+  static void timeTask(void* ctx);
+  static void uiTask(void* ctx);
+  static void consoleTask(void* ctx);
+  static void tickerTask(void* ctx);
+  void drawUi();
+  void frameShown();
+
+  Scheduler::TaskId timeTask_ = Scheduler::kNoTask;
+  Scheduler::TaskId uiTask_ = Scheduler::kNoTask;
+  uint32_t clockSeq_ = 0; // TimeMgr::clockSeq() the ui task was timed by
+  UiFrame uiFrame_ = {0, -1, "", 0, 0};
 };
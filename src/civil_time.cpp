@@ -0,0 +1,92 @@
+#include "civil_time.h"
+
+static bool isLeap(int y) { return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0; }
+
+static uint8_t daysInMonth(int y, uint8_t m)
+{
+    static const uint8_t kDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return (m == 2 && isLeap(y)) ? 29 : kDays[m - 1];
+}
+
+void civilFromEpoch(uint32_t epoch, CivilTime& out)
+{
+    uint32_t days = epoch / 86400UL;
+    uint32_t rem = epoch % 86400UL;
+    out.hour = (uint8_t)(rem / 3600);
+    rem %= 3600;
+    out.minute = (uint8_t)(rem / 60);
+    out.second = (uint8_t)(rem % 60);
+
+    // civil_from_days (H. Hinnant), epoch >= 0 so the era is never negative
+    const uint32_t z = days + 719468;
+    const uint32_t era = z / 146097;
+    const uint32_t doe = z - era * 146097;
+    const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const uint32_t mp = (5 * doy + 2) / 153;
+    const uint32_t d = doy - (153 * mp + 2) / 5 + 1;
+    const uint32_t m = mp < 10 ? mp + 3 : mp - 9;
+    out.year = (int16_t)(yoe + era * 400 + (m <= 2));
+    out.month = (uint8_t)m;
+    out.day = (uint8_t)d;
+}
+
+void civilAdvance(CivilTime& t, uint32_t seconds)
+{
+    uint32_t s = t.second + seconds;
+    t.second = (uint8_t)(s % 60);
+    uint32_t m = t.minute + s / 60;
+    t.minute = (uint8_t)(m % 60);
+    uint32_t h = t.hour + m / 60;
+    t.hour = (uint8_t)(h % 24);
+
+    for (uint32_t days = h / 24; days; days--)
+    {
+        if (t.day < daysInMonth(t.year, t.month))
+        {
+            t.day++;
+            continue;
+        }
+        t.day = 1;
+        if (t.month < 12)
+        {
+            t.month++;
+            continue;
+        }
+        t.month = 1;
+        t.year++;
+    }
+}
+
+static inline void put2(char* p, uint8_t v)
+{
+    p[0] = (char)('0' + v / 10);
+    p[1] = (char)('0' + v % 10);
+}
+
+bool formatHms(const CivilTime& t, char* dst, size_t cap)
+{
+    if (cap < 9)
+        return false;
+    put2(dst, t.hour);
+    dst[2] = ':';
+    put2(dst + 3, t.minute);
+    dst[5] = ':';
+    put2(dst + 6, t.second);
+    dst[8] = '\0';
+    return true;
+}
+
+bool formatYmd(const CivilTime& t, char* dst, size_t cap)
+{
+    if (cap < 11 || t.year < 0 || t.year > 9999)
+        return false;
+    put2(dst, (uint8_t)(t.year / 100));
+    put2(dst + 2, (uint8_t)(t.year % 100));
+    dst[4] = '-';
+    put2(dst + 5, t.month);
+    dst[7] = '-';
+    put2(dst + 8, t.day);
+    dst[10] = '\0';
+    return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Broken-down calendar time (proleptic Gregorian, no timezone).
+struct CivilTime
+{
+    int16_t year;
+    uint8_t month; // 1..12
+    uint8_t day;   // 1..31
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+};
+
+// Full conversion from seconds since 1970-01-01, O(1) but division-heavy.
+void civilFromEpoch(uint32_t epoch, CivilTime& out);
+
+// Moves t forward by `seconds`, carrying into minutes, hours, days and months
+// (leap years included). Cheap for the usual 1 s step; large jumps should use
+// civilFromEpoch instead.
+void civilAdvance(CivilTime& t, uint32_t seconds);
+
+// "HH:MM:SS" / "YYYY-MM-DD" into dst; returns false (dst untouched) if cap is too small.
+bool formatHms(const CivilTime& t, char* dst, size_t cap);
+bool formatYmd(const CivilTime& t, char* dst, size_t cap);
@@ -0,0 +1,85 @@
+#include "clock_discipline.h"
+
+ClockDiscipline::ClockDiscipline() { reset(); }
+
+void ClockDiscipline::reset()
+{
+    valid_ = false;
+    freqValid_ = false;
+    refUtcMs_ = 0;
+    refLocalMs_ = 0;
+    driftPpb_ = 0;
+    lastErrorMs_ = 0;
+    pollMs_ = kInitialPollMs;
+}
+
+int64_t ClockDiscipline::utcAt(uint32_t localMs) const
+{
+    const int64_t elapsed = (int64_t)(uint32_t)(localMs - refLocalMs_);
+    return refUtcMs_ + elapsed + elapsed * driftPpb_ / 1000000000LL;
+}
+
+void ClockDiscipline::step(int64_t utcMs, uint32_t localMs)
+{
+    refUtcMs_ = utcMs;
+    refLocalMs_ = localMs;
+    valid_ = true;
+}
+
+void ClockDiscipline::restore(int64_t utcMs, uint32_t localMs, int32_t driftPpb)
+{
+    step(utcMs, localMs);
+    if (driftPpb > kMaxDriftPpb || driftPpb < -kMaxDriftPpb)
+        return;
+    driftPpb_ = driftPpb;
+    freqValid_ = driftPpb != 0;
+}
+
+int32_t ClockDiscipline::addSample(int64_t utcMs, uint32_t localMs)
+{
+    if (!valid_)
+    {
+        step(utcMs, localMs);
+        lastErrorMs_ = 0;
+        return 0;
+    }
+
+    const uint32_t span = localMs - refLocalMs_;
+    int64_t err = utcMs - utcAt(localMs);
+    if (err > INT32_MAX)
+        err = INT32_MAX;
+    if (err < INT32_MIN)
+        err = INT32_MIN;
+    lastErrorMs_ = (int32_t)err;
+
+    const uint32_t absErr = (uint32_t)(err < 0 ? -err : err);
+    if (absErr > 10 * kMaxErrorMs)
+    {
+        // a jump that big is a bad sample or a reset of the source, not drift
+        step(utcMs, localMs);
+        pollMs_ = kMinPollMs;
+        return lastErrorMs_;
+    }
+
+    if (span >= kMinSpanMs)
+    {
+        // residual frequency error over this span; first estimate taken as is,
+        // later ones blended in by half to average out sample jitter
+        int64_t residualPpb = err * 1000000000LL / (int64_t)span;
+        int64_t ppb = driftPpb_ + (freqValid_ ? residualPpb / 2 : residualPpb);
+        if (ppb > kMaxDriftPpb)
+            ppb = kMaxDriftPpb;
+        if (ppb < -kMaxDriftPpb)
+            ppb = -kMaxDriftPpb;
+        driftPpb_ = (int32_t)ppb;
+        freqValid_ = true;
+
+        if (absErr < kMaxErrorMs / 4 && pollMs_ < kMaxPollMs)
+            pollMs_ = (pollMs_ * 2 > kMaxPollMs) ? kMaxPollMs : pollMs_ * 2;
+        else if (absErr > kMaxErrorMs / 2 && pollMs_ > kMinPollMs)
+            pollMs_ = (pollMs_ / 2 < kMinPollMs) ? kMinPollMs : pollMs_ / 2;
+    }
+
+    step(utcMs, localMs);
+    return lastErrorMs_;
+}
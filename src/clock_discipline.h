@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+
+// Frequency-corrected mapping from local millis() to UTC epoch milliseconds.
+//
+// Each sync sample is compared with what the clock predicted for that
+// instant; the residual over the elapsed interval gives the remaining
+// frequency error of the oscillator, which is folded into a smoothed
+// parts-per-billion correction. The poll interval doubles while predictions
+// stay well inside kMaxErrorMs and halves when they do not, so a good
+// crystal is asked less often and a bad one more.
+class ClockDiscipline
+{
+public:
+    static constexpr uint32_t kMaxErrorMs = 200;               // accuracy we poll for
+    static constexpr uint32_t kMinPollMs = 15UL * 60 * 1000;   // 15 min
+    static constexpr uint32_t kMaxPollMs = 6UL * 60 * 60 * 1000; // 6 h, also bounds DST/zone refresh
+    static constexpr uint32_t kInitialPollMs = 60UL * 60 * 1000; // 1 h
+
+    ClockDiscipline();
+
+    void reset();
+    bool valid() const { return valid_; }
+
+    // Hard set without touching the frequency estimate (coarse sources, first sync).
+    void step(int64_t utcMs, uint32_t localMs);
+
+    // Reinstates a saved state (warm boot): time plus the known frequency error.
+    void restore(int64_t utcMs, uint32_t localMs, int32_t driftPpb);
+
+    // Precise sample: updates frequency and poll interval. Returns the
+    // prediction error in ms (sample minus prediction), 0 for the first sample.
+    int32_t addSample(int64_t utcMs, uint32_t localMs);
+
+    // UTC epoch ms at local millis() value localMs.
+    int64_t utcAt(uint32_t localMs) const;
+
+    int32_t driftPpb() const { return driftPpb_; }
+    int32_t lastErrorMs() const { return lastErrorMs_; }
+    // The second sample comes early: until it has measured the frequency the
+    // clock drifts uncorrected, up to kMaxErrorMs in 15 min at 220 ppm.
+    uint32_t pollIntervalMs() const { return freqValid_ ? pollMs_ : kMinPollMs; }
+
+private:
+    static constexpr int32_t kMaxDriftPpb = 500000;  // +-500 ppm, beyond any sane resonator
+    static constexpr uint32_t kMinSpanMs = 60000;    // shorter spans are all jitter
+
+    bool valid_;
+    bool freqValid_;
+    int64_t refUtcMs_;
+    uint32_t refLocalMs_;
+    int32_t driftPpb_; // local clock runs slow by this much (positive -> add time)
+    int32_t lastErrorMs_;
+    uint32_t pollMs_;
+};
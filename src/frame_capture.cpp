@@ -0,0 +1,39 @@
+#include "frame_capture.h"
+
+void writeFramePbm(Print& out, const uint8_t* tiles, uint8_t tilesW, uint8_t tilesH, bool ascii)
+{
+  const int w = tilesW * 8;
+  const int h = tilesH * 8;
+  out.printf("%s\n%d %d\n", ascii ? "P1" : "P4", w, h);
+
+  for (int y = 0; y < h; y++)
+  {
+    if (ascii)
+    {
+      // one pixel per character, sent in small pieces to keep the stack short
+      char chunk[64];
+      size_t n = 0;
+      for (int x = 0; x < w; x++)
+      {
+        chunk[n++] = framePixel(tiles, tilesW, x, y) ? '1' : '0';
+        if (n == sizeof(chunk))
+        {
+          out.write((const uint8_t*)chunk, n);
+          n = 0;
+        }
+      }
+      out.write((const uint8_t*)chunk, n);
+      out.write((uint8_t)'\n');
+      continue;
+    }
+
+    // P4: rows packed MSB first, 1 = black; lit OLED pixels are written as black
+    for (int xb = 0; xb < w / 8; xb++)
+    {
+      uint8_t v = 0;
+      for (int bit = 0; bit < 8; bit++)
+        v = (uint8_t)((v << 1) | (framePixel(tiles, tilesW, xb * 8 + bit, y) ? 1 : 0));
+      out.write(v);
+    }
+  }
+}
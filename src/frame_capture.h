@@ -0,0 +1,14 @@
+#pragma once
+#include <Arduino.h>
+
+// Writes a u8g2 full-buffer frame (tile layout: one row of tilesW * 8 bytes
+// per 8-pixel page, bit n of a byte is pixel row n) as a PBM image.
+// Binary P4 for files, or plain-text P1 for a serial console; both open in
+// any netpbm-aware viewer and convert to PNG with `pnmtopng`.
+void writeFramePbm(Print& out, const uint8_t* tiles, uint8_t tilesW, uint8_t tilesH, bool ascii = false);
+
+// Pixel at (x, y) of a frame in the same layout.
+inline bool framePixel(const uint8_t* tiles, uint8_t tilesW, int x, int y)
+{
+  return (tiles[(y >> 3) * tilesW * 8 + x] >> (y & 7)) & 1;
+}
@@ -0,0 +1,356 @@
+#include "glyph_cache.h"
+#include <string.h>
+#include <type_traits>
+
+// u8g2 font layout: 23-byte header, then [encoding, size, data] records for
+// 0..255, then the unicode jump table and [enc hi, enc lo, size, data]
+// records. Fonts may sit in flash, so every byte goes through u8x8_pgm_read.
+static constexpr uint8_t kFontHeader = 23;
+static constexpr uint16_t kFirstAscii = 0x20;
+static constexpr uint16_t kFirstWide = 0x80;
+
+using Coord = std::make_signed<u8g2_uint_t>::type;
+
+static uint16_t readWord(const uint8_t* p)
+{
+  return (uint16_t)((u8x8_pgm_read(p) << 8) | u8x8_pgm_read(p + 1));
+}
+
+// Bit reader matching u8g2_font_decode_get_unsigned_bits(): LSB first, and
+// bounded by the glyph record so a damaged font cannot run away.
+struct GlyphBits
+{
+  const uint8_t* p;
+  const uint8_t* end;
+  uint8_t pos;
+
+  uint8_t get(uint8_t cnt)
+  {
+    if (p >= end)
+      return 0;
+    uint16_t val = (uint16_t)(u8x8_pgm_read(p) >> pos);
+    uint8_t next = pos + cnt;
+    if (next >= 8)
+    {
+      p++;
+      if (p < end)
+        val |= (uint16_t)(u8x8_pgm_read(p) << (8 - pos));
+      next -= 8;
+    }
+    pos = next;
+    return (uint8_t)(val & ((1U << cnt) - 1));
+  }
+
+  int8_t getSigned(uint8_t cnt) { return cnt ? (int8_t)(get(cnt) - (1 << (cnt - 1))) : 0; }
+};
+
+GlyphCache::GlyphCache() : font_(nullptr), wideCount_(0), wideComplete_(true), hits_(0), misses_(0), fallbacks_(0)
+{
+  memset(ascii_, 0, sizeof(ascii_));
+  clear();
+}
+
+void GlyphCache::clear()
+{
+  memset(slots_, 0, sizeof(slots_));
+}
+
+void GlyphCache::bind(U8G2& u8g2)
+{
+  const u8g2_t* u = u8g2.getU8g2();
+  if (u->font == font_)
+    return;
+  font_ = u->font;
+  clear();
+  memset(ascii_, 0, sizeof(ascii_));
+  wideCount_ = 0;
+  wideComplete_ = true;
+  if (!font_)
+    return;
+
+  auto addWide = [this](uint16_t cp, uint16_t off) {
+    if (wideCount_ == kMaxIndexed)
+    {
+      wideComplete_ = false;
+      return;
+    }
+    // records come sorted; the insertion only guards against fonts that are not
+    uint8_t i = wideCount_++;
+    for (; i > 0 && wideCp_[i - 1] > cp; i--)
+    {
+      wideCp_[i] = wideCp_[i - 1];
+      wideOff_[i] = wideOff_[i - 1];
+    }
+    wideCp_[i] = cp;
+    wideOff_[i] = off;
+  };
+
+  const uint8_t* p = font_ + kFontHeader;
+  for (uint8_t size; (size = u8x8_pgm_read(p + 1)) != 0; p += size)
+  {
+    const uint8_t cp = u8x8_pgm_read(p);
+    const uint16_t off = (uint16_t)(p + 2 - font_);
+    if (cp >= kFirstWide)
+      addWide(cp, off);
+    else if (cp >= kFirstAscii)
+      ascii_[cp - kFirstAscii] = off;
+  }
+
+  const uint8_t* table = font_ + kFontHeader + u->font_info.start_pos_unicode;
+  for (p = table + readWord(table); readWord(p) != 0; p += u8x8_pgm_read(p + 2))
+    addWide(readWord(p), (uint16_t)(p + 3 - font_));
+}
+
+const uint8_t* GlyphCache::glyphData(U8G2& u8g2, uint16_t cp) const
+{
+  if (cp >= kFirstAscii && cp < kFirstWide)
+    return ascii_[cp - kFirstAscii] ? font_ + ascii_[cp - kFirstAscii] : nullptr;
+  if (cp >= kFirstWide)
+  {
+    uint8_t lo = 0;
+    uint8_t hi = wideCount_;
+    while (lo < hi)
+    {
+      const uint8_t mid = (uint8_t)((lo + hi) / 2);
+      if (wideCp_[mid] < cp)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    if (lo < wideCount_ && wideCp_[lo] == cp)
+      return font_ + wideOff_[lo];
+    if (wideComplete_)
+      return nullptr;
+  }
+  return u8g2_font_get_glyph_data(u8g2.getU8g2(), cp);
+}
+
+void GlyphCache::decode(U8G2& u8g2, uint16_t cp, Slot& s)
+{
+  memset(&s, 0, sizeof(s));
+  s.cp = cp;
+  s.used = true;
+  s.fits = true;
+
+  const uint8_t* data = glyphData(u8g2, cp);
+  if (!data)
+    return; // u8g2 draws nothing and advances by 0
+
+  // the record size byte sits right before the data and counts the 2 or 3 header bytes
+  const u8g2_font_info_t& fi = u8g2.getU8g2()->font_info;
+  GlyphBits bits{data, data - (cp > 0xFF ? 3 : 2) + u8x8_pgm_read(data - 1), 0};
+  s.w = bits.get(fi.bits_per_char_width);
+  s.h = bits.get(fi.bits_per_char_height);
+  s.x = bits.getSigned(fi.bits_per_char_x);
+  const int8_t y = bits.getSigned(fi.bits_per_char_y);
+  s.adv = bits.getSigned(fi.bits_per_delta_x);
+  s.top = (int8_t)-(s.h + y);
+  if (s.w > kMaxW || s.h > kMaxH)
+  {
+    s.fits = false;
+    return;
+  }
+  if (s.w == 0)
+    return;
+
+  // Runs of background/foreground pixels fill the box row by row, as in
+  // u8g2_font_decode_len(); a set repeat bit reuses the same pair of runs.
+  uint8_t lx = 0;
+  uint8_t ly = 0;
+  auto run = [&](uint8_t len, bool ink) {
+    uint8_t cnt = len;
+    for (;;)
+    {
+      const uint8_t rem = (uint8_t)(s.w - lx);
+      const uint8_t cur = cnt < rem ? cnt : rem;
+      if (ink && ly < kMaxH)
+        for (uint8_t i = 0; i < cur; i++)
+          s.cols[lx + i] |= (uint16_t)(1U << ly);
+      if (cnt < rem)
+        break;
+      cnt -= rem;
+      lx = 0;
+      ly++;
+    }
+    lx += cnt;
+  };
+  while (ly < s.h && bits.p < bits.end)
+  {
+    const uint8_t a = bits.get(fi.bits_per_0);
+    const uint8_t b = bits.get(fi.bits_per_1);
+    do
+    {
+      run(a, false);
+      run(b, true);
+    } while (bits.get(1) != 0);
+  }
+}
+
+const GlyphCache::Slot& GlyphCache::slot(U8G2& u8g2, uint16_t cp)
+{
+  Slot* ways = slots_[(cp ^ (cp >> 3)) & (kSets - 1)];
+  Slot* found = nullptr;
+  Slot* victim = &ways[0];
+  for (uint8_t w = 0; w < kWays; w++)
+  {
+    Slot& s = ways[w];
+    if (s.used && s.cp == cp)
+      found = &s;
+    else if (s.age < 0xFF)
+      s.age++;
+    if (!s.used || (victim->used && s.age > victim->age))
+      victim = &s;
+  }
+  if (found)
+  {
+    found->age = 0;
+    hits_++;
+    return *found;
+  }
+  decode(u8g2, cp, *victim);
+  misses_++;
+  return *victim;
+}
+
+GlyphCache::Target GlyphCache::frameTarget(U8G2& u8g2)
+{
+  // visible area: clip window inside the (full) frame buffer
+  const u8g2_t* u = u8g2.getU8g2();
+  const int16_t bufW = (int16_t)(u8g2.getBufferTileWidth() * 8);
+  const int16_t bufH = (int16_t)(u8g2.getBufferTileHeight() * 8);
+  Target t{u8g2.getBufferPtr(), bufW, u->clip_x0, u->clip_y0, u->clip_x1, u->clip_y1, u->draw_color, true};
+  if (t.x1 > bufW)
+    t.x1 = bufW;
+  if (t.y1 > bufH)
+    t.y1 = bufH;
+  if (!u->is_page_clip_window_intersection)
+    t.x1 = t.x0;
+  return t;
+}
+
+void GlyphCache::blit(const Target& t, int16_t x, int16_t y, const Slot& s)
+{
+  if (s.w == 0 || s.h == 0)
+    return;
+
+  const int16_t top = y + s.top;
+  if (top >= t.y1 || top + s.h <= t.y0)
+    return;
+  uint32_t rows = (1U << s.h) - 1;
+  if (top < t.y0)
+    rows &= ~((1U << (t.y0 - top)) - 1);
+  if (top + s.h > t.y1)
+    rows &= (1U << (t.y1 - top)) - 1;
+  const int16_t firstPage = (top > t.y0 ? top : t.y0) >> 3;
+  const int16_t lastPage = ((top + s.h < t.y1 ? top + s.h : t.y1) - 1) >> 3;
+
+  for (uint8_t c = 0; c < s.w; c++)
+  {
+    const int16_t px = x + s.x + c;
+    const uint32_t m = s.cols[c] & rows;
+    if (px < t.x0 || px >= t.x1 || !m)
+      continue;
+    for (int16_t page = firstPage; page <= lastPage; page++)
+    {
+      const int16_t shift = top - page * 8;
+      const uint8_t b = (uint8_t)(shift >= 0 ? m << shift : m >> -shift);
+      uint8_t& dst = t.buf[page * t.stride + px];
+      if (t.color == 0)
+        dst &= (uint8_t)~b;
+      else if (t.color == 1)
+        dst |= b;
+      else
+        dst ^= b;
+    }
+  }
+}
+
+int16_t GlyphCache::drawGlyph(U8G2& u8g2, const Target& t, int16_t x, int16_t y, uint16_t cp, bool fast)
+{
+  if (fast)
+  {
+    const Slot& s = slot(u8g2, cp);
+    if (s.fits)
+    {
+      u8g2_t* u = u8g2.getU8g2();
+      blit(t, x, (int16_t)(y + (Coord)u->font_calc_vref(u)), s);
+      return s.adv;
+    }
+    if (!t.frame)
+    {
+      fallbacks_++;
+      return s.adv;
+    }
+  }
+  fallbacks_++;
+  return (Coord)u8g2_DrawGlyph(u8g2.getU8g2(), (u8g2_uint_t)x, (u8g2_uint_t)y, cp);
+}
+
+uint16_t GlyphCache::drawStr(U8G2& u8g2, int x, int y, const char* s)
+{
+  bind(u8g2);
+  const u8g2_t* u = u8g2.getU8g2();
+  const bool fast = u->font_decode.is_transparent && u->font_decode.dir == 0;
+  const Target t = frameTarget(u8g2);
+  int16_t pen = (int16_t)x;
+  // like u8x8_ascii_next(): every byte is a glyph, '\n' ends the string
+  for (; *s && *s != '\n'; s++)
+    pen += drawGlyph(u8g2, t, pen, (int16_t)y, (uint8_t)*s, fast);
+  return (uint16_t)(pen - x);
+}
+
+uint16_t GlyphCache::drawUTF8(U8G2& u8g2, int x, int y, const char* utf8)
+{
+  const u8g2_t* u = u8g2.getU8g2();
+  return drawUTF8(u8g2, frameTarget(u8g2), x, y, utf8, u->font_decode.is_transparent && u->font_decode.dir == 0);
+}
+
+uint16_t GlyphCache::drawUTF8(U8G2& u8g2, const Bitmap& bmp, int x, int y, const char* utf8)
+{
+  const Target t{bmp.buf, (int16_t)bmp.w, 0, 0, (int16_t)bmp.w, (int16_t)bmp.h, 1, false};
+  return drawUTF8(u8g2, t, x, y, utf8, true);
+}
+
+uint16_t GlyphCache::drawUTF8(U8G2& u8g2, const Target& t, int x, int y, const char* utf8, bool fast)
+{
+  bind(u8g2);
+  int16_t pen = (int16_t)x;
+  // u8g2's own decoder, so malformed input comes out the same
+  u8x8_t* u8x8 = u8g2.getU8x8();
+  u8x8_utf8_init(u8x8);
+  for (;; utf8++)
+  {
+    const uint16_t cp = u8x8_utf8_next(u8x8, (uint8_t)*utf8);
+    if (cp == 0xFFFF)
+      break;
+    if (cp != 0xFFFE)
+      pen += drawGlyph(u8g2, t, pen, (int16_t)y, cp, fast);
+  }
+  return (uint16_t)(pen - x);
+}
+
+int8_t GlyphCache::advance(U8G2& u8g2, uint16_t cp)
+{
+  bind(u8g2);
+  return slot(u8g2, cp).adv;
+}
+
+int8_t GlyphCache::endWidth(U8G2& u8g2, uint16_t cp)
+{
+  bind(u8g2);
+  const Slot& s = slot(u8g2, cp);
+  return s.w ? (int8_t)(s.x + s.w) : s.adv;
+}
+
+uint16_t GlyphCache::strAdvance(U8G2& u8g2, const char* s)
+{
+  uint16_t w = 0;
+  for (; *s && *s != '\n'; s++)
+    w += (uint16_t)advance(u8g2, (uint8_t)*s);
+  return w;
+}
+
+// Instance used by the drawing helpers
+static GlyphCache _internalGlyphCache;
+
+GlyphCache& glyphCache() { return _internalGlyphCache; }
@@ -0,0 +1,108 @@
+#pragma once
+#include <U8g2lib.h>
+
+// Text fast path for small fonts. Draws the same pixels as u8g2's
+// drawStr()/drawUTF8() (transparent font mode, font direction 0, the
+// current draw color and clip window) without repeating u8g2's per-glyph
+// work:
+//  - an index of the current font maps a code point to its glyph record,
+//    directly for ASCII and by binary search above it, instead of walking
+//    the font data;
+//  - decoded glyphs (column bitmaps, offsets, advance) of up to kMaxW x kMaxH
+//    pixels are kept in a 4-way set-associative LRU cache and ORed straight
+//    into the page buffer, instead of decoding the RLE bitstream on every draw.
+// Glyphs too large for a slot, and any other font mode or direction, go
+// through u8g2 unchanged. One difference: with u8g2's 8-bit coordinates a
+// string running past x = 255 wraps around to the left edge; here it is
+// clipped. The index is rebuilt and the cache emptied when
+// the font changes.
+class GlyphCache
+{
+public:
+  // 1bpp bitmap in the frame buffer's page layout: byte (y / 8) * w + x holds
+  // row y % 8 of column x. h is a multiple of 8.
+  struct Bitmap
+  {
+    uint8_t* buf;
+    uint16_t w;
+    uint16_t h;
+  };
+
+  static constexpr uint8_t kSets = 8;
+  static constexpr uint8_t kWays = 4;
+  static constexpr uint8_t kMaxW = 8;   // glyph columns per slot
+  static constexpr uint8_t kMaxH = 16;  // glyph rows per slot
+  static constexpr uint8_t kMaxIndexed = 96; // glyphs above 0x7f with an index entry
+
+  GlyphCache();
+
+  // Same result and return value (total advance) as the u8g2 calls.
+  uint16_t drawStr(U8G2& u8g2, int x, int y, const char* s);
+  uint16_t drawUTF8(U8G2& u8g2, int x, int y, const char* utf8);
+  // Same, into bmp instead of the frame buffer: draw color 1, no clip window.
+  // Glyphs too large for a slot are not drawn there, only advanced over.
+  uint16_t drawUTF8(U8G2& u8g2, const Bitmap& bmp, int x, int y, const char* utf8);
+
+  // Advance of one glyph, as u8g2_GetGlyphWidth(); 0 if the font lacks it.
+  int8_t advance(U8G2& u8g2, uint16_t cp);
+  // What getUTF8Width() counts for cp as the last glyph of a string: its x
+  // offset plus bitmap width, or the advance for a blank glyph.
+  int8_t endWidth(U8G2& u8g2, uint16_t cp);
+  // Sum of the advances of the bytes of s, as drawStr() would move.
+  uint16_t strAdvance(U8G2& u8g2, const char* s);
+
+  // Drops the cached glyphs, e.g. after changing a font in place.
+  void clear();
+
+  uint32_t hits() const { return hits_; }
+  uint32_t misses() const { return misses_; }       // glyphs decoded into a slot
+  uint32_t fallbacks() const { return fallbacks_; } // glyphs drawn by u8g2
+
+private:
+  struct Slot
+  {
+    uint16_t cp;
+    bool used;
+    uint8_t age; // draws of other glyphs in this set since the last use
+    bool fits;   // bitmap is in cols; otherwise u8g2 draws this glyph
+    int8_t x;    // left edge relative to the pen position
+    int8_t top;  // top row relative to the baseline
+    uint8_t w;
+    uint8_t h;
+    int8_t adv;
+    uint16_t cols[kMaxW]; // bit r = row r of the glyph box
+  };
+
+  // Where blit() draws: buffer, row stride, visible area and draw color
+  struct Target
+  {
+    uint8_t* buf;
+    int16_t stride;
+    int16_t x0, y0, x1, y1;
+    uint8_t color;
+    bool frame; // the u8g2 frame buffer, so u8g2 can draw the fallbacks
+  };
+
+  static Target frameTarget(U8G2& u8g2);
+  void bind(U8G2& u8g2);
+  const uint8_t* glyphData(U8G2& u8g2, uint16_t cp) const;
+  const Slot& slot(U8G2& u8g2, uint16_t cp);
+  void decode(U8G2& u8g2, uint16_t cp, Slot& s);
+  int16_t drawGlyph(U8G2& u8g2, const Target& t, int16_t x, int16_t y, uint16_t cp, bool fast);
+  uint16_t drawUTF8(U8G2& u8g2, const Target& t, int x, int y, const char* utf8, bool fast);
+  static void blit(const Target& t, int16_t x, int16_t y, const Slot& s);
+
+  const uint8_t* font_;
+  uint16_t ascii_[0x80 - 0x20]; // offset of the glyph data from font_, 0 = absent
+  uint16_t wideCp_[kMaxIndexed];
+  uint16_t wideOff_[kMaxIndexed];
+  uint8_t wideCount_;
+  bool wideComplete_; // false: glyphs past kMaxIndexed exist, look those up in the font
+  Slot slots_[kSets][kWays];
+  uint32_t hits_;
+  uint32_t misses_;
+  uint32_t fallbacks_;
+};
+
+// Cache shared by the status screen and the text wrapping helpers.
+GlyphCache& glyphCache();
@@ -0,0 +1,232 @@
+#include "json_stream.h"
+#include <string.h>
+
+static bool isWs(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+JsonKeyScanner::JsonKeyScanner(const char* const* keys, uint8_t count)
+    : keys_(keys), count_(count > kMaxKeys ? kMaxKeys : count)
+{
+    reset();
+}
+
+void JsonKeyScanner::reset()
+{
+    state_ = State::Start;
+    escape_ = false;
+    depth_ = 0;
+    capture_ = -1;
+    keyLen_ = 0;
+    valueLen_ = 0;
+    found_ = 0;
+    truncated_ = 0;
+    seen_ = 0;
+    key_[0] = '\0';
+    for (uint8_t i = 0; i < kMaxKeys; i++)
+        values_[i][0] = '\0';
+}
+
+bool JsonKeyScanner::feed(const uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (finished())
+            return false;
+        seen_++;
+        if (!step((char)data[i]))
+        {
+            state_ = State::Error;
+            return false;
+        }
+    }
+    return !finished();
+}
+
+void JsonKeyScanner::beginValue()
+{
+    // the last key read decides whether this value is kept
+    capture_ = -1;
+    valueLen_ = 0;
+    if (keyLen_ > kMaxKeyLen)
+        return;
+    for (uint8_t i = 0; i < count_; i++)
+    {
+        if (!has(i) && strcmp(keys_[i], key_) == 0)
+        {
+            capture_ = (int8_t)i;
+            return;
+        }
+    }
+}
+
+void JsonKeyScanner::putValueChar(char c)
+{
+    if (capture_ < 0)
+        return;
+    if (valueLen_ < kMaxValueLen)
+        values_[capture_][valueLen_++] = c;
+    else
+        truncated_ |= (uint8_t)(1u << capture_);
+}
+
+void JsonKeyScanner::endValue()
+{
+    if (capture_ >= 0)
+    {
+        values_[capture_][valueLen_] = '\0';
+        found_ |= (uint8_t)(1u << capture_);
+    }
+    capture_ = -1;
+}
+
+bool JsonKeyScanner::step(char c)
+{
+    switch (state_)
+    {
+    case State::Start:
+        if (isWs(c))
+            return true;
+        if (c != '{')
+            return false;
+        state_ = State::KeyOrEnd;
+        return true;
+
+    case State::KeyOrEnd:
+        if (isWs(c))
+            return true;
+        if (c == '}')
+        {
+            state_ = State::Done;
+            return true;
+        }
+        if (c != '"')
+            return false;
+        keyLen_ = 0;
+        escape_ = false;
+        state_ = State::Key;
+        return true;
+
+    case State::Key:
+        if (escape_)
+            escape_ = false;
+        else if (c == '\\')
+            escape_ = true;
+        else if (c == '"')
+        {
+            key_[keyLen_ > kMaxKeyLen ? kMaxKeyLen : keyLen_] = '\0';
+            state_ = State::Colon;
+            return true;
+        }
+        // keep counting past the buffer so over-long keys never match
+        if (keyLen_ < kMaxKeyLen)
+            key_[keyLen_] = c;
+        if (keyLen_ <= kMaxKeyLen)
+            keyLen_++;
+        return true;
+
+    case State::Colon:
+        if (isWs(c))
+            return true;
+        if (c != ':')
+            return false;
+        beginValue();
+        state_ = State::Value;
+        return true;
+
+    case State::Value:
+        if (isWs(c))
+            return true;
+        if (c == '"')
+        {
+            escape_ = false;
+            state_ = State::String;
+            return true;
+        }
+        if (c == '{' || c == '[')
+        {
+            capture_ = -1; // containers are skipped, never captured
+            depth_ = 1;
+            state_ = State::Nested;
+            return true;
+        }
+        if (c == ',' || c == '}' || c == ':' || c == ']')
+            return false;
+        putValueChar(c);
+        state_ = State::Scalar;
+        return true;
+
+    case State::String:
+        if (escape_)
+            escape_ = false;
+        else if (c == '\\')
+            escape_ = true;
+        else if (c == '"')
+        {
+            endValue();
+            state_ = State::CommaOrEnd;
+            return true;
+        }
+        else if ((uint8_t)c < 0x20)
+            return false;
+        putValueChar(c);
+        return true;
+
+    case State::Scalar:
+        if (c == ',' || c == '}' || isWs(c))
+        {
+            endValue();
+            state_ = State::CommaOrEnd;
+            return step(c);
+        }
+        if (c == '"' || c == '{' || c == '[' || c == ':')
+            return false;
+        putValueChar(c);
+        return true;
+
+    case State::Nested:
+        if (c == '"')
+        {
+            escape_ = false;
+            state_ = State::NestedStr;
+        }
+        else if (c == '{' || c == '[')
+        {
+            if (++depth_ == 0)
+                return false; // absurd nesting
+        }
+        else if (c == '}' || c == ']')
+        {
+            if (--depth_ == 0)
+                state_ = State::CommaOrEnd;
+        }
+        return true;
+
+    case State::NestedStr:
+        if (escape_)
+            escape_ = false;
+        else if (c == '\\')
+            escape_ = true;
+        else if (c == '"')
+            state_ = State::Nested;
+        return true;
+
+    case State::CommaOrEnd:
+        if (isWs(c))
+            return true;
+        if (c == ',')
+        {
+            state_ = State::KeyOrEnd;
+            return true;
+        }
+        if (c == '}')
+        {
+            state_ = State::Done;
+            return true;
+        }
+        return false;
+
+    case State::Done:
+    case State::Error:
+        return false;
+    }
+    return false;
+}
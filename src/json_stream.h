@@ -0,0 +1,72 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Incremental scanner that pulls a few top-level keys out of a JSON object
+// as bytes arrive, without buffering the document. Values are kept as raw
+// text: string contents without the quotes (escapes left as-is) or the bare
+// scalar token (number, true, false, null). Nested objects and arrays are
+// skipped. Memory use is sizeof(JsonKeyScanner) regardless of payload size.
+class JsonKeyScanner
+{
+public:
+    static constexpr uint8_t kMaxKeys = 4;
+    static constexpr uint8_t kMaxKeyLen = 16;   // longer keys never match
+    static constexpr uint8_t kMaxValueLen = 40; // longer values are marked truncated
+
+    // keys must outlive the scanner
+    JsonKeyScanner(const char* const* keys, uint8_t count);
+
+    void reset();
+
+    // Consumes bytes; returns false once there is no point feeding more
+    // (all keys found, object closed, or malformed input).
+    bool feed(const uint8_t* data, size_t len);
+
+    bool complete() const { return found_ == allMask(); } // every key seen
+    bool finished() const { return state_ == State::Done || state_ == State::Error || complete(); }
+    bool failed() const { return state_ == State::Error; }
+
+    bool has(uint8_t idx) const { return (found_ >> idx) & 1; }
+    bool truncated(uint8_t idx) const { return (truncated_ >> idx) & 1; }
+    // "" until the key's whole value is in
+    const char* value(uint8_t idx) const { return has(idx) ? values_[idx] : ""; }
+    size_t bytesSeen() const { return seen_; }
+
+private:
+    enum class State : uint8_t
+    {
+        Start,      // before '{'
+        KeyOrEnd,   // after '{' or ','
+        Key,        // inside a key string
+        Colon,      // after the key
+        Value,      // before a value
+        String,     // inside a string value
+        Scalar,     // inside a number/literal
+        Nested,     // skipping an object/array value
+        NestedStr,  // string inside a skipped value
+        CommaOrEnd, // after a value
+        Done,
+        Error,
+    };
+
+    uint8_t allMask() const { return (uint8_t)((1u << count_) - 1); }
+    void beginValue();
+    void putValueChar(char c);
+    void endValue();
+    bool step(char c);
+
+    const char* const* keys_;
+    uint8_t count_;
+    State state_;
+    bool escape_;
+    uint8_t depth_;     // nesting depth while skipping
+    int8_t capture_;    // key index whose value is being read, -1 = none
+    uint8_t keyLen_;
+    uint8_t valueLen_;
+    uint8_t found_;
+    uint8_t truncated_;
+    size_t seen_;
+    char key_[kMaxKeyLen + 1];
+    char values_[kMaxKeys][kMaxValueLen + 1];
+};
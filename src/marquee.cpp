@@ -0,0 +1,98 @@
+#include "marquee.h"
+#include "glyph_cache.h"
+#include <U8g2lib.h>
+#include <string.h>
+
+Marquee::Marquee() : width_(0), offset_(0), lastMs_(0), started_(false), x_(0), w_(128), page_(0)
+{
+  memset(strip_, 0, sizeof(strip_));
+  text_[0] = '\0';
+}
+
+void Marquee::place(uint8_t x, uint8_t w, uint8_t page)
+{
+  x_ = x;
+  w_ = w;
+  page_ = page;
+}
+
+bool Marquee::setText(U8G2& u8g2, const char* utf8)
+{
+  // What fits, cut back to a codepoint boundary as wrapNextLine() breaks, so
+  // text_ never ends in the lead bytes of a split sequence
+  size_t n = strnlen(utf8, kMaxText - 1);
+  if (utf8[n])
+    while (n > 0 && ((uint8_t)utf8[n] & 0xC0) == 0x80)
+      n--;
+  if (strlen(text_) == n && memcmp(text_, utf8, n) == 0)
+    return false;
+  memcpy(text_, utf8, n);
+  text_[n] = '\0';
+
+  memset(strip_, 0, sizeof(strip_));
+  const GlyphCache::Bitmap bmp{&strip_[0][0], kMaxCols, kPages * 8};
+  const u8g2_t* g = u8g2.getU8g2();
+  const int16_t baseline = g->font_info.max_char_height + g->font_info.y_offset;
+  const uint16_t w = glyphCache().drawUTF8(u8g2, bmp, 0, baseline, text_);
+  width_ = w < kMaxCols ? w : kMaxCols;
+  offset_ = 0;
+  started_ = false;
+  return true;
+}
+
+bool Marquee::advance(uint32_t nowMs)
+{
+  if (!scrolling())
+    return false;
+  if (!started_)
+  {
+    started_ = true;
+    lastMs_ = nowMs;
+    return false;
+  }
+  const uint32_t steps = (nowMs - lastMs_) / kStepMs;
+  if (steps == 0)
+    return false;
+  lastMs_ += steps * kStepMs;
+  const uint16_t period = width_ + kGap;
+  offset_ = (uint16_t)((offset_ + steps) % period);
+  return true;
+}
+
+void Marquee::draw(U8G2& u8g2) const
+{
+  const uint16_t stride = (uint16_t)u8g2.getBufferTileWidth() * 8;
+  const uint8_t pages = u8g2.getBufferTileHeight();
+  const uint8_t w = x_ + w_ <= stride ? w_ : (uint8_t)(stride - x_);
+  const uint16_t period = width_ + kGap;
+  for (uint8_t p = 0; p < kPages && page_ + p < pages; p++)
+  {
+    uint8_t* dst = u8g2.getBufferPtr() + (page_ + p) * stride + x_;
+    if (!scrolling())
+    {
+      // the whole text and blank after it; no gap, no second copy
+      memcpy(dst, &strip_[p][0], width_ < w ? width_ : w);
+      if (width_ < w)
+        memset(dst + width_, 0, w - width_);
+      continue;
+    }
+    // the window runs along the strip, then the gap, then the strip again
+    uint16_t col = offset_;
+    for (uint8_t i = 0; i < w;)
+    {
+      uint16_t n;
+      if (col < width_)
+      {
+        n = width_ - col < w - i ? width_ - col : w - i;
+        memcpy(dst + i, &strip_[p][col], n);
+      }
+      else
+      {
+        n = period - col < w - i ? period - col : w - i;
+        memset(dst + i, 0, n);
+      }
+      i += n;
+      col = (uint16_t)((col + n) % period);
+    }
+  }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <Arduino.h>
+
+class U8G2;
+
+// Horizontally scrolling text line.
+//
+// setText() renders the string once, through glyphCache(), into an
+// off-screen strip in the frame buffer's page layout. After that the strip is
+// only copied: scrolling by one pixel is moving the window one column along
+// the strip, so draw() is one or two memcpy()s per page and never touches a
+// glyph. The window sits on whole pages of the frame buffer, so the diffing
+// flush in Oled sends just the tiles under it.
+//
+// Text that fits the window stands still at its left edge. Longer text runs
+// right to left at one pixel per kStepMs and comes round again after kGap
+// blank columns.
+class Marquee
+{
+public:
+  static constexpr uint16_t kMaxCols = 512; // strip width; longer text is cut
+  static constexpr uint8_t kPages = 2;      // strip height, 16 rows
+  static constexpr uint8_t kGap = 32;
+  static constexpr uint32_t kStepMs = 35; // ~28 frames/s
+  static constexpr uint8_t kMaxText = 64;
+
+  Marquee();
+
+  // Window: columns [x, x + w) of pages [page, page + kPages).
+  void place(uint8_t x, uint8_t w, uint8_t page);
+  // Renders utf8 into the strip with u8g2's current font, baseline at the
+  // font's ascent, and restarts the scroll. Returns false (and keeps the
+  // scroll position) if the text is unchanged.
+  bool setText(U8G2& u8g2, const char* utf8);
+  // Moves the scroll on to nowMs: one column per kStepMs elapsed, so a late
+  // call catches up instead of slowing down. Returns true if the window
+  // content changed and needs draw().
+  bool advance(uint32_t nowMs);
+  // Copies the visible part of the strip into the window.
+  void draw(U8G2& u8g2) const;
+
+  bool scrolling() const { return width_ > w_; }
+  uint16_t width() const { return width_; } // rendered text, in columns
+  uint16_t offset() const { return offset_; }
+  // The text in the strip: at most kMaxText - 1 bytes, cut on a codepoint boundary.
+  const char* text() const { return text_; }
+
+private:
+  uint8_t strip_[kPages][kMaxCols];
+  char text_[kMaxText]; // what the strip holds; "" leaves it blank
+  uint16_t width_;
+  uint16_t offset_; // strip column at the window's left edge, < width_ + kGap
+  uint32_t lastMs_;
+  bool started_;
+  uint8_t x_;
+  uint8_t w_;
+  uint8_t page_;
+};
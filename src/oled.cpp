@@ -1,58 +1,219 @@
 #include "oled.h"
+#include "frame_capture.h"
+#include "oled_transport.h"
+#include "profiler.h"
 #include <U8g2lib.h>
 
-// Your wiring:
-static constexpr uint8_t PIN_SDA = D5; // GPIO14
-static constexpr uint8_t PIN_SCL = D6; // GPIO12
+// Bus, pins and controller come from oled_transport.h (build flags)
+static OledTransport::Driver u8g2(OLED_DRIVER_ARGS);
 
-static U8G2_SSD1306_128X64_NONAME_F_SW_I2C u8g2(
-    U8G2_R0, PIN_SCL, PIN_SDA, U8X8_PIN_NONE);
+// Copy of the frame last pushed to the panel, in u8g2's tile layout
+// (one 128-byte row per 8-pixel page, 8 bytes per 8x8 tile).
+static constexpr uint8_t kTileBytes = 8;
+static uint8_t shadow[128 * 64 / 8];
+static bool shadowValid = false;
 
-// If blank but I2C is fine, try SH1106 instead:
-// static U8G2_SH1106_128X64_NONAME_F_SW_I2C u8g2(U8G2_R0, PIN_SCL, PIN_SDA, U8X8_PIN_NONE);
+// Frame being sent. It is copied out of the u8g2 buffer when the transfer
+// starts, so the next frame can be rendered while this one is on the bus.
+static uint8_t sending[sizeof(shadow)];
 
-Oled::Oled() {}
+// Most tiles handed to the bus by one pump() call. 4 tiles = 32 bytes, about
+// 2.5 ms over software I2C.
+static constexpr uint8_t kSliceTiles = 4;
+
+static bool tileChanged(const uint8_t* row, const uint8_t* old, uint8_t tx)
+{
+  return !shadowValid || memcmp(row + tx * kTileBytes, old + tx * kTileBytes, kTileBytes) != 0;
+}
+
+Oled::Oled()
+    : lastFrameBytes_(0), lastSendUs_(0), totalBytes_(0), totalSendUs_(0), frames_(0), lastWidgets_(0),
+      totalWidgets_(0), skippedFrames_(0), async_(true), busy_(false), queued_(false), invalidatePending_(false),
+      page_(0), tile_(0), frameStartUs_(0), frameBytes_(0), frameSendUs_(0), lastLatencyUs_(0), maxLatencyUs_(0),
+      lastSliceUs_(0), maxSliceUs_(0), tickerFrames_(0), screenId_(Screen::Status)
+{
+}
 Oled::~Oled() {}
 
 void Oled::init()
 {
 
+  if (OledTransport::kBusClockHz)
+    u8g2.setBusClock(OledTransport::kBusClockHz);
   u8g2.begin();
+  Serial.printf("[OLED] transport=%s clock=%u Hz\n", OledTransport::kName, (unsigned)OledTransport::kBusClockHz);
   u8g2.setFontMode(1);
   u8g2.setDrawColor(1);
+  invalidate();
 }
 
-void Oled::drawStatus(const UiStatus& s)
+void Oled::invalidate()
 {
-  u8g2.clearBuffer();
-
-  u8g2.setFont(u8g2_font_6x12_tf);
+  shadowValid = false;
+  // tiles already sent in the current pass are no longer known good either,
+  // so the frame after it goes out in full
+  if (busy_)
+  {
+    queued_ = true;
+    invalidatePending_ = true;
+  }
+  status_.invalidate();
+  clock_.invalidate();
+}
 
-  // Line 1: date + time
-  char dt[32];
-  snprintf(dt, sizeof(dt), "%s %s",
-           s.date_ymd ? s.date_ymd : "----------",
-           s.time_hms ? s.time_hms : "--:--:--");
+void Oled::setScreen(Screen screen)
+{
+  if (screen == screenId_)
+    return;
+  screenId_ = screen;
+  // the panel still shows the old frame, only the screen starts over
+  status_.invalidate();
+  clock_.invalidate();
+}
 
-  u8g2.drawStr(0, 14, dt);
+void Oled::setAsync(bool on)
+{
+  async_ = on;
+  if (!on)
+    finish();
+}
 
-  // Line 2: WiFi status (bottom)
-  char wline[64];
-  if (s.wifi_connected)
+void Oled::finish()
+{
+  while (pump())
   {
-    snprintf(wline, sizeof(wline), "WiFi:%s %ddBm",
-             s.wifi_ssid ? s.wifi_ssid : "-",
-             s.wifi_rssi);
   }
+}
+
+void Oled::beginFrame()
+{
+  memcpy(sending, u8g2.getBufferPtr(), sizeof(sending));
+  busy_ = true;
+  queued_ = false;
+  invalidatePending_ = false;
+  page_ = 0;
+  tile_ = 0;
+  frameStartUs_ = micros();
+  frameBytes_ = 0;
+  frameSendUs_ = 0;
+}
+
+void Oled::flush()
+{
+  // the panel layout is fixed at 128x64; anything else would overrun the copies
+  if ((uint16_t)u8g2.getBufferTileWidth() * u8g2.getBufferTileHeight() * kTileBytes != sizeof(shadow))
+    return;
+
+  if (busy_)
+    queued_ = true; // picked up when the frame on the bus is complete
   else
+    beginFrame();
+
+  if (!async_)
+    finish();
+}
+
+bool Oled::pump()
+{
+  if (!busy_)
+    return false;
+
+  PROF_SCOPE("flush");
+  const uint8_t tilesW = u8g2.getBufferTileWidth();
+  const uint8_t tilesH = u8g2.getBufferTileHeight();
+  const uint16_t rowBytes = (uint16_t)tilesW * kTileBytes;
+  const uint32_t t0 = micros();
+
+  // next tile that differs from what the panel shows
+  while (page_ < tilesH)
   {
-    snprintf(wline, sizeof(wline), "WiFi:%s (conn...)",
-             s.wifi_ssid ? s.wifi_ssid : "-");
+    const uint8_t* row = sending + page_ * rowBytes;
+    const uint8_t* old = shadow + page_ * rowBytes;
+    while (tile_ < tilesW && !tileChanged(row, old, tile_))
+      tile_++;
+    if (tile_ < tilesW)
+      break;
+    page_++;
+    tile_ = 0;
+  }
+
+  if (page_ < tilesH)
+  {
+    // the run of changed tiles from there, capped to one slice
+    uint8_t* row = sending + page_ * rowBytes;
+    uint8_t* old = shadow + page_ * rowBytes;
+    const uint8_t first = tile_;
+    uint8_t n = 0;
+    while (first + n < tilesW && n < kSliceTiles && tileChanged(row, old, first + n))
+      n++;
+
+    u8x8_DrawTile(u8g2.getU8x8(), first, page_, n, row + first * kTileBytes);
+    memcpy(old + first * kTileBytes, row + first * kTileBytes, n * kTileBytes);
+    tile_ += n;
+    frameBytes_ += n * kTileBytes;
   }
 
-  u8g2.drawStr(0, 30, wline);
+  const uint32_t us = micros() - t0;
+  lastSliceUs_ = us;
+  if (us > maxSliceUs_)
+    maxSliceUs_ = us;
+  frameSendUs_ += us;
 
-  u8g2.sendBuffer();
+  if (page_ < tilesH)
+    return true;
+
+  // every page scanned: the panel now shows this frame, unless invalidate()
+  // came in after some of its tiles had been skipped as unchanged
+  if (!invalidatePending_)
+    shadowValid = true;
+  lastLatencyUs_ = micros() - frameStartUs_;
+  if (lastLatencyUs_ > maxLatencyUs_)
+    maxLatencyUs_ = lastLatencyUs_;
+  lastFrameBytes_ = frameBytes_;
+  lastSendUs_ = frameSendUs_;
+  totalBytes_ += frameBytes_;
+  totalSendUs_ += frameSendUs_;
+  frames_++;
+
+  busy_ = false;
+  if (queued_)
+    beginFrame();
+  return busy_;
+}
+
+U8G2& Oled::gfx() { return u8g2; }
+
+void Oled::capture(Print& out, bool ascii) const
+{
+  writeFramePbm(out, u8g2.getBufferPtr(), u8g2.getBufferTileWidth(), u8g2.getBufferTileHeight(), ascii);
+}
+
+void Oled::drawStatus(const UiStatus& s)
+{
+  // nothing changed: no drawing and no bus traffic at all
+  if (render(s) == 0)
+  {
+    skippedFrames_++;
+    return;
+  }
+  flush();
+}
+
+uint8_t Oled::render(const UiStatus& s)
+{
+  const uint8_t n = screenId_ == Screen::Clock ? clock_.update(u8g2, s) : status_.update(u8g2, s);
+  lastWidgets_ = n;
+  totalWidgets_ += n;
+  return n;
+}
+
+bool Oled::animate(uint32_t nowMs)
+{
+  if (screenId_ != Screen::Status || !status_.animate(u8g2, nowMs))
+    return false;
+  tickerFrames_++;
+  flush();
+  return true;
 }
 
 // Internal instance used by legacy wrappers
@@ -1,13 +1,102 @@
 #pragma once
+#include "ui_clock.h"
 #include "ui_status.h"
+#include "ui_widgets.h"
 #include <Arduino.h>
 
+class U8G2;
+
 class Oled
 {
 public:
+  enum class Screen : uint8_t
+  {
+    Status, // date/time and WiFi as small text
+    Clock,  // big digits, see ClockScreen
+  };
+
   Oled();
   ~Oled();
 
   void init();
+  // Redraws the widgets whose inputs changed and sends the result; a frame
+  // with no changes is skipped entirely. In async mode this only queues the
+  // frame and pump() does the sending.
   void drawStatus(const UiStatus& s);
+  // Brings the frame buffer in line with s without sending it. Returns the
+  // number of widgets redrawn.
+  uint8_t render(const UiStatus& s);
+  // Moves the status screen's ticker on to nowMs and sends the frame if it
+  // scrolled; only the tiles under the ticker differ, so only those go out.
+  // Call it every Marquee::kStepMs or so. Returns true if a frame was sent.
+  bool animate(uint32_t nowMs);
+
+  // Which screen render() draws; switching redraws the new one in full.
+  void setScreen(Screen screen);
+  Screen screen() const { return screenId_; }
+
+  // The u8g2 instance, for drawing helpers such as drawWrappedUTF8().
+  U8G2& gfx();
+  // Current frame buffer as PBM (binary P4, or text P1 for the serial console).
+  void capture(Print& out, bool ascii = false) const;
+
+  // Forget what the panel shows; the next frame is drawn and sent in full.
+  void invalidate();
+
+  // Async mode (the default): a frame is copied aside and sent a few tiles
+  // per pump() call, so no single call holds the bus for a whole frame.
+  // Rendering meanwhile goes to the u8g2 buffer; a frame finished during a
+  // transfer is sent after the current one, never mixed into it. Turning
+  // async off sends any frame in flight, then every flush blocks until done.
+  void setAsync(bool on);
+  // Sends the next slice of the frame in flight. Returns true while more
+  // slices remain.
+  bool pump();
+  bool busy() const { return busy_; }
+
+  uint16_t lastFrameBytes() const { return lastFrameBytes_; } // payload bytes of the last frame sent
+  uint32_t lastSendUs() const { return lastSendUs_; }         // bus time of the last frame, all slices
+  uint32_t totalBytes() const { return totalBytes_; }
+  uint32_t totalSendUs() const { return totalSendUs_; }
+  uint32_t frames() const { return frames_; }
+  uint8_t lastWidgets() const { return lastWidgets_; } // widgets redrawn by the last render
+  uint32_t totalWidgets() const { return totalWidgets_; }
+  uint32_t skippedFrames() const { return skippedFrames_; } // drawStatus() calls with nothing to do
+  uint32_t lastLatencyUs() const { return lastLatencyUs_; }  // flush() to last tile on the panel
+  uint32_t maxLatencyUs() const { return maxLatencyUs_; }
+  uint32_t lastSliceUs() const { return lastSliceUs_; } // one pump() call
+  uint32_t maxSliceUs() const { return maxSliceUs_; }   // longest the bus held the CPU in one go
+  uint32_t tickerFrames() const { return tickerFrames_; } // frames sent by animate()
+
+private:
+  // Sends only the tiles that differ from the last transmitted frame.
+  void flush();
+  void beginFrame();
+  void finish();
+
+  uint16_t lastFrameBytes_;
+  uint32_t lastSendUs_;
+  uint32_t totalBytes_;
+  uint32_t totalSendUs_;
+  uint32_t frames_;
+  uint8_t lastWidgets_;
+  uint32_t totalWidgets_;
+  uint32_t skippedFrames_;
+  bool async_;
+  bool busy_;   // a frame is in flight
+  bool queued_; // another one is waiting in the u8g2 buffer
+  bool invalidatePending_; // invalidate() hit a frame in flight; the shadow is only good after the next one
+  uint8_t page_;
+  uint8_t tile_;
+  uint32_t frameStartUs_;
+  uint16_t frameBytes_;
+  uint32_t frameSendUs_;
+  uint32_t lastLatencyUs_;
+  uint32_t maxLatencyUs_;
+  uint32_t lastSliceUs_;
+  uint32_t maxSliceUs_;
+  uint32_t tickerFrames_;
+  Screen screenId_;
+  StatusScreen status_;
+  ClockScreen clock_;
 };
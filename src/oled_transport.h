@@ -0,0 +1,80 @@
+#pragma once
+#include <U8g2lib.h>
+
+// Display bus and controller are picked at compile time, so the u8g2 object is
+// a concrete type and there is no runtime dispatch. Select in platformio.ini:
+//   build_flags = -DOLED_TRANSPORT=OLED_TRANSPORT_HW_I2C -DOLED_I2C_HZ=800000
+//   build_flags = -DOLED_CONTROLLER_SH1106   (if blank but I2C is fine)
+#define OLED_TRANSPORT_SW_I2C 0
+#define OLED_TRANSPORT_HW_I2C 1
+#define OLED_TRANSPORT_SPI 2
+
+#ifndef OLED_TRANSPORT
+#define OLED_TRANSPORT OLED_TRANSPORT_SW_I2C
+#endif
+
+// Your wiring (I2C):
+#ifndef OLED_PIN_SDA
+#define OLED_PIN_SDA D5 // GPIO14
+#endif
+#ifndef OLED_PIN_SCL
+#define OLED_PIN_SCL D6 // GPIO12
+#endif
+
+// SPI wiring: SCK = D5, MOSI = D7 are fixed by the HSPI peripheral.
+#ifndef OLED_PIN_CS
+#define OLED_PIN_CS D8
+#endif
+#ifndef OLED_PIN_DC
+#define OLED_PIN_DC D3
+#endif
+#ifndef OLED_PIN_RST
+#define OLED_PIN_RST U8X8_PIN_NONE
+#endif
+
+#ifndef OLED_I2C_HZ
+#define OLED_I2C_HZ 400000
+#endif
+#ifndef OLED_SPI_HZ
+#define OLED_SPI_HZ 8000000
+#endif
+
+// Constructor arguments for OledTransport::Driver
+#if OLED_TRANSPORT == OLED_TRANSPORT_SW_I2C
+#define OLED_DRIVER_ARGS U8G2_R0, OLED_PIN_SCL, OLED_PIN_SDA, U8X8_PIN_NONE
+#elif OLED_TRANSPORT == OLED_TRANSPORT_HW_I2C
+#define OLED_DRIVER_ARGS U8G2_R0, U8X8_PIN_NONE, OLED_PIN_SCL, OLED_PIN_SDA
+#elif OLED_TRANSPORT == OLED_TRANSPORT_SPI
+#define OLED_DRIVER_ARGS U8G2_R0, OLED_PIN_CS, OLED_PIN_DC, OLED_PIN_RST
+#endif
+
+struct OledTransport
+{
+#if OLED_TRANSPORT == OLED_TRANSPORT_SW_I2C
+#ifdef OLED_CONTROLLER_SH1106
+  using Driver = U8G2_SH1106_128X64_NONAME_F_SW_I2C;
+#else
+  using Driver = U8G2_SSD1306_128X64_NONAME_F_SW_I2C;
+#endif
+  static constexpr const char* kName = "sw-i2c";
+  static constexpr uint32_t kBusClockHz = 0; // bit-banged, no clock setting
+#elif OLED_TRANSPORT == OLED_TRANSPORT_HW_I2C
+#ifdef OLED_CONTROLLER_SH1106
+  using Driver = U8G2_SH1106_128X64_NONAME_F_HW_I2C;
+#else
+  using Driver = U8G2_SSD1306_128X64_NONAME_F_HW_I2C;
+#endif
+  static constexpr const char* kName = "hw-i2c";
+  static constexpr uint32_t kBusClockHz = OLED_I2C_HZ;
+#elif OLED_TRANSPORT == OLED_TRANSPORT_SPI
+#ifdef OLED_CONTROLLER_SH1106
+  using Driver = U8G2_SH1106_128X64_NONAME_F_4W_HW_SPI;
+#else
+  using Driver = U8G2_SSD1306_128X64_NONAME_F_4W_HW_SPI;
+#endif
+  static constexpr const char* kName = "spi";
+  static constexpr uint32_t kBusClockHz = OLED_SPI_HZ;
+#else
+#error "Unknown OLED_TRANSPORT"
+#endif
+};
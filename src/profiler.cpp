@@ -0,0 +1,141 @@
+#include "profiler.h"
+#include <string.h>
+
+struct ProfSlot
+{
+  const char* name;
+  uint32_t count;
+  uint64_t total;
+  uint64_t self; // total minus the scopes nested inside
+  uint32_t max;
+  uint32_t hist[Profiler::kBuckets];
+};
+
+static ProfSlot slots[Profiler::kMaxScopes];
+static uint8_t slotCount = 0;
+
+// Open scopes: cycles spent in the scopes nested in each one so far
+static uint32_t childCycles[Profiler::kMaxDepth];
+static uint8_t depth = 0;
+
+// Worst single sample since reset
+static uint8_t stallId = Profiler::kNoScope;
+static uint32_t stallCycles = 0;
+static uint32_t stallAtMs = 0;
+
+uint32_t Profiler::cyclesPerUs()
+{
+#ifdef ESP8266
+  return ESP.getCpuFreqMHz();
+#else
+  return 1000;
+#endif
+}
+
+uint8_t Profiler::scope(const char* name)
+{
+  for (uint8_t i = 0; i < slotCount; i++)
+  {
+    if (slots[i].name == name || strcmp(slots[i].name, name) == 0)
+      return i;
+  }
+  if (slotCount >= kMaxScopes)
+    return kNoScope;
+  slots[slotCount].name = name;
+  return slotCount++;
+}
+
+void Profiler::enter()
+{
+  if (depth < kMaxDepth)
+    childCycles[depth] = 0;
+  depth++;
+}
+
+void Profiler::record(uint8_t id, uint32_t cycles)
+{
+  // close the scope: hand its time to the enclosing one, keep the rest as self
+  uint32_t self = cycles;
+  if (depth)
+  {
+    depth--;
+    if (depth < kMaxDepth)
+      self = childCycles[depth] < cycles ? cycles - childCycles[depth] : 0;
+    if (depth && depth <= kMaxDepth)
+      childCycles[depth - 1] += cycles;
+  }
+
+  if (id >= slotCount)
+    return;
+  ProfSlot& s = slots[id];
+  s.count++;
+  s.total += cycles;
+  s.self += self;
+  if (cycles > s.max)
+    s.max = cycles;
+
+  const uint32_t scaled = cycles >> kBucketShift;
+  uint8_t b = scaled ? (uint8_t)(32 - __builtin_clz(scaled)) : 0;
+  if (b >= kBuckets)
+    b = kBuckets - 1;
+  s.hist[b]++;
+
+  if (cycles > stallCycles)
+  {
+    stallCycles = cycles;
+    stallId = id;
+    stallAtMs = millis();
+  }
+}
+
+void Profiler::reset()
+{
+  for (uint8_t i = 0; i < slotCount; i++)
+  {
+    ProfSlot& s = slots[i];
+    s.count = 0;
+    s.total = 0;
+    s.self = 0;
+    s.max = 0;
+    memset(s.hist, 0, sizeof(s.hist));
+  }
+  stallId = kNoScope;
+  stallCycles = 0;
+  stallAtMs = 0;
+}
+
+void Profiler::dump(Print& out)
+{
+  const uint32_t perUs = cyclesPerUs();
+  uint64_t all = 0; // self times never overlap, so this is the profiled time
+  for (uint8_t i = 0; i < slotCount; i++)
+    all += slots[i].self;
+
+  out.printf("[Prof] %-8s %8s %9s %9s %9s %5s  histogram (bucket upper bound: count)\n", "scope", "count",
+             "avg_us", "max_us", "self_us", "share");
+  for (uint8_t i = 0; i < slotCount; i++)
+  {
+    const ProfSlot& s = slots[i];
+    const uint32_t avg = s.count ? (uint32_t)(s.total / s.count / perUs) : 0;
+    const uint32_t avgSelf = s.count ? (uint32_t)(s.self / s.count / perUs) : 0;
+    const uint32_t share = all ? (uint32_t)(s.self * 1000 / all) : 0; // per mille
+    out.printf("[Prof] %-8s %8u %9u %9u %9u %3u.%u%% ", s.name, s.count, avg, s.max / perUs, avgSelf, share / 10,
+               share % 10);
+    for (uint8_t b = 0; b < kBuckets; b++)
+    {
+      if (!s.hist[b])
+        continue;
+      // bucket b holds samples below 2^b << kBucketShift cycles; the last one is open
+      const uint64_t boundNs = ((uint64_t)1000 << (b + kBucketShift)) / perUs;
+      if (b == kBuckets - 1)
+        out.printf(" >:%u", s.hist[b]);
+      else if (boundNs < 1000)
+        out.printf(" %uns:%u", (uint32_t)boundNs, s.hist[b]);
+      else
+        out.printf(" %uus:%u", (uint32_t)(boundNs / 1000), s.hist[b]);
+    }
+    out.printf("\n");
+  }
+  if (stallId != kNoScope)
+    out.printf("[Prof] worst stall %u us in '%s' at %u ms\n", stallCycles / perUs, slots[stallId].name, stallAtMs);
+}
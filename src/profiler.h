@@ -0,0 +1,76 @@
+#pragma once
+#include <Arduino.h>
+#ifndef ESP8266
+#include <time.h>
+#endif
+
+// Cycle-counter profiler for named scopes, cheap enough to stay on.
+//
+//   void Foo::update()
+//   {
+//     PROF_SCOPE("foo");
+//     ...
+//   }
+//
+// Each scope keeps a count, a total, a maximum and a histogram with
+// power-of-two buckets. A sample costs two cycle-counter reads, a clz and a
+// few adds. The worst stall across all scopes is kept with its name and
+// time. Nothing allocates; scopes past kMaxScopes are ignored.
+//
+// Scopes may nest. Each one also keeps its self time, without the scopes
+// nested in it, and shares are taken from that, so they add up to 100%.
+class Profiler
+{
+public:
+  static constexpr uint8_t kMaxScopes = 12;
+  static constexpr uint8_t kBuckets = 20;
+  // bucket b >= 1 holds [2^(b-1), 2^b) << kBucketShift cycles, bucket 0 less
+  static constexpr uint8_t kBucketShift = 6;
+  static constexpr uint8_t kNoScope = 0xFF;
+  static constexpr uint8_t kMaxDepth = 8; // deeper scopes count as their parent's self time
+
+  // Device: CCOUNT at the CPU clock. Host: CLOCK_MONOTONIC in ns.
+  static inline uint32_t cycles()
+  {
+#ifdef ESP8266
+    return ESP.getCycleCount();
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+#endif
+  }
+  static uint32_t cyclesPerUs();
+
+  // Returns the id for name (string literal, compared by pointer then text).
+  static uint8_t scope(const char* name);
+  // A timed block opens with enter() and closes with record().
+  static void enter();
+  static void record(uint8_t id, uint32_t cycles);
+
+  static void reset();
+  // Table of scopes: count, avg/max us, avg self us, share of profiled self time, histogram.
+  static void dump(Print& out);
+};
+
+// Times the enclosing block.
+class ProfScope
+{
+public:
+  explicit ProfScope(uint8_t id) : id_(id)
+  {
+    Profiler::enter();
+    start_ = Profiler::cycles();
+  }
+  ~ProfScope() { Profiler::record(id_, Profiler::cycles() - start_); }
+
+private:
+  uint8_t id_;
+  uint32_t start_;
+};
+
+#define PROF_CAT2(a, b) a##b
+#define PROF_CAT(a, b) PROF_CAT2(a, b)
+#define PROF_SCOPE(name)                                                \
+  static const uint8_t PROF_CAT(profId_, __LINE__) = Profiler::scope(name); \
+  ProfScope PROF_CAT(profScope_, __LINE__)(PROF_CAT(profId_, __LINE__))
@@ -0,0 +1,42 @@
+#include "rtc_store.h"
+#include <user_interface.h>
+
+bool EspRtcStore::read(uint32_t offsetWords, void* data, size_t bytes)
+{
+  return ESP.rtcUserMemoryRead(offsetWords, (uint32_t*)data, bytes);
+}
+
+bool EspRtcStore::write(uint32_t offsetWords, const void* data, size_t bytes)
+{
+  return ESP.rtcUserMemoryWrite(offsetWords, (uint32_t*)data, bytes);
+}
+
+bool EspRtcStore::warmBoot() const
+{
+  const rst_info* info = ESP.getResetInfoPtr();
+  if (!info)
+    return false;
+  switch (info->reason)
+  {
+  case REASON_WDT_RST:
+  case REASON_EXCEPTION_RST:
+  case REASON_SOFT_WDT_RST:
+  case REASON_SOFT_RESTART:
+    return true;
+  default: // REASON_DEFAULT_RST (power on), REASON_DEEP_SLEEP_AWAKE, REASON_EXT_SYS_RST (pin held for any time)
+    return false;
+  }
+}
+
+uint32_t crc32(const void* data, size_t len)
+{
+  const uint8_t* p = (const uint8_t*)data;
+  uint32_t crc = 0xFFFFFFFFUL;
+  while (len--)
+  {
+    crc ^= *p++;
+    for (uint8_t i = 0; i < 8; i++)
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+  }
+  return ~crc;
+}
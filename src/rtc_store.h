@@ -0,0 +1,35 @@
+#pragma once
+#include <Arduino.h>
+
+// Small persistent store that survives a warm reset (ESP8266 RTC user memory,
+// 512 bytes addressed in 4-byte words). Kept behind an interface so the
+// restore/corruption/staleness logic of its users can run against a fake.
+class RtcStore
+{
+public:
+  virtual ~RtcStore() {}
+
+  // offsetWords is in 4-byte words; bytes must be a multiple of 4.
+  virtual bool read(uint32_t offsetWords, void* data, size_t bytes) = 0;
+  virtual bool write(uint32_t offsetWords, const void* data, size_t bytes) = 0;
+
+  // True when the last reset kept the memory and took negligible time
+  // (software restart, watchdog, exception). Power-on, deep-sleep wake-ups
+  // and the reset pin return false: the time spent off is unknown.
+  virtual bool warmBoot() const = 0;
+};
+
+// Word offsets of each user's record, keep them from overlapping.
+static constexpr uint32_t kRtcSlotTime = 0; // TimeMgr checkpoint, 8 words
+static constexpr uint32_t kRtcSlotWifi = 8; // WifiMgr fast-reconnect cache, 9 words
+
+class EspRtcStore : public RtcStore
+{
+public:
+  bool read(uint32_t offsetWords, void* data, size_t bytes) override;
+  bool write(uint32_t offsetWords, const void* data, size_t bytes) override;
+  bool warmBoot() const override;
+};
+
+// CRC-32 (IEEE, reflected), bitwise: records are a few dozen bytes.
+uint32_t crc32(const void* data, size_t len);
@@ -0,0 +1,241 @@
+#include "scheduler.h"
+
+static uint32_t defaultClock() { return millis(); }
+
+Scheduler::Scheduler(Task* tasks, TaskId* heap, TaskId capacity, ClockFn clock)
+    : clock_(clock ? clock : defaultClock), tasks_(tasks), heap_(heap), capacity_(capacity), heapLen_(0),
+      heapSteps_(0)
+{
+}
+
+void Scheduler::init()
+{
+  heapLen_ = 0;
+  for (TaskId i = 0; i < capacity_; i++)
+    tasks_[i].heapPos = kNoTask;
+  resetStats();
+}
+
+uint32_t Scheduler::now() const { return clock_(); }
+
+Scheduler::TaskId Scheduler::every(const char* name, uint32_t periodMs, TaskFn fn, void* ctx, uint32_t firstDelayMs)
+{
+  if (periodMs == 0)
+    return kNoTask;
+  return add(name, firstDelayMs, periodMs, fn, ctx);
+}
+
+Scheduler::TaskId Scheduler::after(const char* name, uint32_t delayMs, TaskFn fn, void* ctx)
+{
+  return add(name, delayMs, 0, fn, ctx);
+}
+
+Scheduler::TaskId Scheduler::add(const char* name, uint32_t delayMs, uint32_t periodMs, TaskFn fn, void* ctx)
+{
+  if (!fn || heapLen_ >= capacity_)
+    return kNoTask;
+
+  TaskId id = 0;
+  while (tasks_[id].heapPos != kNoTask)
+    id++;
+
+  Task& t = tasks_[id];
+  t.name = name;
+  t.fn = fn;
+  t.ctx = ctx;
+  t.due = now() + delayMs;
+  t.period = periodMs;
+  t.stats = TaskStats{0, UINT32_MAX, 0, 0, 0};
+
+  place(heapLen_, id);
+  heapLen_++;
+  siftUp(t.heapPos);
+  return id;
+}
+
+bool Scheduler::cancel(TaskId id)
+{
+  if (!live(id))
+    return false;
+  removeAt(tasks_[id].heapPos);
+  return true;
+}
+
+bool Scheduler::runIn(TaskId id, uint32_t delayMs)
+{
+  if (!live(id))
+    return false;
+  tasks_[id].due = now() + delayMs;
+  fix(tasks_[id].heapPos);
+  return true;
+}
+
+bool Scheduler::setPeriod(TaskId id, uint32_t periodMs)
+{
+  if (!live(id) || periodMs == 0)
+    return false;
+  tasks_[id].period = periodMs;
+  return true;
+}
+
+uint32_t Scheduler::runDue()
+{
+  // Bound the pass so a task that keeps rescheduling itself at "now" cannot
+  // starve the caller.
+  for (TaskId n = 0; heapLen_ > 0 && n < capacity_; n++)
+  {
+    const TaskId id = heap_[0];
+    Task& t = tasks_[id];
+    const uint32_t start = now();
+    const uint32_t late = start - t.due;
+    if ((int32_t)late < 0)
+      break;
+
+    if (t.period)
+    {
+      t.due += t.period;
+      if ((int32_t)(start - t.due) >= 0)
+        t.due = start + t.period; // more than a period behind: skip the missed runs
+      siftDown(0);
+    }
+    else
+    {
+      removeAt(0);
+    }
+
+    TaskStats& s = t.stats;
+    s.runs++;
+    s.lateSumMs += late;
+    if (late < s.lateMinMs)
+      s.lateMinMs = late;
+    if (late > s.lateMaxMs)
+      s.lateMaxMs = late;
+
+    // A one-shot may re-register itself into the same slot from its callback,
+    // so copy what is needed before the call.
+    const TaskFn fn = t.fn;
+    void* const ctx = t.ctx;
+    const uint32_t us0 = micros();
+    fn(ctx);
+    const uint32_t us = micros() - us0;
+    if (us > s.runUsMax)
+      s.runUsMax = us;
+  }
+
+  if (heapLen_ == 0)
+    return kMaxIdleMs;
+  const int32_t wait = (int32_t)(tasks_[heap_[0]].due - now());
+  return wait > 0 ? (uint32_t)wait : 0;
+}
+
+void Scheduler::idle(uint32_t waitMs)
+{
+  if (waitMs > kMaxIdleMs)
+    waitMs = kMaxIdleMs;
+  if (waitMs)
+    delay(waitMs);
+  else
+    yield();
+}
+
+const Scheduler::TaskStats* Scheduler::stats(TaskId id) const
+{
+  if (!live(id))
+    return nullptr;
+  return &tasks_[id].stats;
+}
+
+void Scheduler::resetStats()
+{
+  for (TaskId i = 0; i < capacity_; i++)
+    tasks_[i].stats = TaskStats{0, UINT32_MAX, 0, 0, 0};
+  heapSteps_ = 0;
+}
+
+void Scheduler::report(Print& out) const
+{
+  for (TaskId i = 0; i < capacity_; i++)
+  {
+    const Task& t = tasks_[i];
+    if (t.heapPos == kNoTask)
+      continue;
+    const TaskStats& s = t.stats;
+    if (s.runs == 0)
+    {
+      out.printf("[Sched] %-6s runs=0\n", t.name);
+      continue;
+    }
+    out.printf("[Sched] %-6s runs=%u late(ms) min=%u avg=%u max=%u jitter=%u run_max=%uus\n", t.name, s.runs,
+               s.lateMinMs, s.lateSumMs / s.runs, s.lateMaxMs, s.lateMaxMs - s.lateMinMs, s.runUsMax);
+  }
+}
+
+// ---- heap ----
+
+bool Scheduler::before(TaskId a, TaskId b) const
+{
+  // wrap-safe, ties broken by id so equal deadlines run in registration order
+  const int32_t d = (int32_t)(tasks_[a].due - tasks_[b].due);
+  return d < 0 || (d == 0 && a < b);
+}
+
+void Scheduler::place(TaskId pos, TaskId id)
+{
+  heap_[pos] = id;
+  tasks_[id].heapPos = pos;
+}
+
+void Scheduler::siftUp(TaskId pos)
+{
+  const TaskId id = heap_[pos];
+  while (pos > 0)
+  {
+    const TaskId parent = (pos - 1) / 2;
+    if (!before(id, heap_[parent]))
+      break;
+    place(pos, heap_[parent]);
+    pos = parent;
+    heapSteps_++;
+  }
+  place(pos, id);
+}
+
+void Scheduler::siftDown(TaskId pos)
+{
+  const TaskId id = heap_[pos];
+  for (;;)
+  {
+    const uint32_t left = (uint32_t)pos * 2 + 1;
+    if (left >= heapLen_)
+      break;
+    TaskId child = (TaskId)left;
+    if (child + 1 < heapLen_ && before(heap_[child + 1], heap_[child]))
+      child++;
+    if (!before(heap_[child], id))
+      break;
+    place(pos, heap_[child]);
+    pos = child;
+    heapSteps_++;
+  }
+  place(pos, id);
+}
+
+void Scheduler::fix(TaskId pos)
+{
+  if (pos > 0 && before(heap_[pos], heap_[(pos - 1) / 2]))
+    siftUp(pos);
+  else
+    siftDown(pos);
+}
+
+void Scheduler::removeAt(TaskId pos)
+{
+  const TaskId id = heap_[pos];
+  heapLen_--;
+  if (pos != heapLen_)
+  {
+    place(pos, heap_[heapLen_]);
+    fix(pos);
+  }
+  tasks_[id].heapPos = kNoTask;
+}
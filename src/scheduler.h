@@ -0,0 +1,113 @@
+#pragma once
+#include <Arduino.h>
+
+// Cooperative deadline scheduler for the main loop.
+//
+// Tasks are plain callbacks with a context pointer, registered as periodic
+// (every) or one-shot (after). Deadlines are kept in a binary min-heap over a
+// fixed task table, so there is no heap allocation and runDue() costs
+// O(log n) per task run plus O(1) when nothing is due. Periodic tasks advance
+// by whole periods from their previous deadline, so they do not drift; a task
+// that fell more than a period behind skips the missed runs.
+//
+// The table lives in StaticScheduler<Capacity> below; this class is the
+// capacity-independent part, so the code is compiled once.
+class Scheduler
+{
+public:
+  using TaskFn = void (*)(void* ctx);
+  using ClockFn = uint32_t (*)(); // ms, wrapping like millis()
+  using TaskId = uint16_t;
+
+  static constexpr TaskId kNoTask = 0xFFFF;
+  static constexpr uint32_t kMaxIdleMs = 50; // longest single wait in idle()
+
+  struct TaskStats
+  {
+    uint32_t runs;
+    uint32_t lateMinMs; // how long after its deadline the task actually ran
+    uint32_t lateMaxMs;
+    uint32_t lateSumMs;
+    uint32_t runUsMax; // longest callback
+  };
+
+  Scheduler(const Scheduler&) = delete;
+  Scheduler& operator=(const Scheduler&) = delete;
+
+  // Returns the task id, or kNoTask when the table is full.
+  TaskId every(const char* name, uint32_t periodMs, TaskFn fn, void* ctx, uint32_t firstDelayMs = 0);
+  TaskId after(const char* name, uint32_t delayMs, TaskFn fn, void* ctx);
+  bool cancel(TaskId id);
+
+  // Moves the next deadline to now + delayMs (also for a running periodic task).
+  bool runIn(TaskId id, uint32_t delayMs);
+  // Takes effect from the next deadline on.
+  bool setPeriod(TaskId id, uint32_t periodMs);
+
+  // Runs every task whose deadline has passed, earliest first. Returns the
+  // ms until the next deadline (0 if one is already due again).
+  uint32_t runDue();
+  // Waits up to waitMs (capped at kMaxIdleMs); delay() lets the SDK run its
+  // WiFi and TCP work meanwhile. It saves no power: WifiMgr keeps the modem
+  // awake (WIFI_NONE_SLEEP).
+  void idle(uint32_t waitMs);
+
+  TaskId count() const { return heapLen_; }
+  TaskId capacity() const { return capacity_; }
+  const TaskStats* stats(TaskId id) const;
+  // Levels tasks moved up or down the deadline heap, the unit of work behind
+  // the O(log n) above; reset by resetStats().
+  uint32_t heapSteps() const { return heapSteps_; }
+  void resetStats();
+  // One line per task: name, runs, lateness min/avg/max, jitter, max run time.
+  void report(Print& out) const;
+
+protected:
+  struct Task
+  {
+    const char* name;
+    TaskFn fn;
+    void* ctx;
+    uint32_t due;
+    uint32_t period; // 0 = one-shot
+    TaskId heapPos;  // kNoTask when the slot is free
+    TaskStats stats;
+  };
+
+  // clock = nullptr uses millis(); a host test can pass a virtual clock.
+  // The storage is not touched until init().
+  Scheduler(Task* tasks, TaskId* heap, TaskId capacity, ClockFn clock);
+  void init();
+
+private:
+  TaskId add(const char* name, uint32_t delayMs, uint32_t periodMs, TaskFn fn, void* ctx);
+  bool live(TaskId id) const { return id < capacity_ && tasks_[id].heapPos != kNoTask; }
+  bool before(TaskId a, TaskId b) const;
+  void place(TaskId pos, TaskId id);
+  void siftUp(TaskId pos);
+  void siftDown(TaskId pos);
+  void removeAt(TaskId pos);
+  void fix(TaskId pos);
+  uint32_t now() const;
+
+  ClockFn clock_;
+  Task* const tasks_;
+  TaskId* const heap_; // task ids ordered by due
+  const TaskId capacity_;
+  TaskId heapLen_;
+  uint32_t heapSteps_;
+};
+
+// A Scheduler with room for Capacity tasks, held inline.
+template <uint16_t Capacity>
+class StaticScheduler : public Scheduler
+{
+  static_assert(Capacity > 0 && Capacity < kNoTask, "task ids must stay below kNoTask");
+
+public:
+  explicit StaticScheduler(ClockFn clock = nullptr) : Scheduler(slots_, heapSlots_, Capacity, clock) { init(); }
+
+private:
+  Task slots_[Capacity];
+  TaskId heapSlots_[Capacity];
+};
@@ -0,0 +1,195 @@
+#include "sntp_client.h"
+#include <lwip/dns.h>
+
+static const char* const kServers[SntpClient::kServerCount] = {"0.pool.ntp.org", "1.pool.ntp.org", "2.pool.ntp.org"};
+static constexpr uint16_t kNtpPort = 123;
+static constexpr uint32_t kResolveTimeoutMs = 2000;
+static constexpr uint32_t kReplyTimeoutMs = 1000;
+static constexpr uint32_t kMaxDelayMs = 2000;    // samples slower than this are useless
+static constexpr uint32_t kNtpToUnix = 2208988800UL; // seconds 1900 -> 1970
+static constexpr size_t kPacketLen = 48;
+
+static uint32_t readBe32(const uint8_t* p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void writeBe32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+// NTP 32.32 fixed point timestamp -> Unix epoch milliseconds
+static int64_t ntpToUnixMs(const uint8_t* p)
+{
+    const uint32_t sec = readBe32(p);
+    const uint32_t frac = readBe32(p + 4);
+    return ((int64_t)sec - (int64_t)kNtpToUnix) * 1000 + (int64_t)(((uint64_t)frac * 1000) >> 32);
+}
+
+SntpClient::SntpClient()
+    : state_(State::Idle), server_(0), stateSinceMs_(0), dnsDone_(false), dnsOk_(false), t1Ms_(0), nonce_{0, 0},
+      samples_(0), best_{0, 0, 0, 0}
+{
+}
+
+struct SntpDns
+{
+    static void found(const char* name, const ip_addr_t* ipaddr, void* arg)
+    {
+        SntpClient* self = (SntpClient*)arg;
+        // late answers for a server we already gave up on are ignored
+        if (self->state_ != SntpClient::State::Resolve || strcmp(name, kServers[self->server_]) != 0)
+            return;
+        if (ipaddr)
+            self->addr_ = IPAddress(ipaddr);
+        self->dnsOk_ = ipaddr != nullptr;
+        self->dnsDone_ = true;
+    }
+};
+
+void SntpClient::start(uint32_t nowMs)
+{
+    stop();
+    samples_ = 0;
+    udp_.begin(0);
+    server_ = 0xFF; // nextServer() moves to 0
+    nextServer(nowMs);
+}
+
+void SntpClient::stop()
+{
+    udp_.stop();
+    state_ = State::Idle;
+}
+
+void SntpClient::nextServer(uint32_t nowMs)
+{
+    server_++;
+    if (server_ >= kServerCount)
+    {
+        Serial.printf("[Time][NTP] round done, %u sample(s)\n", samples_);
+        stop();
+        return;
+    }
+
+    state_ = State::Resolve;
+    stateSinceMs_ = nowMs;
+    dnsDone_ = false;
+    dnsOk_ = false;
+    ip_addr_t addr;
+    err_t err = dns_gethostbyname(kServers[server_], &addr, SntpDns::found, this);
+    if (err == ERR_OK)
+    {
+        addr_ = IPAddress(&addr);
+        send(nowMs);
+    }
+    else if (err != ERR_INPROGRESS)
+    {
+        nextServer(nowMs);
+    }
+}
+
+void SntpClient::send(uint32_t nowMs)
+{
+    uint8_t packet[kPacketLen];
+    memset(packet, 0, sizeof(packet));
+    packet[0] = 0x23; // LI=0, VN=4, Mode=3 (client)
+
+    // The transmit timestamp only has to be unique; the server echoes it as
+    // the origin timestamp and we match on it to reject stale/forged replies.
+    nonce_[0] = nowMs ^ micros();
+    nonce_[1] = RANDOM_REG32;
+    writeBe32(packet + 40, nonce_[0]);
+    writeBe32(packet + 44, nonce_[1]);
+
+    udp_.beginPacket(addr_, kNtpPort);
+    udp_.write(packet, sizeof(packet));
+    t1Ms_ = millis();
+    if (!udp_.endPacket())
+    {
+        Serial.printf("[Time][NTP] send to %s failed\n", kServers[server_]);
+        nextServer(nowMs);
+        return;
+    }
+    state_ = State::Wait;
+    stateSinceMs_ = nowMs;
+}
+
+void SntpClient::receive(uint32_t nowMs)
+{
+    const uint32_t t4Ms = millis();
+    uint8_t buf[kPacketLen];
+    const int len = udp_.read(buf, sizeof(buf));
+    udp_.flush();
+
+    // not our answer (or a kiss-o'-death); keep waiting until the timeout
+    if (len < (int)kPacketLen || (uint32_t)udp_.remoteIP() != (uint32_t)addr_)
+        return;
+    const uint8_t li = buf[0] >> 6;
+    const uint8_t mode = buf[0] & 0x07;
+    const uint8_t stratum = buf[1];
+    if (mode != 4 || li == 3 || stratum == 0 || stratum > 15 || readBe32(buf + 24) != nonce_[0] ||
+        readBe32(buf + 28) != nonce_[1])
+        return;
+
+    // T1/T4 are local millis(), T2/T3 server UTC. offset = ((T2-T1)+(T3-T4))/2,
+    // delay = (T4-T1) - (T3-T2). Done in 64 bits; millis() wrap is absorbed
+    // because only t4 - t1 is taken as a difference.
+    const int64_t t1 = (int64_t)t1Ms_;
+    const int64_t t4 = t1 + (int64_t)(uint32_t)(t4Ms - t1Ms_);
+    const int64_t t2 = ntpToUnixMs(buf + 32);
+    const int64_t t3 = ntpToUnixMs(buf + 40);
+    const int64_t delay = (t4 - t1) - (t3 - t2);
+    const int64_t offset = ((t2 - t1) + (t3 - t4)) / 2;
+
+    Serial.printf("[Time][NTP] %s stratum=%u delay=%ld ms\n", kServers[server_], stratum, (long)delay);
+    if (delay >= 0 && delay <= (int64_t)kMaxDelayMs)
+    {
+        if (samples_ == 0 || (uint32_t)delay < best_.delayMs)
+        {
+            best_.offsetMs = offset;
+            best_.delayMs = (uint32_t)delay;
+            best_.server = server_;
+            best_.stratum = stratum;
+        }
+        samples_++;
+    }
+    nextServer(nowMs);
+}
+
+bool SntpClient::poll(uint32_t nowMs)
+{
+    switch (state_)
+    {
+    case State::Idle:
+        return false;
+    case State::Resolve:
+        if (dnsDone_)
+        {
+            if (dnsOk_)
+                send(nowMs);
+            else
+                nextServer(nowMs);
+        }
+        else if (nowMs - stateSinceMs_ >= kResolveTimeoutMs)
+        {
+            Serial.printf("[Time][NTP] DNS timeout for %s\n", kServers[server_]);
+            nextServer(nowMs);
+        }
+        break;
+    case State::Wait:
+        if (udp_.parsePacket() > 0)
+            receive(nowMs);
+        else if (nowMs - stateSinceMs_ >= kReplyTimeoutMs)
+        {
+            Serial.printf("[Time][NTP] no reply from %s\n", kServers[server_]);
+            nextServer(nowMs);
+        }
+        break;
+    }
+    return running();
+}
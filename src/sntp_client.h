@@ -0,0 +1,59 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFiUdp.h>
+
+// One SNTP exchange, all times in milliseconds.
+struct SntpSample
+{
+    int64_t offsetMs; // UTC epoch ms minus local millis() at the same instant
+    uint32_t delayMs; // round trip minus server processing time
+    uint8_t server;   // index into the server list
+    uint8_t stratum;
+};
+
+// Non-blocking SNTP (RFC 4330) client. A round queries every server once,
+// one at a time: async DNS, send, then poll for the reply on each call. The
+// sample with the smallest round-trip delay wins, since delay bounds the
+// error of its offset (|error| <= delay / 2).
+class SntpClient
+{
+public:
+    static constexpr uint8_t kServerCount = 3;
+
+    SntpClient();
+
+    void start(uint32_t nowMs);
+    // Advances the round by one step; returns true while it is still running.
+    bool poll(uint32_t nowMs);
+    void stop();
+
+    bool running() const { return state_ != State::Idle; }
+    bool hasResult() const { return samples_ > 0; }
+    const SntpSample& best() const { return best_; }
+    uint8_t samples() const { return samples_; }
+
+private:
+    enum class State : uint8_t
+    {
+        Idle,
+        Resolve,
+        Wait,
+    };
+
+    friend struct SntpDns; // lwIP DNS callback
+    void nextServer(uint32_t nowMs);
+    void send(uint32_t nowMs);
+    void receive(uint32_t nowMs);
+
+    WiFiUDP udp_;
+    State state_;
+    uint8_t server_;
+    uint32_t stateSinceMs_;
+    volatile bool dnsDone_;
+    volatile bool dnsOk_;
+    IPAddress addr_;
+    uint32_t t1Ms_;     // local send time
+    uint32_t nonce_[2]; // our transmit timestamp, must come back as the origin
+    uint8_t samples_;
+    SntpSample best_;
+};
@@ -0,0 +1,129 @@
+#include "tcp_conn.h"
+#include <lwip/tcp.h>
+
+// Callbacks run in lwIP's context and only update the connection's fields.
+struct TcpConnEvents
+{
+    static err_t connected(void* arg, tcp_pcb* pcb, err_t err)
+    {
+        (void)pcb;
+        static_cast<TcpConn*>(arg)->state_ = err == ERR_OK ? TcpConn::State::Open : TcpConn::State::Failed;
+        return ERR_OK;
+    }
+
+    static err_t recv(void* arg, tcp_pcb* pcb, pbuf* p, err_t err)
+    {
+        (void)pcb;
+        TcpConn* c = static_cast<TcpConn*>(arg);
+        if (!p || err != ERR_OK)
+        {
+            // FIN from the peer: what was received stays readable
+            if (p)
+                pbuf_free(p);
+            c->state_ = TcpConn::State::Closed;
+            return ERR_OK;
+        }
+        if (c->rx_)
+            pbuf_cat(c->rx_, p);
+        else
+            c->rx_ = p;
+        return ERR_OK;
+    }
+
+    static void error(void* arg, err_t err)
+    {
+        // lwIP has already freed the pcb
+        (void)err;
+        TcpConn* c = static_cast<TcpConn*>(arg);
+        c->pcb_ = nullptr;
+        c->state_ = TcpConn::State::Failed;
+    }
+};
+
+TcpConn::TcpConn() : pcb_(nullptr), rx_(nullptr), rxOff_(0), state_(State::Closed) {}
+
+TcpConn::~TcpConn() { stop(); }
+
+bool TcpConn::connect(IPAddress ip, uint16_t port)
+{
+    stop();
+    pcb_ = tcp_new();
+    if (!pcb_)
+        return false;
+    tcp_arg(pcb_, this);
+    tcp_recv(pcb_, TcpConnEvents::recv);
+    tcp_err(pcb_, TcpConnEvents::error);
+    tcp_nagle_disable(pcb_);
+
+    ip_addr_t addr;
+    IP_ADDR4(&addr, ip[0], ip[1], ip[2], ip[3]);
+    state_ = State::Connecting;
+    if (tcp_connect(pcb_, &addr, port, TcpConnEvents::connected) != ERR_OK)
+    {
+        stop();
+        state_ = State::Failed;
+        return false;
+    }
+    return true;
+}
+
+size_t TcpConn::write(const uint8_t* data, size_t n)
+{
+    if (state_ != State::Open || !pcb_ || n > tcp_sndbuf(pcb_))
+        return 0;
+    if (tcp_write(pcb_, data, (uint16_t)n, TCP_WRITE_FLAG_COPY) != ERR_OK)
+        return 0;
+    tcp_output(pcb_);
+    return n;
+}
+
+int TcpConn::available() const { return rx_ ? (int)(rx_->tot_len - rxOff_) : 0; }
+
+int TcpConn::read()
+{
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int TcpConn::read(uint8_t* buf, size_t n)
+{
+    const int avail = available();
+    if (avail <= 0)
+        return -1;
+    if (n > (size_t)avail)
+        n = (size_t)avail;
+    pbuf_copy_partial(rx_, buf, (uint16_t)n, rxOff_);
+    rxOff_ += (uint16_t)n;
+
+    // release the pbufs read to the end and reopen the window by as much
+    while (rx_ && rxOff_ >= rx_->len)
+    {
+        pbuf* head = rx_;
+        rx_ = head->next;
+        rxOff_ -= head->len;
+        if (rx_)
+            pbuf_ref(rx_);
+        if (pcb_)
+            tcp_recved(pcb_, head->len);
+        pbuf_free(head);
+    }
+    return (int)n;
+}
+
+void TcpConn::stop()
+{
+    if (pcb_)
+    {
+        tcp_arg(pcb_, nullptr);
+        tcp_recv(pcb_, nullptr);
+        tcp_err(pcb_, nullptr);
+        if (tcp_close(pcb_) != ERR_OK)
+            tcp_abort(pcb_);
+        pcb_ = nullptr;
+    }
+    if (rx_)
+        pbuf_free(rx_);
+    rx_ = nullptr;
+    rxOff_ = 0;
+    state_ = State::Closed;
+}
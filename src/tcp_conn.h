@@ -0,0 +1,51 @@
+#pragma once
+#include <Arduino.h>
+
+struct tcp_pcb;
+struct pbuf;
+
+// Non-blocking TCP client on lwIP's raw API.
+//
+// connect() only queues the SYN. lwIP reports the handshake, incoming
+// segments, the peer's FIN and errors through callbacks from its own
+// context, which only record them here; the caller polls state() and reads
+// the received pbuf chain at its own pace, so no call ever waits on the
+// network. WiFiClient cannot do that: its connect() sleeps until the
+// SYN-ACK or the timeout.
+class TcpConn
+{
+public:
+    enum class State : uint8_t
+    {
+        Closed,     // never opened, stopped, or closed by the peer
+        Connecting, // SYN sent
+        Open,
+        Failed, // refused, reset or out of memory
+    };
+
+    TcpConn();
+    ~TcpConn();
+
+    // Starts the handshake; false if lwIP cannot even begin it.
+    bool connect(IPAddress ip, uint16_t port);
+    State state() const { return state_; }
+    // Handshake done and not closed by either side; data may remain after.
+    bool connected() const { return state_ == State::Open; }
+
+    // Queues data (copied) and pushes it out; returns n, or 0 if it did not fit.
+    size_t write(const uint8_t* data, size_t n);
+    int available() const;
+    int read();
+    int read(uint8_t* buf, size_t n);
+
+    // Closes (or aborts) the connection and drops unread data.
+    void stop();
+
+private:
+    friend struct TcpConnEvents; // lwIP callbacks
+
+    tcp_pcb* pcb_;
+    pbuf* rx_;       // received, not yet read
+    uint16_t rxOff_; // read position in the first pbuf of rx_
+    State state_;
+};
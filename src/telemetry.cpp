@@ -0,0 +1,219 @@
+#include "telemetry.h"
+#include <U8g2lib.h>
+#include <string.h>
+
+static_assert(sizeof(Telemetry) <= Telemetry::kRamBudget, "telemetry rings exceed their RAM budget");
+static_assert(Telemetry::kSecondPoints >= 60 && Telemetry::kMinutePoints >= 60,
+              "a minute folds 60 second points, an hour 60 minute points");
+
+static constexpr Telemetry::Point kEmpty = {INT16_MAX, 0, INT16_MIN};
+static constexpr uint8_t kDumpVersion = 1;
+
+struct SeriesInfo
+{
+  const char* name;
+  uint8_t shift;
+};
+
+// heap sizes in 4-byte units and loop time in 4 us units keep them inside int16
+static const SeriesInfo kSeriesInfo[Telemetry::kSeries] = {
+    {"rssi", 0}, {"heap", 2}, {"maxblk", 2}, {"loop_us", 2}, {"sync_ms", 0},
+};
+
+static const uint8_t kCapacity[Telemetry::kTiers] = {Telemetry::kSecondPoints, Telemetry::kMinutePoints,
+                                                     Telemetry::kHourPoints};
+static const uint16_t kRingStart[Telemetry::kTiers] = {0, Telemetry::kSecondPoints,
+                                                       Telemetry::kSecondPoints + Telemetry::kMinutePoints};
+static const uint16_t kPeriodS[Telemetry::kTiers] = {1, 60, 3600};
+
+static int16_t saturate(int32_t v)
+{
+  return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : (int16_t)v;
+}
+
+Telemetry::Telemetry() : secondsInMinute_(0), minutesInHour_(0), started_(false), secondStartMs_(0)
+{
+  for (uint8_t s = 0; s < kSeries; s++)
+  {
+    for (Point& p : points_[s])
+      p = kEmpty;
+    accum_[s] = Accum{0, INT16_MAX, INT16_MIN, 0};
+  }
+  memset(head_, 0, sizeof(head_));
+  memset(count_, 0, sizeof(count_));
+}
+
+const char* Telemetry::name(Series s) { return s < kSeries ? kSeriesInfo[s].name : "?"; }
+uint8_t Telemetry::shift(Series s) { return s < kSeries ? kSeriesInfo[s].shift : 0; }
+uint8_t Telemetry::capacity(Tier t) { return t < kTiers ? kCapacity[t] : 0; }
+uint16_t Telemetry::periodS(Tier t) { return t < kTiers ? kPeriodS[t] : 0; }
+
+Telemetry::Point* Telemetry::ring(Series s, Tier t) { return &points_[s][kRingStart[t]]; }
+const Telemetry::Point* Telemetry::ring(Series s, Tier t) const { return &points_[s][kRingStart[t]]; }
+
+void Telemetry::record(Series s, int32_t value)
+{
+  if (s >= kSeries)
+    return;
+  Accum& a = accum_[s];
+  if (a.n == UINT16_MAX)
+    return; // the mean of what came so far is good enough
+  const int16_t v = saturate(value >> kSeriesInfo[s].shift);
+  a.sum += v;
+  if (v < a.min)
+    a.min = v;
+  if (v > a.max)
+    a.max = v;
+  a.n++;
+}
+
+void Telemetry::tick(uint32_t nowMs)
+{
+  if (!started_)
+  {
+    started_ = true;
+    secondStartMs_ = nowMs;
+    return;
+  }
+  uint32_t n = (nowMs - secondStartMs_) / 1000;
+  if (n == 0)
+    return;
+  secondStartMs_ += n * 1000;
+  // after a long stall, a minute of empty seconds is all there is to say
+  if (n > kSecondPoints)
+    n = kSecondPoints;
+  while (n--)
+    closeSecond();
+}
+
+void Telemetry::push(Tier t, const Point* points)
+{
+  for (uint8_t s = 0; s < kSeries; s++)
+    ring((Series)s, t)[head_[t]] = points[s];
+  head_[t] = (uint8_t)((head_[t] + 1) % kCapacity[t]);
+  if (count_[t] < kCapacity[t])
+    count_[t]++;
+}
+
+void Telemetry::closeSecond()
+{
+  Point p[kSeries];
+  for (uint8_t s = 0; s < kSeries; s++)
+  {
+    Accum& a = accum_[s];
+    p[s] = a.n ? Point{a.min, (int16_t)(a.sum / a.n), a.max} : kEmpty;
+    a = Accum{0, INT16_MAX, INT16_MIN, 0};
+  }
+  push(Seconds, p);
+
+  if (++secondsInMinute_ < 60)
+    return;
+  secondsInMinute_ = 0;
+  fold(Seconds, Minutes);
+  if (++minutesInHour_ < 60)
+    return;
+  minutesInHour_ = 0;
+  fold(Minutes, Hours);
+}
+
+// The newest 60 points of `from` become one point of `to`: min of the mins,
+// max of the maxes and the plain mean of the means.
+void Telemetry::fold(Tier from, Tier to)
+{
+  Point p[kSeries];
+  for (uint8_t s = 0; s < kSeries; s++)
+  {
+    Accum a{0, INT16_MAX, INT16_MIN, 0};
+    for (uint8_t age = 0; age < 60; age++)
+    {
+      const Point q = at((Series)s, from, age);
+      if (q.empty())
+        continue;
+      a.sum += q.avg;
+      if (q.min < a.min)
+        a.min = q.min;
+      if (q.max > a.max)
+        a.max = q.max;
+      a.n++;
+    }
+    p[s] = a.n ? Point{a.min, (int16_t)(a.sum / a.n), a.max} : kEmpty;
+  }
+  push(to, p);
+}
+
+Telemetry::Point Telemetry::at(Series s, Tier t, uint8_t age) const
+{
+  if (s >= kSeries || t >= kTiers || age >= count_[t])
+    return kEmpty;
+  const uint8_t cap = kCapacity[t];
+  return ring(s, t)[(head_[t] + cap - 1 - age) % cap];
+}
+
+void Telemetry::drawSparkline(U8G2& u8g2, Series s, Tier t, int x, int y, int w, int h) const
+{
+  if (w <= 0 || h <= 0)
+    return;
+  const uint8_t n = (uint8_t)(w < count(t) ? w : count(t));
+  int16_t lo = INT16_MAX;
+  int16_t hi = INT16_MIN;
+  for (uint8_t age = 0; age < n; age++)
+  {
+    const Point p = at(s, t, age);
+    if (p.empty())
+      continue;
+    if (p.min < lo)
+      lo = p.min;
+    if (p.max > hi)
+      hi = p.max;
+  }
+  if (lo > hi)
+    return; // nothing recorded
+  const int32_t range = hi > lo ? (int32_t)hi - lo : 1;
+  auto row = [&](int16_t v) { return y + h - 1 - (int)(((int32_t)v - lo) * (h - 1) / range); };
+
+  for (uint8_t age = 0; age < n; age++)
+  {
+    const Point p = at(s, t, age);
+    if (p.empty())
+      continue;
+    const int top = row(p.max);
+    u8g2.drawVLine(x + w - 1 - age, top, row(p.min) - top + 1);
+  }
+}
+
+static void putWord(uint8_t* dst, int16_t v)
+{
+  dst[0] = (uint8_t)((uint16_t)v & 0xFF);
+  dst[1] = (uint8_t)((uint16_t)v >> 8);
+}
+
+void Telemetry::dump(Print& out, Series s, Tier t) const
+{
+  if (s >= kSeries || t >= kTiers)
+    return;
+  const uint8_t n = count_[t];
+  const uint8_t header[] = {'T',
+                            'M',
+                            kDumpVersion,
+                            s,
+                            t,
+                            kSeriesInfo[s].shift,
+                            (uint8_t)(kPeriodS[t] & 0xFF),
+                            (uint8_t)(kPeriodS[t] >> 8),
+                            n};
+  out.write(header, sizeof(header));
+  for (uint8_t i = 0; i < n; i++)
+  {
+    const Point p = at(s, t, (uint8_t)(n - 1 - i));
+    uint8_t rec[6];
+    putWord(rec, p.min);
+    putWord(rec + 2, p.avg);
+    putWord(rec + 4, p.max);
+    out.write(rec, sizeof(rec));
+  }
+}
+
+// Instance the managers and App record into
+static Telemetry _internalTelemetry;
+
+Telemetry& telemetry() { return _internalTelemetry; }
@@ -0,0 +1,109 @@
+#pragma once
+#include <Arduino.h>
+
+class U8G2;
+
+// History of a few health figures in fixed RAM.
+//
+// Each series keeps three rings of points: one per second for the last
+// minute, one per minute for the last hour and one per hour for the last
+// day. A point is the min, mean and max of what fell into its interval;
+// seconds are fed by record(), and every 60 of them fold into a minute point
+// and every 60 minutes into an hour point. An interval with no samples is an
+// empty point and is skipped by the folding and the sparkline.
+//
+// Values are kept as int16 in the series' unit shifted right by
+// shift(series), saturating; at() returns them that way and scale() undoes it.
+// Intervals follow millis(), not the wall clock, so a clock step does not
+// disturb them. Everything lives in the object, no heap: see kRamBudget.
+class Telemetry
+{
+public:
+  enum Series : uint8_t
+  {
+    Rssi,         // dBm, per RSSI refresh in WifiMgr
+    FreeHeap,     // bytes, once a second
+    MaxFreeBlock, // bytes, once a second
+    LoopUs,       // us of work per App::loop() pass, waits excluded
+    SyncOffsetMs, // ms the clock was off at a sync, per TimeMgr sync
+    kSeries,
+  };
+
+  enum Tier : uint8_t
+  {
+    Seconds,
+    Minutes,
+    Hours,
+    kTiers,
+  };
+
+  struct Point
+  {
+    int16_t min;
+    int16_t avg;
+    int16_t max;
+    bool empty() const { return min > max; }
+  };
+
+  static constexpr uint8_t kSecondPoints = 60;
+  static constexpr uint8_t kMinutePoints = 60;
+  static constexpr uint8_t kHourPoints = 24;
+  static constexpr size_t kRamBudget = 4608; // sizeof(Telemetry), checked at compile time
+
+  Telemetry();
+
+  // Adds a sample to the current second. Cheap enough for every loop pass.
+  void record(Series s, int32_t value);
+  // Closes the seconds that ended by nowMs (millis()) and folds them into
+  // minutes and hours. Call at least once a second.
+  void tick(uint32_t nowMs);
+
+  static const char* name(Series s);
+  static uint8_t shift(Series s);
+  static int32_t scale(Series s, int16_t stored) { return (int32_t)stored * (1 << shift(s)); }
+  static uint8_t capacity(Tier t);
+  static uint16_t periodS(Tier t); // seconds per point
+
+  uint8_t count(Tier t) const { return count_[t]; } // points held, up to capacity(t)
+  // age 0 is the newest point; empty past count(t)
+  Point at(Series s, Tier t, uint8_t age) const;
+
+  // Plots the newest points of a series, one column each, newest at the right
+  // edge of the w x h box at (x, y): a bar from min to max, scaled to the
+  // range of the points shown. Draws in the current draw color and leaves the
+  // rest of the box alone.
+  void drawSparkline(U8G2& u8g2, Series s, Tier t, int x, int y, int w, int h) const;
+
+  // Writes the points of a series, oldest first:
+  //   'T' 'M' version=1 series tier shift periodS:u16 count:u8
+  //   count x { min avg max }:i16
+  // all little-endian; an empty point is { 32767, 0, -32768 }.
+  void dump(Print& out, Series s, Tier t) const;
+
+private:
+  struct Accum
+  {
+    int32_t sum;
+    int16_t min;
+    int16_t max;
+    uint16_t n;
+  };
+
+  void closeSecond();
+  void fold(Tier from, Tier to);
+  void push(Tier t, const Point* points);
+  Point* ring(Series s, Tier t);
+  const Point* ring(Series s, Tier t) const;
+
+  Point points_[kSeries][kSecondPoints + kMinutePoints + kHourPoints];
+  Accum accum_[kSeries];
+  uint8_t head_[kTiers]; // next slot to write
+  uint8_t count_[kTiers];
+  uint8_t secondsInMinute_;
+  uint8_t minutesInHour_;
+  bool started_;
+  uint32_t secondStartMs_;
+};
+
+// Store fed by WifiMgr, TimeMgr and App.
+Telemetry& telemetry();
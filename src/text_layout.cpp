@@ -0,0 +1,155 @@
+#include "text_layout.h"
+#include <string.h>
+
+TextLayoutCache::TextLayoutCache() : tick_(0), hits_(0), misses_(0), linesWrapped_(0) { clear(); }
+
+void TextLayoutCache::clear()
+{
+  memset(entries_, 0, sizeof(entries_));
+}
+
+uint32_t TextLayoutCache::hashText(const char* utf8)
+{
+  uint32_t h = 2166136261UL;
+  for (const uint8_t* p = (const uint8_t*)utf8; *p; p++)
+  {
+    h ^= *p;
+    h *= 16777619UL;
+  }
+  return h;
+}
+
+const TextLayout& TextLayoutCache::get(U8G2& u8g2, const char* utf8, int w)
+{
+  return get(u8g2, utf8, w, hashText(utf8));
+}
+
+const TextLayout& TextLayoutCache::get(U8G2& u8g2, const char* utf8, int w, uint32_t hash)
+{
+  const uint8_t* font = u8g2.getU8g2()->font;
+  tick_++;
+
+  TextLayout* victim = &entries_[0];
+  for (uint8_t i = 0; i < kEntries; i++)
+  {
+    TextLayout& e = entries_[i];
+    if (e.lastUse && e.hash == hash && e.font == font && e.width == w)
+    {
+      e.lastUse = tick_;
+      hits_++;
+      return e;
+    }
+    if (e.lastUse < victim->lastUse)
+      victim = &e;
+  }
+
+  misses_++;
+  victim->hash = hash;
+  victim->font = font;
+  victim->width = (int16_t)w;
+  victim->lastUse = tick_;
+  build(u8g2, *victim, utf8);
+  return *victim;
+}
+
+void TextLayoutCache::build(U8G2& u8g2, TextLayout& layout, const char* utf8)
+{
+  layout.lines = 0;
+  layout.stride = 1;
+  layout.count = 0;
+
+  WrapCursor cur;
+  WrapLine line;
+  while (layout.lines < UINT16_MAX && wrapNextLine(u8g2, utf8, layout.width, cur, line))
+  {
+    if (layout.lines % layout.stride == 0)
+    {
+      if (layout.count == TextLayout::kSlots)
+      {
+        // out of slots: keep every other start and double the stride
+        for (uint8_t i = 0; i < TextLayout::kSlots / 2; i++)
+          layout.start[i] = layout.start[i * 2];
+        layout.count = TextLayout::kSlots / 2;
+        layout.stride *= 2;
+      }
+      if (layout.lines % layout.stride == 0)
+        layout.start[layout.count++] = (uint32_t)line.start;
+    }
+    layout.lines++;
+  }
+}
+
+bool TextLayoutCache::next(U8G2& u8g2, const TextLayout& layout, const char* utf8, WrapCursor& cur, WrapLine& line)
+{
+  if (!wrapNextLine(u8g2, utf8, layout.width, cur, line))
+    return false;
+  linesWrapped_++;
+  return true;
+}
+
+WrapCursor TextLayoutCache::seek(U8G2& u8g2, const TextLayout& layout, const char* utf8, uint16_t line)
+{
+  WrapCursor cur;
+  if (layout.count == 0)
+    return cur;
+
+  uint16_t idx = line / layout.stride;
+  if (idx >= layout.count)
+    idx = layout.count - 1;
+  cur.pos = layout.start[idx];
+
+  WrapLine skipped;
+  for (uint32_t i = (uint32_t)idx * layout.stride; i < line; i++)
+  {
+    if (!next(u8g2, layout, utf8, cur, skipped))
+      break;
+  }
+  return cur;
+}
+
+uint16_t TextLayoutCache::drawLines(U8G2& u8g2, const TextLayout& layout, const char* utf8,
+                                    uint16_t firstLine, int x, int y, int h, int lineH)
+{
+  if (lineH <= 0 || firstLine >= layout.lines)
+    return 0;
+
+  WrapCursor cur = seek(u8g2, layout, utf8, firstLine);
+  WrapLine line;
+  const int maxLines = h / lineH;
+  int baseline = y;
+  uint16_t drawn = 0;
+  while (drawn < maxLines && next(u8g2, layout, utf8, cur, line))
+  {
+    drawWrapLine(u8g2, x, baseline, utf8, line);
+    baseline += lineH;
+    drawn++;
+  }
+  return drawn;
+}
+
+void TextLayoutCache::drawScrolled(U8G2& u8g2, const TextLayout& layout, const char* utf8,
+                                   int scrollPx, int x, int top, int w, int h, int lineH)
+{
+  if (lineH <= 0 || scrollPx < 0)
+    return;
+
+  const uint16_t firstLine = (uint16_t)(scrollPx / lineH);
+  if (firstLine >= layout.lines)
+    return;
+
+  WrapCursor cur = seek(u8g2, layout, utf8, firstLine);
+  WrapLine line;
+  u8g2.setClipWindow(x, top, x + w, top + h);
+  int baseline = top + u8g2.getAscent() - scrollPx % lineH;
+  while (baseline - u8g2.getAscent() < top + h && next(u8g2, layout, utf8, cur, line))
+  {
+    drawWrapLine(u8g2, x, baseline, utf8, line);
+    baseline += lineH;
+  }
+  u8g2.setMaxClipWindow();
+}
+
+// Instance used by drawWrappedUTF8()
+static TextLayoutCache _internalTextLayoutCache;
+
+TextLayoutCache& textLayoutCache() { return _internalTextLayoutCache; }
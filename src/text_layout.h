@@ -0,0 +1,73 @@
+#pragma once
+#include "text_wrap.h"
+#include <U8g2lib.h>
+
+// Line-break index of one (text, font, width) combination: where each wrapped
+// line starts, so a page or a scrolled view is wrapped from its own first line
+// instead of from the start of the text. Up to kSlots lines every start is
+// kept. Past that, every other one is dropped and the stride doubles, as often
+// as needed, so any text fits the same slots; reaching line N then re-wraps
+// at most stride - 1 lines before it.
+struct TextLayout
+{
+  static constexpr uint8_t kSlots = 48;
+
+  uint32_t hash;     // FNV-1a of the text bytes
+  const uint8_t* font;
+  int16_t width;
+  uint16_t lines;    // total wrapped lines
+  uint8_t stride;    // start kept for every `stride`-th line (power of two)
+  uint8_t count;     // starts in use
+  uint32_t lastUse;  // LRU tick, 0 = free entry
+  uint32_t start[kSlots]; // byte offset where line i * stride starts
+};
+
+// Fixed-size LRU cache of layouts (about 1 KB); sized for a handful of
+// on-screen texts.
+class TextLayoutCache
+{
+public:
+  static constexpr uint8_t kEntries = 4;
+
+  TextLayoutCache();
+
+  static uint32_t hashText(const char* utf8);
+
+  // Returns the layout of utf8 wrapped to w pixels in the current font,
+  // wrapping the whole text once on a miss. Pass a stored hash to skip
+  // re-hashing the text on every frame.
+  const TextLayout& get(U8G2& u8g2, const char* utf8, int w);
+  const TextLayout& get(U8G2& u8g2, const char* utf8, int w, uint32_t hash);
+
+  // Draws lines [firstLine, firstLine + h / lineH); (x, y) = baseline of the
+  // first one. Returns the number drawn.
+  uint16_t drawLines(U8G2& u8g2, const TextLayout& layout, const char* utf8,
+                     uint16_t firstLine, int x, int y, int h, int lineH);
+
+  // Vertical pixel scroll inside the box whose top-left corner is (x, top);
+  // partially visible lines are clipped to the box.
+  void drawScrolled(U8G2& u8g2, const TextLayout& layout, const char* utf8,
+                    int scrollPx, int x, int top, int w, int h, int lineH);
+
+  void clear();
+
+  uint32_t hits() const { return hits_; }
+  uint32_t misses() const { return misses_; }
+  // Lines wrapped to seek and draw, i.e. everything but building layouts
+  uint32_t linesWrapped() const { return linesWrapped_; }
+
+private:
+  void build(U8G2& u8g2, TextLayout& layout, const char* utf8);
+  // Cursor positioned at the start of line `line`.
+  WrapCursor seek(U8G2& u8g2, const TextLayout& layout, const char* utf8, uint16_t line);
+  bool next(U8G2& u8g2, const TextLayout& layout, const char* utf8, WrapCursor& cur, WrapLine& line);
+
+  TextLayout entries_[kEntries];
+  uint32_t tick_;
+  uint32_t hits_;
+  uint32_t misses_;
+  uint32_t linesWrapped_;
+};
+
+// Cache used by drawWrappedUTF8().
+TextLayoutCache& textLayoutCache();
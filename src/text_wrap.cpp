@@ -1,156 +1,227 @@
 #include "text_wrap.h"
+#include "glyph_cache.h"
+#include "text_layout.h"
 #include <Arduino.h>
 #include <string.h>
 
-// Safe append helpers (avoid snprintf truncation warnings)
-static bool appendChar(char* dst, size_t cap, char c)
+static bool isSpaceByte(uint8_t b)
 {
-  size_t len = strlen(dst);
-  if (len + 1 >= cap)
-    return false;
-  dst[len] = c;
-  dst[len + 1] = '\0';
-  return true;
+  return b == ' ' || b == '\t' || b == '\n' || b == '\r';
 }
 
-static bool appendStr(char* dst, size_t cap, const char* s)
+// Decodes one UTF-8 sequence; returns its length in bytes. Malformed bytes are
+// consumed one at a time as '?', so a break never lands inside a codepoint.
+static uint8_t utf8Next(const uint8_t* s, uint16_t& cp)
 {
-  size_t len = strlen(dst);
-  size_t add = strlen(s);
-  if (len + add >= cap)
-    return false;
-  memcpy(dst + len, s, add + 1);
-  return true;
+  const uint8_t b = s[0];
+  if (b < 0x80)
+  {
+    cp = b;
+    return 1;
+  }
+
+  uint8_t n;
+  uint32_t v;
+  if ((b & 0xE0) == 0xC0)
+  {
+    n = 2;
+    v = b & 0x1F;
+  }
+  else if ((b & 0xF0) == 0xE0)
+  {
+    n = 3;
+    v = b & 0x0F;
+  }
+  else if ((b & 0xF8) == 0xF0)
+  {
+    n = 4;
+    v = b & 0x07;
+  }
+  else
+  {
+    cp = '?';
+    return 1;
+  }
+
+  for (uint8_t i = 1; i < n; i++)
+  {
+    if ((s[i] & 0xC0) != 0x80)
+    {
+      cp = '?';
+      return 1;
+    }
+    v = (v << 6) | (s[i] & 0x3F);
+  }
+  // u8g2 encodings are 16-bit
+  cp = (v > 0xFFFF) ? '?' : (uint16_t)v;
+  return n;
 }
 
-static bool isSpaceByte(uint8_t b)
+static int glyphAdvance(U8G2& u8g2, uint16_t cp)
 {
-  return b == ' ' || b == '\t' || b == '\n' || b == '\r';
+  return glyphCache().advance(u8g2, cp);
+}
+
+// getUTF8Width() counts the last glyph of a string by its ink, not its
+// advance; this is that difference for cp.
+static int glyphTrim(U8G2& u8g2, uint16_t cp)
+{
+  return glyphCache().endWidth(u8g2, cp) - glyphAdvance(u8g2, cp);
 }
 
 // Splits UTF-8 text by ASCII spaces into "words" (keeps UTF-8 letters intact).
 // For Russian text it’s enough (spaces are ASCII).
-void drawWrappedUTF8(U8G2& u8g2,
-                     int x, int y,
-                     int w, int h,
-                     int lineH,
-                     const char* utf8)
+// Every word is measured once, glyph by glyph, and the line width is kept as a
+// running sum of advances, so the whole text is wrapped in a single pass; the
+// fit test adds the trim of the word that would end the line.
+bool wrapNextLine(U8G2& u8g2, const char* utf8, int w, WrapCursor& cur, WrapLine& line)
 {
-  if (!utf8 || !*utf8)
-    return;
-
-  const int maxLines = (lineH > 0) ? (h / lineH) : 0;
-  if (maxLines <= 0)
-    return;
-
-  char line[192]; // current line
-  char word[96];  // current word
-  line[0] = '\0';
-  word[0] = '\0';
+  const uint8_t* s = (const uint8_t*)utf8;
+  size_t p = cur.pos;
+  while (s[p] && isSpaceByte(s[p]))
+    p++;
+  if (!s[p])
+  {
+    cur.pos = p;
+    return false;
+  }
 
-  int lineIdx = 0;
-  int baseline = y;
+  const int spaceW = glyphAdvance(u8g2, ' ');
+  line.start = p;
+  line.end = p;
+  int lineW = 0;
+  size_t lineBytes = 0;
 
-  auto flushLine = [&]()
-  {
-    if (line[0] == '\0')
-      return;
-    if (lineIdx >= maxLines)
-      return;
-    u8g2.drawUTF8(x, baseline, line);
-    baseline += lineH;
-    lineIdx++;
-    line[0] = '\0';
-  };
-
-  const char* p = utf8;
-  while (*p && lineIdx < maxLines)
+  while (s[p])
   {
-    // Skip multiple spaces
-    while (*p && isSpaceByte((uint8_t)*p))
-      p++;
+    // Measure next word (bytes until next ASCII space), unless the previous
+    // line already did and pushed it here
+    size_t wordEnd = p;
+    int wordW = 0;
+    int wordTrim = 0;
+    if (cur.pendingEnd > cur.pendingStart && cur.pendingStart == p)
+    {
+      wordEnd = cur.pendingEnd;
+      wordW = cur.pendingW;
+      wordTrim = cur.pendingTrim;
+    }
+    else
+    {
+      // Stops once the word is wider than w even with its last glyph
+      // trimmed: it fits no line, and the hard break below takes it a line
+      // at a time instead of re-measuring the rest of it for every line
+      uint16_t cp = 0;
+      int lastAdv = 0;
+      while (s[wordEnd] && !isSpaceByte(s[wordEnd]) && wordW - lastAdv <= w)
+      {
+        wordEnd += utf8Next(s + wordEnd, cp);
+        lastAdv = glyphAdvance(u8g2, cp);
+        wordW += lastAdv;
+      }
+      wordTrim = wordEnd > p ? glyphTrim(u8g2, cp) : 0;
+    }
+    cur.pendingStart = cur.pendingEnd = 0;
 
-    // Extract next word (bytes until next ASCII space)
-    word[0] = '\0';
-    while (*p && !isSpaceByte((uint8_t)*p))
+    const bool empty = line.end == line.start;
+    const int gapW = empty ? 0 : spaceW;
+    const size_t gapBytes = empty ? 0 : 1;
+    const size_t wordBytes = wordEnd - p;
+
+    if (lineW + gapW + wordW + wordTrim <= w && lineBytes + gapBytes + wordBytes <= kWrapMaxLineBytes)
     {
-      // copy byte (UTF-8 safe: we copy raw bytes)
-      if (!appendChar(word, sizeof(word), *p))
-        break;
-      p++;
+      // Accept
+      lineW += gapW + wordW;
+      lineBytes += gapBytes + wordBytes;
+      line.end = wordEnd;
+      p = wordEnd;
+      while (s[p] && isSpaceByte(s[p]))
+        p++;
+      continue;
     }
-    if (word[0] == '\0')
-      break;
 
-    // Try to place word into current line
-    char test[192];
-    test[0] = '\0';
-    appendStr(test, sizeof(test), line);
+    if (!empty)
+    {
+      // New line; keep the measurement for the next call
+      cur.pendingStart = p;
+      cur.pendingEnd = wordEnd;
+      cur.pendingW = wordW;
+      cur.pendingTrim = wordTrim;
+      break;
+    }
 
-    if (test[0] != '\0')
-      appendChar(test, sizeof(test), ' ');
-    appendStr(test, sizeof(test), word);
+    // A single word is wider than the box: put as much as fits into one line,
+    // the remainder starts the next line (at least one codepoint per line).
+    // The word may only be measured up to here, past what fits.
+    size_t q = p;
+    int qW = 0;
+    while (q < wordEnd)
+    {
+      uint16_t cp;
+      const uint8_t n = utf8Next(s + q, cp);
+      const int adv = glyphAdvance(u8g2, cp);
+      if (q > p && (qW + adv + glyphTrim(u8g2, cp) > w || (q - p) + n > kWrapMaxLineBytes))
+        break;
+      q += n;
+      qW += adv;
+    }
+    line.end = q;
+    p = q;
+    break;
+  }
 
-    const int px = u8g2.getUTF8Width(test);
+  cur.pos = p;
+  return true;
+}
 
-    if (px <= w)
+void drawWrapLine(U8G2& u8g2, int x, int y, const char* utf8, const WrapLine& line)
+{
+  // bounded copy with whitespace runs collapsed to the single space we measured
+  char buf[kWrapMaxLineBytes + 1];
+  size_t n = 0;
+  bool gap = false;
+  for (size_t i = line.start; i < line.end && n < kWrapMaxLineBytes; i++)
+  {
+    const uint8_t b = (uint8_t)utf8[i];
+    if (isSpaceByte(b))
     {
-      // Accept
-      strcpy(line, test);
+      gap = true;
+      continue;
     }
-    else
+    if (gap)
     {
-      // New line
-      flushLine();
-
-      // If a single word is wider than the box, hard-break by bytes
-      if (u8g2.getUTF8Width(word) > w)
-      {
-        // Put as much as fits into one line
-        char chunk[192];
-        chunk[0] = '\0';
-
-        const char* q = word;
-        while (*q)
-        {
-          // Try adding next byte
-          char tmp[192];
-          tmp[0] = '\0';
-          appendStr(tmp, sizeof(tmp), chunk);
-          appendChar(tmp, sizeof(tmp), *q);
-
-          if (u8g2.getUTF8Width(tmp) > w)
-            break;
-          strcpy(chunk, tmp);
-          q++;
-        }
-
-        if (chunk[0] != '\0')
-        {
-          u8g2.drawUTF8(x, baseline, chunk);
-          baseline += lineH;
-          lineIdx++;
-        }
-
-        // Remaining part (best effort): continue as new word
-        line[0] = '\0';
-        if (*q)
-        {
-          // Put remainder back into line if possible
-          strncpy(line, q, sizeof(line) - 1);
-          line[sizeof(line) - 1] = '\0';
-        }
-      }
-      else
-      {
-        // word fits on empty line
-        strncpy(line, word, sizeof(line) - 1);
-        line[sizeof(line) - 1] = '\0';
-      }
+      buf[n++] = ' ';
+      gap = false;
+      if (n >= kWrapMaxLineBytes)
+        break;
     }
+    buf[n++] = (char)b;
   }
+  buf[n] = '\0';
+  if (n)
+    glyphCache().drawUTF8(u8g2, x, y, buf);
+}
+
+void drawWrappedUTF8(U8G2& u8g2,
+                     int x, int y,
+                     int w, int h,
+                     int lineH,
+                     const char* utf8)
+{
+  drawWrappedUTF8(u8g2, x, y, w, h, lineH, utf8, 0);
+}
+
+uint16_t drawWrappedUTF8(U8G2& u8g2,
+                         int x, int y,
+                         int w, int h,
+                         int lineH,
+                         const char* utf8,
+                         uint16_t firstLine)
+{
+  if (!utf8 || !*utf8)
+    return 0;
 
-  // Flush last line
-  if (lineIdx < maxLines)
-    flushLine();
+  TextLayoutCache& cache = textLayoutCache();
+  const TextLayout& layout = cache.get(u8g2, utf8, w);
+  cache.drawLines(u8g2, layout, utf8, firstLine, x, y, h, lineH);
+  return layout.lines;
 }
@@ -5,8 +5,51 @@
 // (x, y) = baseline of first line.
 // w/h = bounding box size in pixels.
 // lineH = line height in pixels.
+// The line breaks come from textLayoutCache(), so redrawing the same text
+// wraps only the lines that are drawn.
 void drawWrappedUTF8(U8G2& u8g2,
                      int x, int y,
                      int w, int h,
                      int lineH,
                      const char* utf8);
+
+// Same, from wrapped line firstLine on: page N of a box starts at line
+// N * (h / lineH). Returns the number of lines the whole text wraps to.
+uint16_t drawWrappedUTF8(U8G2& u8g2,
+                         int x, int y,
+                         int w, int h,
+                         int lineH,
+                         const char* utf8,
+                         uint16_t firstLine);
+
+// Longest line handed to u8g2 in one piece (bytes, excluding the terminator).
+static constexpr size_t kWrapMaxLineBytes = 191;
+
+// One wrapped line: bytes [start, end) of the source text. Runs of ASCII
+// whitespace inside it are drawn as a single space.
+struct WrapLine
+{
+  size_t start;
+  size_t end;
+};
+
+// Incremental wrapping state. Start with pos = 0 (or a known line start).
+struct WrapCursor
+{
+  size_t pos = 0;
+  // word at pendingStart was measured but did not fit on the previous line
+  size_t pendingStart = 0;
+  size_t pendingEnd = 0;
+  int pendingW = 0;
+  int pendingTrim = 0;
+};
+
+// Produces the next line using the current font, advancing the cursor.
+// Breaks between words, or inside a word that is wider than w, but always on
+// a codepoint boundary. A line fits when its getUTF8Width() does, so words
+// break where the strlen/getUTF8Width() wrapper this replaced broke them.
+// Returns false when the text is exhausted.
+bool wrapNextLine(U8G2& u8g2, const char* utf8, int w, WrapCursor& cur, WrapLine& line);
+
+// Draws one line produced by wrapNextLine at baseline (x, y).
+void drawWrapLine(U8G2& u8g2, int x, int y, const char* utf8, const WrapLine& line);
@@ -1,30 +1,99 @@
 #include "time_mgr.h"
+#include "civil_time.h"
+#include "clock_discipline.h"
+#include "json_stream.h"
+#include "rtc_store.h"
+#include "sntp_client.h"
+#include "tls_conn.h"
+#include "telemetry.h"
 #include "wifi_mgr.h"
-#include <ESP8266HTTPClient.h>
 #include <ESP8266WiFi.h>
-#include <WiFiClient.h>
-#include <WiFiClientSecure.h>
-#include <WiFiUdp.h>
-#include <time.h>
-
-static const char* kTimeApiUrl = "https://worldtimeapi.org/api/ip";
-// JSON key we look for and compile-time lengths to avoid magic numbers
-static constexpr const char kDateTimeKey[] = "\"datetime\":\""; // "datetime":"
-static constexpr size_t kDateTimeKeyLen = sizeof(kDateTimeKey) - 1;
+#include <lwip/dns.h>
+#include <stddef.h>
+
+// HTTPS through TlsConn: the handshake is a state of its own, stepped like the rest.
+static constexpr const char* kTimeApiHost = "worldtimeapi.org";
+static constexpr uint16_t kTimeApiPort = 443;
+static constexpr const char* kTimeApiPath = "/api/ip";
+// JSON keys we look for and compile-time lengths to avoid magic numbers
+static const char* const kJsonKeys[] = {"unixtime", "utc_offset", "datetime"};
+enum : uint8_t
+{
+    kKeyUnixtime,
+    kKeyUtcOffset,
+    kKeyDateTime,
+};
+static constexpr int kUtcOffsetLen = 6;      // +HH:MM
 static constexpr int kDateTimeTotalLen = 19; // YYYY-MM-DDTHH:MM:SS
 static constexpr int kDateLen = 10;          // YYYY-MM-DD
 static constexpr int kTimeStart = 11;        // index where HH:MM:SS starts inside the datetime string
 static constexpr int kTimeLen = 8;           // HH:MM:SS
+static constexpr int kSecondPos = 17;        // SS inside the datetime string, then ".ffffff"
 static constexpr int kDateTimeTPos = 10;     // position of 'T' inside the datetime string
-static constexpr unsigned long kFetchIntervalMs = 60UL * 60UL * 1000UL; // refresh once per hour
-static constexpr const char* kNtpServer = "pool.ntp.org";
-static constexpr uint16_t kNtpPort = 123;
-static WiFiUDP sntpUdp;
+// Warm-boot checkpoint in RTC user memory
+static constexpr uint32_t kCheckpointMagic = 0x544D4331UL; // "TMC1"
+static constexpr uint32_t kCheckpointMs = 1000;            // also the worst-case restore error
+static constexpr uint32_t kMaxRestoreAgeMs = 24UL * 60 * 60 * 1000; // older syncs are not trusted
+
+struct TimeCheckpoint
+{
+    uint32_t magic;
+    uint32_t utcMsLo; // UTC epoch ms at the moment of writing
+    uint32_t utcMsHi;
+    uint32_t millisRef; // millis() at the moment of writing (uptime before the reset)
+    uint32_t syncAgeMs; // time since the last real sync
+    int32_t utcOffsetSec;
+    int32_t driftPpb;
+    uint32_t crc; // over all fields above
+};
+static_assert(sizeof(TimeCheckpoint) % 4 == 0, "RTC memory is word addressed");
+
+// HTTP-only time (off by the response's trip) replaces a synced clock only when it is this far off
+static constexpr int64_t kHttpStepThresholdMs = 2000;
+
+// Sync state machine limits
+static constexpr unsigned long kSliceBudgetMs = 4;       // max work per update() call
+static constexpr unsigned long kResolveTimeoutMs = 3000; // DNS answer
+static constexpr unsigned long kConnectTimeoutMs = 3000; // TCP SYN/SYN-ACK, polled
+static constexpr unsigned long kHandshakeTimeoutMs = 5000; // TLS flights and the key exchange
+static constexpr unsigned long kResponseTimeoutMs = 4000; // headers + body
+static constexpr size_t kBodyChunk = 64;         // bytes pulled from the socket per read
+
+static TlsConn httpClient;
+static SntpClient sntp;
+static JsonKeyScanner jsonScanner(kJsonKeys, sizeof(kJsonKeys) / sizeof(kJsonKeys[0]));
+
+// Async DNS: lwIP calls back from its own context, we only publish the result.
+static volatile bool dnsDone = false;
+static volatile bool dnsOk = false;
+static volatile uint8_t dnsGen = 0;
+static IPAddress dnsAddr;
+
+static void onDnsFound(const char* name, const ip_addr_t* ipaddr, void* arg)
+{
+    (void)name;
+    if ((uint8_t)(uintptr_t)arg != dnsGen)
+        return; // answer for an abandoned attempt
+    if (ipaddr)
+        dnsAddr = IPAddress(ipaddr);
+    dnsOk = ipaddr != nullptr;
+    dnsDone = true;
+}
 
 // Internal single instance for legacy/free-function callers
 static TimeMgr _internalTimeMgr;
 
-TimeMgr::TimeMgr() : synced_(false), lastFetchMs_(0), lastTime_("--:--:--"), lastDate_("----------") {}
+TimeMgr::TimeMgr()
+    : synced_(false), lastFetchMs_(0), utcOffsetSec_(0), lastSyncDelayMs_(0), store_(nullptr), wifi_(nullptr),
+      restored_(false), lastSyncMs_(0), syncAgeBaseMs_(0), lastCheckpointMs_(0), clockSeq_(0),
+      haveHttpTime_(false), httpUtcMs_(0),
+      httpRefMs_(0), civilEpoch_(0), civilValid_(false),
+      state_(SyncState::Idle), stateSinceMs_(0), httpCode_(0), lineLen_(0)
+{
+    strcpy(lastTime_, "--:--:--");
+    strcpy(lastDate_, "----------");
+    line_[0] = '\0';
+}
 
 TimeMgr::~TimeMgr() {}
 
@@ -32,248 +101,634 @@ void TimeMgr::init()
 {
     synced_ = false;
     lastFetchMs_ = 0;
-    lastTime_ = "--:--:--";
-    lastDate_ = "----------";
-    lastEpochLocal_ = 0;
+    strcpy(lastTime_, "--:--:--");
+    strcpy(lastDate_, "----------");
+    clock_.reset();
+    haveHttpTime_ = false;
+    restored_ = false;
+    syncAgeBaseMs_ = 0;
+    if (restoreCheckpoint())
+    {
+        synced_ = true;
+        restored_ = true;
+    }
+    civilValid_ = false;
+    state_ = SyncState::Idle;
+}
+
+void TimeMgr::attachStore(RtcStore* store) { store_ = store; }
+void TimeMgr::attachWifi(const WifiMgr* wifi) { wifi_ = wifi; }
+
+uint32_t TimeMgr::syncAgeMs(uint32_t now) const { return syncAgeBaseMs_ + (now - lastSyncMs_); }
+
+bool TimeMgr::restoreCheckpoint()
+{
+    if (!store_)
+        return false;
+    if (!store_->warmBoot())
+    {
+        Serial.println("[Time] cold boot, no checkpoint restore");
+        return false;
+    }
+
+    TimeCheckpoint cp;
+    if (!store_->read(kRtcSlotTime, &cp, sizeof(cp)))
+        return false;
+    if (cp.magic != kCheckpointMagic || cp.crc != crc32(&cp, offsetof(TimeCheckpoint, crc)))
+    {
+        Serial.println("[Time] checkpoint invalid (magic/CRC)");
+        return false;
+    }
+    if (cp.syncAgeMs > kMaxRestoreAgeMs)
+    {
+        Serial.printf("[Time] checkpoint stale (sync age %u s)\n", (unsigned)(cp.syncAgeMs / 1000));
+        return false;
+    }
+
+    // millis() restarted at the reset, so it is (roughly) the time since the
+    // checkpoint; the gap before the reset is at most kCheckpointMs.
+    const uint32_t now = millis();
+    const int64_t utcMs = ((int64_t)cp.utcMsHi << 32 | cp.utcMsLo) + now;
+    clock_.restore(utcMs, now, cp.driftPpb);
+    utcOffsetSec_ = cp.utcOffsetSec;
+    clockSeq_++;
+    lastSyncMs_ = now;
+    syncAgeBaseMs_ = cp.syncAgeMs;
+
+    const uint32_t sec = (uint32_t)(nowEpochMs() / 1000);
+    civilFromEpoch(sec, civil_);
+    civilEpoch_ = sec;
+    civilValid_ = true;
+    formatYmd(civil_, lastDate_, sizeof(lastDate_));
+    formatHms(civil_, lastTime_, sizeof(lastTime_));
+    Serial.printf("[Time] restored %s %s from checkpoint (uptime before reset %u s, sync age %u s)\n", lastDate_,
+                  lastTime_, (unsigned)(cp.millisRef / 1000), (unsigned)(cp.syncAgeMs / 1000));
+    return true;
+}
+
+void TimeMgr::saveCheckpoint(uint32_t now)
+{
+    TimeCheckpoint cp;
+    const int64_t utcMs = clock_.utcAt(now);
+    cp.magic = kCheckpointMagic;
+    cp.utcMsLo = (uint32_t)utcMs;
+    cp.utcMsHi = (uint32_t)((uint64_t)utcMs >> 32);
+    cp.millisRef = now;
+    cp.syncAgeMs = syncAgeMs(now);
+    cp.utcOffsetSec = utcOffsetSec_;
+    cp.driftPpb = clock_.driftPpb();
+    cp.crc = crc32(&cp, offsetof(TimeCheckpoint, crc));
+    store_->write(kRtcSlotTime, &cp, sizeof(cp));
+    lastCheckpointMs_ = now;
+}
+
+void TimeMgr::enter(SyncState s, unsigned long now)
+{
+    state_ = s;
+    stateSinceMs_ = now;
+}
+
+void TimeMgr::finish(unsigned long now)
+{
+    httpClient.stop();
+    sntp.stop();
+    enter(SyncState::Idle, now);
 }
 
 void TimeMgr::update()
 {
+    if (store_ && synced_ && millis() - lastCheckpointMs_ >= kCheckpointMs)
+        saveCheckpoint(millis());
+
     // Only try when WiFi is up
-    if (WiFi.status() != WL_CONNECTED)
+    if (wifi_ ? !wifi_->isConnected() : WiFi.status() != WL_CONNECTED)
+    {
+        if (state_ != SyncState::Idle)
+            finish(millis());
         return;
+    }
 
     const unsigned long now = millis();
-    // Only attempt a fetch if not synced yet or refresh interval passed
-    if (synced_ && (int32_t)(now - lastFetchMs_) < 0)
+
+    switch (state_)
+    {
+    case SyncState::Idle:
+        // Only attempt a fetch if not synced yet or refresh interval passed
+        if (synced_ && (int32_t)(now - lastFetchMs_) < 0)
+            return;
+        // poll interval adapts to the measured oscillator stability; a
+        // restored clock is confirmed right away
+        if (synced_ && !restored_ && (now - lastFetchMs_ < clock_.pollIntervalMs()))
+            return;
+        // throttle rapid retries to once every 5 seconds
+        if ((!synced_ || restored_) && (now - lastFetchMs_ < 5000))
+            return;
+        lastFetchMs_ = now;
+        Serial.printf("[Time] Fetching https://%s%s\n", kTimeApiHost, kTimeApiPath);
+        startResolve(now);
+        break;
+    case SyncState::Resolve:
+        stepResolve(now);
+        break;
+    case SyncState::Connect:
+        stepConnect(now);
+        break;
+    case SyncState::Handshake:
+        stepHandshake(now);
+        break;
+    case SyncState::Request:
+        stepRequest(now);
+        break;
+    case SyncState::ReadHeaders:
+        stepReadHeaders(now);
+        break;
+    case SyncState::ReadBody:
+        stepReadBody(now);
+        break;
+    case SyncState::Parse:
+        stepParse(now);
+        break;
+    case SyncState::Sntp:
+        stepSntp(now);
+        break;
+    }
+}
+
+void TimeMgr::startResolve(unsigned long now)
+{
+    enter(SyncState::Resolve, now);
+    dnsGen++;
+    dnsDone = false;
+    dnsOk = false;
+    // answers already in the lwIP cache come back synchronously
+    ip_addr_t addr;
+    err_t err = dns_gethostbyname(kTimeApiHost, &addr, onDnsFound, (void*)(uintptr_t)dnsGen);
+    if (err == ERR_OK)
+    {
+        dnsAddr = IPAddress(&addr);
+        dnsOk = true;
+        dnsDone = true;
+    }
+    else if (err != ERR_INPROGRESS)
+    {
+        Serial.printf("[Time] dns_gethostbyname err=%d\n", (int)err);
+        startSntp(now);
+    }
+}
+
+void TimeMgr::stepResolve(unsigned long now)
+{
+    if (dnsDone)
+    {
+        if (!dnsOk)
+        {
+            Serial.println("[Time] DNS lookup failed");
+            startSntp(now);
+            return;
+        }
+        startConnect(now);
         return;
-    if (synced_ && (now - lastFetchMs_ < kFetchIntervalMs))
+    }
+    if (now - stateSinceMs_ >= kResolveTimeoutMs)
+    {
+        Serial.println("[Time] DNS timeout");
+        dnsGen++;
+        startSntp(now);
+    }
+}
+
+void TimeMgr::startConnect(unsigned long now)
+{
+    // only sends the SYN; stepConnect() and stepHandshake() watch for the rest
+    if (!httpClient.connect(dnsAddr, kTimeApiPort, kTimeApiHost))
+    {
+        Serial.println("[Time] connect failed");
+        startSntp(now);
         return;
-    // throttle rapid retries to once every 5 seconds
-    if (!synced_ && (now - lastFetchMs_ < 5000))
+    }
+    enter(SyncState::Connect, now);
+}
+
+void TimeMgr::stepConnect(unsigned long now)
+{
+    httpClient.poll();
+    switch (httpClient.state())
+    {
+    case TlsConn::State::Handshake:
+    case TlsConn::State::Open:
+        enter(SyncState::Handshake, now);
         return;
-    lastFetchMs_ = now;
-
-    // Use a secure client for HTTPS; accept any cert for simplicity (not for
-    // production)
-    WiFiClientSecure client;
-    client.setInsecure();
-    HTTPClient http;
-    if (!http.begin(client, kTimeApiUrl))
+    case TlsConn::State::Connecting:
+        if (now - stateSinceMs_ < kConnectTimeoutMs)
+            return;
+        Serial.println("[Time] connect timeout");
+        break;
+    default:
+        Serial.println("[Time] connect failed");
+        break;
+    }
+    httpClient.stop();
+    startSntp(now);
+}
+
+void TimeMgr::stepHandshake(unsigned long now)
+{
+    httpClient.poll();
+    switch (httpClient.state())
+    {
+    case TlsConn::State::Open:
+        enter(SyncState::Request, now);
+        return;
+    case TlsConn::State::Handshake:
+        if (now - stateSinceMs_ < kHandshakeTimeoutMs)
+            return;
+        Serial.println("[Time] TLS handshake timeout");
+        break;
+    default:
+        Serial.printf("[Time] TLS handshake failed, BearSSL err=%d\n", httpClient.lastError());
+        break;
+    }
+    httpClient.stop();
+    startSntp(now);
+}
+
+void TimeMgr::stepRequest(unsigned long now)
+{
+    // HTTP/1.0 keeps the body un-chunked and the server closes when done.
+    char req[128];
+    int n = snprintf(req, sizeof(req), "GET %s HTTP/1.0\r\nHost: %s\r\nConnection: close\r\n\r\n", kTimeApiPath,
+                     kTimeApiHost);
+    if (n <= 0 || (size_t)n >= sizeof(req) || httpClient.write((const uint8_t*)req, (size_t)n) != (size_t)n)
     {
-        Serial.println("[Time] http.begin() failed");
+        Serial.println("[Time] request write failed");
+        httpClient.stop();
+        startSntp(now);
         return;
     }
-    Serial.printf("[Time] Fetching %s\n", kTimeApiUrl);
+    httpCode_ = 0;
+    lineLen_ = 0;
+    enter(SyncState::ReadHeaders, now);
+}
 
-    int code = http.GET();
-    Serial.printf("[Time] HTTP code=%d\n", code);
-    if (code == HTTP_CODE_OK)
+void TimeMgr::stepReadHeaders(unsigned long now)
+{
+    const unsigned long start = millis();
+    while (httpClient.available() > 0 && millis() - start < kSliceBudgetMs)
     {
-        String payload = http.getString();
-        // print a truncated preview of the payload for debugging
-        String preview = payload;
-        if (preview.length() > 200)
-            preview = preview.substring(0, 200) + "...";
-        Serial.printf("[Time] payload(len=%u): %s\n", (unsigned)payload.length(), preview.c_str());
-
-        // Try to parse unixtime (preferred) and utc_offset
-        long unixtime = 0;
-        int p = payload.indexOf("\"unixtime\":");
-        if (p >= 0)
+        int c = httpClient.read();
+        if (c < 0)
+            break;
+        if (c == '\r')
+            continue;
+        if (c != '\n')
         {
-            p += 11; // move past "unixtime":
-            // parse digits
-            int q = p;
-            while (q < payload.length() && isDigit(payload.charAt(q)))
-                q++;
-            if (q > p)
-            {
-                String num = payload.substring(p, q);
-                unixtime = num.toInt();
-                Serial.printf("[Time] parsed unixtime=%ld\n", unixtime);
-            }
+            if ((size_t)lineLen_ + 1 < sizeof(line_))
+                line_[lineLen_++] = (char)c;
+            continue;
         }
 
-        // parse utc_offset like "+01:00"
-        int offsetSeconds = 0;
-        p = payload.indexOf("\"utc_offset\":\"");
-        if (p >= 0)
+        line_[lineLen_] = '\0';
+        if (lineLen_ == 0)
         {
-            p += 14; // move past "utc_offset":"
-            if (p + 6 <= payload.length())
+            // blank line ends the header block
+            Serial.printf("[Time] HTTP code=%d\n", httpCode_);
+            if (httpCode_ != 200)
             {
-                String off = payload.substring(p, p + 6); // e.g. +01:00
-                char sign = off.charAt(0);
-                int hh = (off.charAt(1) - '0') * 10 + (off.charAt(2) - '0');
-                int mm = (off.charAt(4) - '0') * 10 + (off.charAt(5) - '0');
-                offsetSeconds = hh * 3600 + mm * 60;
-                if (sign == '-')
-                    offsetSeconds = -offsetSeconds;
-                Serial.printf("[Time] parsed utc_offset=%s -> %d seconds\n", off.c_str(), offsetSeconds);
+                httpClient.stop();
+                startSntp(now);
+                return;
             }
+            jsonScanner.reset();
+            enter(SyncState::ReadBody, now);
+            return;
+        }
+        if (httpCode_ == 0 && strncmp(line_, "HTTP/", 5) == 0)
+        {
+            const char* sp = strchr(line_, ' ');
+            httpCode_ = sp ? atoi(sp + 1) : -1;
         }
+        lineLen_ = 0;
+    }
 
-        if (unixtime > 0)
+    if (!httpClient.connected() && httpClient.available() == 0)
+    {
+        Serial.println("[Time] connection closed before headers");
+        startSntp(now);
+        return;
+    }
+    if (now - stateSinceMs_ >= kResponseTimeoutMs)
+    {
+        Serial.println("[Time] header timeout");
+        httpClient.stop();
+        startSntp(now);
+    }
+}
+
+void TimeMgr::stepReadBody(unsigned long now)
+{
+    // Body goes through the scanner chunk by chunk, nothing is kept but the
+    // three values; the connection is dropped as soon as they are in.
+    const unsigned long start = millis();
+    uint8_t chunk[kBodyChunk];
+    while (httpClient.available() > 0 && millis() - start < kSliceBudgetMs)
+    {
+        int n = httpClient.read(chunk, sizeof(chunk));
+        if (n <= 0)
+            break;
+        if (!jsonScanner.feed(chunk, (size_t)n))
+            break;
+    }
+
+    if (jsonScanner.finished() || (!httpClient.connected() && httpClient.available() == 0))
+    {
+        httpClient.stop();
+        enter(SyncState::Parse, now);
+        return;
+    }
+    if (now - stateSinceMs_ >= kResponseTimeoutMs)
+    {
+        Serial.println("[Time] body timeout");
+        httpClient.stop();
+        enter(SyncState::Parse, now);
+    }
+}
+
+// Parses exactly n decimal digits; -1 if any of them is not a digit. 64-bit
+// so a 10-digit unixtime past 2038 does not overflow the 32-bit long.
+static int64_t parseDigits(const char* s, int n)
+{
+    int64_t v = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (!isDigit(s[i]))
+            return -1;
+        v = v * 10 + (s[i] - '0');
+    }
+    return v;
+}
+
+void TimeMgr::stepParse(unsigned long now)
+{
+    const JsonKeyScanner& js = jsonScanner;
+    Serial.printf("[Time] body scanned=%u bytes%s unixtime=%s utc_offset=%s datetime=%s\n",
+                  (unsigned)js.bytesSeen(), js.failed() ? " (malformed)" : "",
+                  js.has(kKeyUnixtime) ? js.value(kKeyUnixtime) : "-",
+                  js.has(kKeyUtcOffset) ? js.value(kKeyUtcOffset) : "-",
+                  js.has(kKeyDateTime) ? js.value(kKeyDateTime) : "-");
+
+    // Try to parse unixtime (preferred) and utc_offset
+    int64_t unixtime = 0;
+    if (js.has(kKeyUnixtime) && !js.truncated(kKeyUnixtime))
+    {
+        const char* v = js.value(kKeyUnixtime);
+        int n = 0;
+        while (isDigit(v[n]))
+            n++;
+        // a valid 32-bit epoch has at most 10 digits
+        if (n > 0 && n <= 10 && v[n] == '\0')
+            unixtime = parseDigits(v, n);
+    }
+
+    // parse utc_offset like "+01:00"
+    int offsetSeconds = 0;
+    if (js.has(kKeyUtcOffset))
+    {
+        const char* off = js.value(kKeyUtcOffset);
+        const bool shape = strlen(off) >= (size_t)kUtcOffsetLen && (off[0] == '+' || off[0] == '-') && off[3] == ':';
+        const long hh = shape ? parseDigits(off + 1, 2) : -1;
+        const long mm = shape ? parseDigits(off + 4, 2) : -1;
+        if (hh >= 0 && mm >= 0)
         {
-            lastEpochLocal_ = (unsigned long)unixtime + (unsigned long)offsetSeconds;
-            lastFetchMs_ = now;
-            Serial.printf("[Time] unixtime=%ld offset=%d -> lastEpochLocal=%lu\n", unixtime, offsetSeconds,
-                          lastEpochLocal_);
-            // initialize lastDate_/lastTime_ from epoch
-            time_t t = (time_t)lastEpochLocal_;
-            struct tm* tm = gmtime(&t);
-            if (tm)
-            {
-                char buf[32];
-                snprintf(buf, sizeof(buf), "%04d-%02d-%02d", tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday);
-                lastDate_ = String(buf);
-                snprintf(buf, sizeof(buf), "%02d:%02d:%02d", tm->tm_hour, tm->tm_min, tm->tm_sec);
-                lastTime_ = String(buf);
-                synced_ = true;
-                Serial.printf("[Time] initial date=%s time=%s\n", lastDate_.c_str(), lastTime_.c_str());
-            }
+            offsetSeconds = (int)(hh * 3600 + mm * 60);
+            if (off[0] == '-')
+                offsetSeconds = -offsetSeconds;
+            utcOffsetSec_ = offsetSeconds;
+            Serial.printf("[Time] parsed utc_offset=%s -> %d seconds\n", off, offsetSeconds);
         }
-        // fallback: try the datetime key parsing (legacy)
-        else
+    }
+
+    if (unixtime > 0)
+    {
+        // datetime carries the fraction unixtime drops; zone offsets are
+        // whole minutes, so its seconds are unixtime's
+        int64_t fracMs = 0;
+        const char* dt = js.has(kKeyDateTime) ? js.value(kKeyDateTime) : "";
+        if (strlen(dt) > (size_t)kDateTimeTotalLen + 3 && dt[kDateTimeTotalLen] == '.' &&
+            parseDigits(dt + kSecondPos, 2) == unixtime % 60)
+        {
+            const int64_t ms = parseDigits(dt + kDateTimeTotalLen + 1, 3);
+            fracMs = ms > 0 ? ms : 0;
+        }
+        useHttpTime(unixtime * 1000 + fracMs, now);
+        Serial.printf("[Time] unixtime=%s offset=%d -> %s %s\n", js.value(kKeyUnixtime), offsetSeconds, lastDate_,
+                      lastTime_);
+    }
+    // fallback: try the datetime key parsing (legacy)
+    else if (js.has(kKeyDateTime) && strlen(js.value(kKeyDateTime)) >= (size_t)kDateTimeTotalLen &&
+             js.value(kKeyDateTime)[kDateTimeTPos] == 'T')
+    {
+        const char* dt = js.value(kKeyDateTime);
+        // parse components YYYY-MM-DDTHH:MM:SS
+        const long y = parseDigits(dt, 4);
+        const long mo = parseDigits(dt + 5, 2);
+        const long d = parseDigits(dt + 8, 2);
+        const long hh = parseDigits(dt + 11, 2);
+        const long mm = parseDigits(dt + 14, 2);
+        const long ss = parseDigits(dt + kSecondPos, 2);
+
+        // parseDigits() gives -1 for a non-digit; ss 60 is a leap second
+        if (y >= 1970 && mo >= 1 && mo <= 12 && d >= 1 && d <= 31 && hh >= 0 && hh < 24 && mm >= 0 && mm < 60 &&
+            ss >= 0 && ss < 61)
         {
-            int q = payload.indexOf(kDateTimeKey);
-            if (q >= 0)
+            // compute days since epoch using civil_from_days
+            // algorithm
+            auto days_from_civil = [](int y, unsigned m, unsigned d) -> int64_t
             {
-                q += (int)kDateTimeKeyLen;
-                if (q + kDateTimeTotalLen <= payload.length())
-                {
-                    String dt = payload.substring(q, q + kDateTimeTotalLen);
-                    if (dt.length() >= kDateTimeTotalLen && dt.charAt(kDateTimeTPos) == 'T')
-                    {
-                        // parse components YYYY-MM-DDTHH:MM:SS
-                        int y = dt.substring(0, 4).toInt();
-                        int mo = dt.substring(5, 7).toInt();
-                        int d = dt.substring(8, 10).toInt();
-                        int hh = dt.substring(11, 13).toInt();
-                        int mm = dt.substring(14, 16).toInt();
-                        int ss = dt.substring(17, 19).toInt();
-
-                        // compute days since epoch using civil_from_days
-                        // algorithm
-                        auto days_from_civil = [](int y, unsigned m, unsigned d) -> int64_t
-                        {
-                            y -= m <= 2;
-                            const int64_t era = (y >= 0 ? y : y - 399) / 400;
-                            const unsigned yoe = (unsigned)(y - era * 400);
-                            const unsigned doy = (153 * (m + (m > 2 ? -3u : 9u)) + 2) / 5 + d - 1;
-                            const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
-                            return era * 146097 + (int64_t)doe - 719468;
-                        };
-
-                        int64_t days = days_from_civil(y, (unsigned)mo, (unsigned)d);
-                        unsigned long epoch = (unsigned long)(days * 86400LL + hh * 3600 + mm * 60 + ss);
-                        // apply utc_offset if available (offsetSeconds parsed
-                        // earlier)
-                        epoch -= (unsigned long)offsetSeconds;
-
-                        lastEpochLocal_ = epoch;
-                        lastDate_ = dt.substring(0, kDateLen);
-                        lastTime_ = dt.substring(kTimeStart, kTimeStart + kTimeLen);
-                        synced_ = true;
-                        lastFetchMs_ = now;
-                        Serial.printf("[Time] fallback datetime=%s -> "
-                                      "epoch=%lu (offsetApplied=%d)\n",
-                                      dt.c_str(), epoch, offsetSeconds);
-                    }
-                }
-            }
+                y -= m <= 2;
+                const int64_t era = (y >= 0 ? y : y - 399) / 400;
+                const unsigned yoe = (unsigned)(y - era * 400);
+                const unsigned doy = (153 * (m + (m > 2 ? -3u : 9u)) + 2) / 5 + d - 1;
+                const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+                return era * 146097 + (int64_t)doe - 719468;
+            };
+
+            int64_t days = days_from_civil((int)y, (unsigned)mo, (unsigned)d);
+            unsigned long epoch = (unsigned long)(days * 86400LL + hh * 3600 + mm * 60 + ss);
+            // apply utc_offset if available (offsetSeconds parsed
+            // earlier)
+            epoch -= (unsigned long)offsetSeconds;
+
+            useHttpTime((int64_t)epoch * 1000, now);
+            memcpy(lastDate_, dt, kDateLen);
+            lastDate_[kDateLen] = '\0';
+            memcpy(lastTime_, dt + kTimeStart, kTimeLen);
+            lastTime_[kTimeLen] = '\0';
+            Serial.printf("[Time] fallback datetime=%.19s -> "
+                          "epoch=%lu (offsetApplied=%d)\n",
+                          dt, epoch, offsetSeconds);
         }
     }
-    http.end();
 
-    // If still not synced, try SNTP as fallback and log status
+    // HTTP is off by the response's trip (and gives the zone offset); SNTP refines it
+    startSntp(now);
+}
+
+void TimeMgr::useHttpTime(int64_t utcMs, uint32_t refMillis)
+{
+    // Good enough for a first fix; once synced it only serves as a fallback
+    // for a failed SNTP round, so it does not disturb the drift estimate.
+    haveHttpTime_ = true;
+    httpUtcMs_ = utcMs;
+    httpRefMs_ = refMillis;
     if (!synced_)
+        setClock(utcMs, refMillis, false);
+}
+
+void TimeMgr::startSntp(unsigned long now)
+{
+    Serial.println("[Time] starting SNTP round...");
+    sntp.start(now);
+    enter(SyncState::Sntp, now);
+}
+
+void TimeMgr::stepSntp(unsigned long now)
+{
+    if (sntp.poll(now))
+        return;
+
+    if (sntp.hasResult())
+    {
+        const SntpSample& best = sntp.best();
+        const uint32_t ref = millis();
+        // slow answers carry up to delay/2 of error; don't let them steer the frequency
+        const bool precise = best.delayMs <= ClockDiscipline::kMaxErrorMs;
+        setClock((int64_t)ref + best.offsetMs, ref, precise);
+        lastSyncDelayMs_ = best.delayMs;
+        Serial.printf("[Time][NTP] OK server=%u delay=%u ms err=%d ms drift=%d ppb next poll=%u s -> %s %s\n",
+                      best.server, (unsigned)best.delayMs, (int)clock_.lastErrorMs(), (int)clock_.driftPpb(),
+                      (unsigned)(clock_.pollIntervalMs() / 1000), lastDate_, lastTime_);
+    }
+    else if (haveHttpTime_ && synced_)
     {
-        Serial.println("[Time] attempting SNTP fallback...");
-        // prepare NTP packet (48 bytes)
-        uint8_t packet[48];
-        memset(packet, 0, sizeof(packet));
-        packet[0] = 0x1B; // LI=0, VN=3, Mode=3 (client)
-
-        sntpUdp.begin(0);
-        sntpUdp.beginPacket(kNtpServer, kNtpPort);
-        sntpUdp.write(packet, sizeof(packet));
-        int res = sntpUdp.endPacket();
-        Serial.printf("[Time][NTP] send result=%d\n", res);
-
-        unsigned long start = millis();
-        while (millis() - start < 1500)
+        const int64_t diff = httpUtcMs_ - clock_.utcAt(httpRefMs_);
+        // a restored clock is only as good as the checkpoint, take HTTP over it
+        if (restored_ || diff > kHttpStepThresholdMs || diff < -kHttpStepThresholdMs)
         {
-            int len = sntpUdp.parsePacket();
-            if (len >= 48)
-            {
-                Serial.printf("[Time][NTP] response_len=%d\n", len);
-                uint8_t buf[48];
-                sntpUdp.read(buf, 48);
-                unsigned long sec = ((unsigned long)buf[40] << 24) | ((unsigned long)buf[41] << 16) |
-                                    ((unsigned long)buf[42] << 8) | ((unsigned long)buf[43]);
-                const unsigned long seventyYears = 2208988800UL;
-                if (sec > seventyYears)
-                {
-                    unsigned long unix = sec - seventyYears;
-                    lastEpochLocal_ = unix;
-                    lastFetchMs_ = millis();
-                    time_t t = (time_t)lastEpochLocal_;
-                    struct tm* tm = gmtime(&t);
-                    if (tm)
-                    {
-                        char buf2[32];
-                        snprintf(buf2, sizeof(buf2), "%04d-%02d-%02d", tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday);
-                        lastDate_ = String(buf2);
-                        snprintf(buf2, sizeof(buf2), "%02d:%02d:%02d", tm->tm_hour, tm->tm_min, tm->tm_sec);
-                        lastTime_ = String(buf2);
-                    }
-                    synced_ = true;
-                    Serial.printf("[Time][NTP] OK unix=%lu -> %s %s\n", unix, lastDate_.c_str(), lastTime_.c_str());
-                }
-                else
-                {
-                    Serial.printf("[Time][NTP] invalid ntp seconds=%lu\n", sec);
-                }
-                sntpUdp.stop();
-                break;
-            }
-            delay(10);
+            Serial.printf("[Time] SNTP failed, HTTP time off by %ld ms, stepping\n", (long)diff);
+            setClock(httpUtcMs_, httpRefMs_, false);
         }
-        sntpUdp.stop();
     }
+    else if (!synced_)
+    {
+        Serial.println("[Time][NTP] no usable reply");
+    }
+    haveHttpTime_ = false;
+    finish(now);
+}
+
+void TimeMgr::setClock(int64_t utcMs, uint32_t refMillis, bool precise)
+{
+    if (clock_.valid())
+    {
+        const int64_t offMs = utcMs - clock_.utcAt(refMillis);
+        telemetry().record(Telemetry::SyncOffsetMs,
+                           offMs > INT32_MAX ? INT32_MAX : offMs < INT32_MIN ? INT32_MIN : (int32_t)offMs);
+    }
+    // a restored reference is off by the unknown reset gap (up to
+    // kCheckpointMs), which addSample() would read as frequency error
+    if (precise && !restored_)
+        clock_.addSample(utcMs, refMillis);
+    else
+        clock_.step(utcMs, refMillis);
+    clockSeq_++;
+    lastFetchMs_ = refMillis;
+    lastSyncMs_ = refMillis;
+    syncAgeBaseMs_ = 0;
+    restored_ = false;
+    // initialize lastDate_/lastTime_ from epoch
+    const uint32_t sec = (uint32_t)(nowEpochMs() / 1000);
+    civilFromEpoch(sec, civil_);
+    civilEpoch_ = sec;
+    civilValid_ = true;
+    formatYmd(civil_, lastDate_, sizeof(lastDate_));
+    formatHms(civil_, lastTime_, sizeof(lastTime_));
+    synced_ = true;
+}
+
+int64_t TimeMgr::nowEpochMs() const
+{
+    return clock_.utcAt(millis()) + (int64_t)utcOffsetSec_ * 1000;
+}
+
+uint32_t TimeMgr::msToNextSecond() const
+{
+    if (!synced_)
+        return 1000;
+    int64_t ms = nowEpochMs() % 1000;
+    if (ms < 0)
+        ms += 1000;
+    return (uint32_t)(1000 - ms);
+}
+
+const CivilTime& TimeMgr::civilAt(unsigned long sec) const
+{
+    // the usual step is +1 s; anything backwards or over a day is recomputed
+    if (civilValid_ && sec >= civilEpoch_ && sec - civilEpoch_ <= 86400UL)
+        civilAdvance(civil_, sec - civilEpoch_);
+    else
+        civilFromEpoch(sec, civil_);
+    civilEpoch_ = sec;
+    civilValid_ = true;
+    return civil_;
 }
 
 bool TimeMgr::isSynced() const { return synced_; }
+bool TimeMgr::isSyncing() const { return state_ != SyncState::Idle; }
+
+bool TimeMgr::formatTime(char* dst, size_t cap) const
+{
+    return formatTime(synced_ ? nowEpochMs() : 0, dst, cap);
+}
+
+bool TimeMgr::formatDate(char* dst, size_t cap) const
+{
+    return formatDate(synced_ ? nowEpochMs() : 0, dst, cap);
+}
+
+bool TimeMgr::formatTime(int64_t epochMs, char* dst, size_t cap) const
+{
+    if (!synced_)
+    {
+        if (cap <= strlen(lastTime_))
+            return false;
+        strcpy(dst, lastTime_);
+        return true;
+    }
+    return formatHms(civilAt((unsigned long)(epochMs / 1000)), dst, cap);
+}
+
+bool TimeMgr::formatDate(int64_t epochMs, char* dst, size_t cap) const
+{
+    if (!synced_)
+    {
+        if (cap <= strlen(lastDate_))
+            return false;
+        strcpy(dst, lastDate_);
+        return true;
+    }
+    return formatYmd(civilAt((unsigned long)(epochMs / 1000)), dst, cap);
+}
+
 String TimeMgr::timeString() const
 {
-    if (!synced_ || lastEpochLocal_ == 0)
-        return lastTime_;
-    unsigned long now = millis();
-    unsigned long cur = lastEpochLocal_ + ((now - lastFetchMs_) / 1000UL);
-    time_t t = (time_t)cur;
-    struct tm* tm = gmtime(&t);
-    if (!tm)
-        return lastTime_;
     char buf[16];
-    snprintf(buf, sizeof(buf), "%02d:%02d:%02d", tm->tm_hour, tm->tm_min, tm->tm_sec);
-    return String(buf);
+    return formatTime(buf, sizeof(buf)) ? String(buf) : String(lastTime_);
 }
 
 String TimeMgr::dateString() const
 {
-    if (!synced_ || lastEpochLocal_ == 0)
-        return lastDate_;
-    unsigned long now = millis();
-    unsigned long cur = lastEpochLocal_ + ((now - lastFetchMs_) / 1000UL);
-    time_t t = (time_t)cur;
-    struct tm* tm = gmtime(&t);
-    if (!tm)
-        return lastDate_;
     char buf[16];
-    snprintf(buf, sizeof(buf), "%04d-%02d-%02d", tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday);
-    return String(buf);
+    return formatDate(buf, sizeof(buf)) ? String(buf) : String(lastDate_);
 }
 
 // Legacy API implementations (forwarders)
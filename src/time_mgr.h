@@ -1,24 +1,114 @@
 #pragma once
+#include "civil_time.h"
+#include "clock_discipline.h"
 #include <Arduino.h>
 
+class RtcStore;
+class WifiMgr;
+
 class TimeMgr
 {
 public:
   TimeMgr();
   ~TimeMgr();
 
+  // Optional warm-boot persistence; attach before init() to restore from it.
+  void attachStore(RtcStore* store);
+  // Link state comes from wifi's snapshot; without one, update() asks the SDK.
+  void attachWifi(const WifiMgr* wifi);
+
   void init();
+  // Advances the sync state machine by one bounded slice (see kSliceBudgetMs).
   void update();
 
   bool isSynced() const;
+  bool isSyncing() const;
+  bool isRestored() const { return restored_; } // running on a warm-boot checkpoint, not yet confirmed
+  // Local time in ms since epoch (timezone and drift applied); valid once synced.
+  int64_t nowEpochMs() const;
+  // Zone offset nowEpochMs() adds to UTC; 0 until the time API has answered.
+  int32_t utcOffsetSec() const { return utcOffsetSec_; }
+  // ms until the local time reaches the next whole second (1..1000); 1000 while unsynced.
+  uint32_t msToNextSecond() const;
+  const ClockDiscipline& clock() const { return clock_; }
+  // Changes whenever a sync or a warm-boot restore sets the clock, so
+  // whatever was timed by the old one can be timed again.
+  uint32_t clockSeq() const { return clockSeq_; }
+  uint32_t lastSyncDelayMs() const { return lastSyncDelayMs_; } // SNTP round trip of the sample in use
+  // Current local time into a caller buffer, no heap; false if cap is too small.
+  bool formatTime(char* dst, size_t cap) const; // "HH:MM:SS"
+  bool formatDate(char* dst, size_t cap) const; // "YYYY-MM-DD"
+  // Same, at a nowEpochMs() reading the caller already took.
+  bool formatTime(int64_t epochMs, char* dst, size_t cap) const;
+  bool formatDate(int64_t epochMs, char* dst, size_t cap) const;
   String timeString() const; // "HH:MM:SS"
   String dateString() const; // "YYYY-MM-DD"
 private:
+  // resolve -> connect -> TLS handshake -> request -> read headers -> read
+  // body -> parse, then an SNTP round (see SntpClient) that refines or replaces the HTTP time.
+  enum class SyncState : uint8_t
+  {
+    Idle,
+    Resolve,
+    Connect,
+    Handshake,
+    Request,
+    ReadHeaders,
+    ReadBody,
+    Parse,
+    Sntp,
+  };
+
+  void enter(SyncState s, unsigned long now);
+  void finish(unsigned long now);
+  void startResolve(unsigned long now);
+  void stepResolve(unsigned long now);
+  void startConnect(unsigned long now);
+  void stepConnect(unsigned long now);
+  void stepHandshake(unsigned long now);
+  void stepRequest(unsigned long now);
+  void stepReadHeaders(unsigned long now);
+  void stepReadBody(unsigned long now);
+  void stepParse(unsigned long now);
+  void startSntp(unsigned long now);
+  void stepSntp(unsigned long now);
+  // UTC epoch ms utcMs was true at millis() == refMillis. Precise samples
+  // also update the drift estimate and poll interval, except the one that
+  // confirms a restored checkpoint: that only steps.
+  void setClock(int64_t utcMs, uint32_t refMillis, bool precise);
+  void useHttpTime(int64_t utcMs, uint32_t refMillis);
+  bool restoreCheckpoint();
+  void saveCheckpoint(uint32_t now);
+  uint32_t syncAgeMs(uint32_t now) const;
+  // Calendar form of local epoch second sec, advanced from the previous call.
+  const CivilTime& civilAt(unsigned long sec) const;
+
   bool synced_;
   unsigned long lastFetchMs_;
-  String lastTime_;
-  String lastDate_;
-  unsigned long lastEpochLocal_; // seconds since epoch adjusted to local timezone
+  char lastTime_[9];  // shown until synced
+  char lastDate_[11];
+  ClockDiscipline clock_; // millis() -> UTC, drift corrected
+  int32_t utcOffsetSec_;  // from the time API, turns UTC into local time
+  uint32_t lastSyncDelayMs_;
+  RtcStore* store_;
+  const WifiMgr* wifi_;
+  bool restored_;
+  uint32_t lastSyncMs_;       // millis() of the last real sync
+  uint32_t syncAgeBaseMs_;    // sync age carried over from before a warm boot
+  uint32_t lastCheckpointMs_;
+  uint32_t clockSeq_;
+  bool haveHttpTime_;     // this round's HTTP result, pending the SNTP outcome
+  int64_t httpUtcMs_;
+  uint32_t httpRefMs_;
+  mutable CivilTime civil_;
+  mutable unsigned long civilEpoch_; // epoch that civil_ describes
+  mutable bool civilValid_;
+
+  SyncState state_;
+  unsigned long stateSinceMs_;
+  int httpCode_;
+  char line_[96]; // current HTTP header line
+  uint8_t lineLen_;
 };
 
 // Compatibility wrappers (legacy API)
@@ -0,0 +1,61 @@
+#pragma once
+#include "tcp_conn.h"
+#include <Arduino.h>
+
+// Non-blocking TLS client: BearSSL's record engine over TcpConn.
+//
+// poll() moves whatever records are ready between the socket and the engine
+// and returns; nothing waits on the network, so the handshake spreads over
+// as many calls as its round trips take. The one step that cannot be split
+// is BearSSL's key exchange once the server's flight is in, a single call of
+// a few hundred ms at 80 MHz. The engine runs on the core's separate BearSSL
+// stack (StackThunk), as in WiFiClientSecure, whose connect() blocks for the
+// whole handshake instead.
+//
+// Like the WiFiClientSecure::setInsecure() client it replaces, it takes the
+// server's key without checking the certificate chain: before the first sync
+// there is no clock to check validity dates against.
+class TlsConn
+{
+public:
+    enum class State : uint8_t
+    {
+        Closed,     // never opened, stopped, or closed by the peer
+        Connecting, // SYN sent
+        Handshake,
+        Open,
+        Failed, // TCP or TLS error, see lastError()
+    };
+
+    TlsConn();
+    ~TlsConn();
+
+    // Starts the TCP handshake for host (sent as SNI); false if it cannot
+    // even begin, e.g. no heap for the engine and its 16 KB record buffer.
+    bool connect(IPAddress ip, uint16_t port, const char* host);
+    // Runs the engine on what the socket has; call before state().
+    void poll();
+    State state() const { return state_; }
+    // Handshake done and the socket not closed by either side; data may remain after.
+    bool connected() const { return state_ == State::Open && tcp_.connected(); }
+    int lastError() const { return error_; } // BearSSL BR_ERR_*, 0 for none
+
+    // Queues data (encrypted) and pushes it out; returns n, or 0 if it did not fit.
+    size_t write(const uint8_t* data, size_t n);
+    int available();
+    int read();
+    int read(uint8_t* buf, size_t n);
+
+    // Drops the connection and frees the engine.
+    void stop();
+
+private:
+    struct Session; // engine, X.509 context and record buffer, one per connection
+
+    void fail(int err);
+
+    TcpConn tcp_;
+    Session* s_;
+    State state_;
+    int error_;
+};
@@ -0,0 +1,165 @@
+#include "ui_clock.h"
+#include "glyph_cache.h"
+#include "ui_fonts.h"
+#include <U8g2lib.h>
+#include <string.h>
+
+// Digit geometry: seven segments kSeg pixels thick with tapered ends
+static constexpr int kDigitW = 14;
+static constexpr int kDigitH = 32;
+static constexpr int kSeg = 3;
+static constexpr uint8_t kPages = kDigitH / 8;
+static constexpr uint8_t kFirstPage = 2; // rows 16..47
+static constexpr uint8_t kColonW = 8;
+
+// Cell positions of "HH:MM:SS", centered: six 16 px digit cells, two 8 px colons
+static constexpr uint8_t kCellX[ClockScreen::kCells] = {9, 25, 41, 49, 65, 81, 89, 105};
+
+// Text lines, each two pages high
+static constexpr uint8_t kLinePage[] = {0, 6};
+static constexpr int16_t kLineBaseline[] = {12, 60};
+
+enum : uint8_t
+{
+  kDash = 10,
+  kColon = 11,
+  kBlank = 12,
+  kGlyphs = 13,
+  kNoGlyph = 0xFF,
+};
+
+// Segments a..g as bits 0..6, for 0-9 and the dash
+static constexpr uint8_t kSegments[] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F, 0x40};
+
+constexpr int absInt(int v) { return v < 0 ? -v : v; }
+
+// Horizontal bar with its top row at y0
+constexpr bool hBar(int x, int y, int y0)
+{
+  return y >= y0 && y < y0 + kSeg && x >= 1 + absInt(y - y0 - 1) && x < kDigitW - 1 - absInt(y - y0 - 1);
+}
+
+// Vertical bar in columns [x0, x0 + kSeg), rows [y0, y1)
+constexpr bool vBar(int x, int y, int x0, int y0, int y1)
+{
+  return x >= x0 && x < x0 + kSeg && y >= y0 + 1 + absInt(x - x0 - 1) && y < y1 - 1 - absInt(x - x0 - 1);
+}
+
+constexpr bool bigPixel(uint8_t glyph, int x, int y)
+{
+  if (glyph == kColon)
+    return x >= 2 && x < 2 + kSeg && ((y >= 9 && y < 9 + kSeg) || (y >= 20 && y < 20 + kSeg));
+  if (glyph > kDash)
+    return false;
+  const uint8_t seg = kSegments[glyph];
+  const int mid = kDigitH / 2 - 2;
+  const int right = kDigitW - kSeg;
+  return ((seg & 0x01) && hBar(x, y, 0)) ||                       // a
+         ((seg & 0x02) && vBar(x, y, right, 0, mid + 2)) ||       // b
+         ((seg & 0x04) && vBar(x, y, right, mid + 1, kDigitH)) || // c
+         ((seg & 0x08) && hBar(x, y, kDigitH - kSeg)) ||          // d
+         ((seg & 0x10) && vBar(x, y, 0, mid + 1, kDigitH)) ||     // e
+         ((seg & 0x20) && vBar(x, y, 0, 0, mid + 2)) ||           // f
+         ((seg & 0x40) && hBar(x, y, mid));                       // g
+}
+
+// Glyphs in frame buffer layout: per page, one byte per column, bit 0 on top
+struct BigGlyphs
+{
+  uint8_t page[kGlyphs][kPages][kDigitW];
+};
+
+constexpr BigGlyphs renderBigGlyphs()
+{
+  BigGlyphs t{};
+  for (uint8_t g = 0; g < kGlyphs; g++)
+    for (uint8_t p = 0; p < kPages; p++)
+      for (int x = 0; x < kDigitW; x++)
+      {
+        uint8_t b = 0;
+        for (int bit = 0; bit < 8; bit++)
+          if (bigPixel(g, x, p * 8 + bit))
+            b |= (uint8_t)(1 << bit);
+        t.page[g][p][x] = b;
+      }
+  return t;
+}
+
+static constexpr BigGlyphs kBigGlyphs PROGMEM = renderBigGlyphs();
+
+static uint8_t glyphFor(char c)
+{
+  if (c >= '0' && c <= '9')
+    return (uint8_t)(c - '0');
+  if (c == ':')
+    return kColon;
+  if (c == '-')
+    return kDash;
+  return kBlank;
+}
+
+ClockScreen::ClockScreen() : valid_(false)
+{
+  memset(cells_, kNoGlyph, sizeof(cells_));
+  memset(lines_, 0, sizeof(lines_));
+}
+
+void ClockScreen::composeWifi(const UiStatus& s, char* out)
+{
+  const char* ssid = s.wifi_ssid ? s.wifi_ssid : "-";
+  if (s.wifi_connected)
+    snprintf(out, kMaxText, "%s %ddBm", ssid, s.wifi_rssi);
+  else
+    snprintf(out, kMaxText, "%s (conn...)", ssid);
+}
+
+bool ClockScreen::updateLine(U8G2& u8g2, Line line, const char* text)
+{
+  if (valid_ && strcmp(lines_[line], text) == 0)
+    return false;
+  strncpy(lines_[line], text, kMaxText - 1);
+  lines_[line][kMaxText - 1] = '\0';
+
+  const uint16_t stride = (uint16_t)u8g2.getBufferTileWidth() * 8;
+  memset(u8g2.getBufferPtr() + kLinePage[line] * stride, 0, 2 * stride);
+  const int w = glyphCache().strAdvance(u8g2, lines_[line]);
+  const int x = w < (int)stride ? ((int)stride - w) / 2 : 0;
+  glyphCache().drawStr(u8g2, x, kLineBaseline[line], lines_[line]);
+  return true;
+}
+
+uint8_t ClockScreen::update(U8G2& u8g2, const UiStatus& s)
+{
+  if (!valid_)
+  {
+    u8g2.clearBuffer();
+    memset(cells_, kNoGlyph, sizeof(cells_));
+  }
+
+  uint8_t count = 0;
+  const char* hms = s.time_hms ? s.time_hms : "--:--:--";
+  uint8_t* buf = u8g2.getBufferPtr();
+  const uint16_t stride = (uint16_t)u8g2.getBufferTileWidth() * 8;
+  bool ended = false;
+  for (uint8_t i = 0; i < kCells; i++)
+  {
+    ended = ended || !hms[i];
+    const uint8_t g = ended ? (uint8_t)kBlank : glyphFor(hms[i]);
+    if (g == cells_[i])
+      continue;
+    cells_[i] = g;
+    const uint8_t w = (i == 2 || i == 5) ? kColonW : kDigitW;
+    for (uint8_t p = 0; p < kPages; p++)
+      memcpy_P(buf + (kFirstPage + p) * stride + kCellX[i], kBigGlyphs.page[g][p], w);
+    count++;
+  }
+
+  char wifi[kMaxText];
+  composeWifi(s, wifi);
+  u8g2.setFont(ui_font_6x12);
+  count += updateLine(u8g2, DateLine, s.date_ymd ? s.date_ymd : "----------");
+  count += updateLine(u8g2, WifiLine, wifi);
+
+  valid_ = true;
+  return count;
+}
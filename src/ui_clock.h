@@ -0,0 +1,44 @@
+#pragma once
+#include "ui_status.h"
+#include <Arduino.h>
+
+class U8G2;
+
+// Big-digit clock face: HH:MM:SS in 14x32 seven-segment digits across the
+// middle four pages, the date centered above and the WiFi line below, both
+// in the 6x12 UI font.
+//
+// Everything is page aligned. A digit cell is a column run of
+// pre-rendered bytes (a constexpr table in flash) copied straight into the
+// frame buffer, one memcpy per page; a text line owns two whole pages and is
+// cleared and redrawn only when its text changes. A seconds tick therefore
+// touches one cell, two on a tens rollover.
+class ClockScreen
+{
+public:
+  static constexpr uint8_t kCells = 8; // "HH:MM:SS"
+  static constexpr uint8_t kMaxText = 40;
+
+  ClockScreen();
+
+  // Brings the frame buffer in line with s. Returns the number of digit cells
+  // and text lines rewritten; 0 means the buffer is unchanged.
+  uint8_t update(U8G2& u8g2, const UiStatus& s);
+  // Next update() clears the buffer and draws everything.
+  void invalidate() { valid_ = false; }
+
+private:
+  enum Line : uint8_t
+  {
+    DateLine,
+    WifiLine,
+    kLines,
+  };
+
+  static void composeWifi(const UiStatus& s, char* out);
+  bool updateLine(U8G2& u8g2, Line line, const char* text);
+
+  uint8_t cells_[kCells]; // glyph index shown in each cell
+  char lines_[kLines][kMaxText];
+  bool valid_;
+};
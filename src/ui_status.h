@@ -9,4 +9,6 @@ struct UiStatus
   bool wifi_connected;
   const char* wifi_ssid; // "asusyo24"
   int wifi_rssi;         // -55 dBm (optional)
+
+  const char* ticker; // bottom line, scrolls when too wide (optional)
 };
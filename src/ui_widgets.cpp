@@ -0,0 +1,124 @@
+#include "ui_widgets.h"
+#include "glyph_cache.h"
+#include "ui_fonts.h"
+#include <U8g2lib.h>
+#include <string.h>
+
+// Baseline of each widget's line; widgets with the same baseline follow each
+// other in Id order, starting at x = 0.
+static constexpr int16_t kLine1Y = 14;
+static constexpr int16_t kLine2Y = 30;
+static const int16_t kBaseline[] = {kLine1Y, kLine1Y, kLine2Y, kLine2Y, kLine2Y, kLine2Y};
+static constexpr uint8_t kTickerPage = 5; // rows 40..55
+
+static void copyText(char* dst, const char* src)
+{
+  strncpy(dst, src, StatusScreen::kMaxText - 1);
+  dst[StatusScreen::kMaxText - 1] = '\0';
+}
+
+StatusScreen::StatusScreen() : valid_(false)
+{
+  memset(widgets_, 0, sizeof(widgets_));
+  ticker_.place(0, 128, kTickerPage);
+}
+
+void StatusScreen::compose(const UiStatus& s, char (&text)[kCount][kMaxText])
+{
+  copyText(text[Date], s.date_ymd ? s.date_ymd : "----------");
+  text[Time][0] = ' ';
+  strncpy(text[Time] + 1, s.time_hms ? s.time_hms : "--:--:--", kMaxText - 2);
+  text[Time][kMaxText - 1] = '\0';
+  copyText(text[Label], "WiFi:");
+  copyText(text[Ssid], s.wifi_ssid ? s.wifi_ssid : "-");
+  if (s.wifi_connected)
+  {
+    snprintf(text[Rssi], kMaxText, " %ddBm", s.wifi_rssi);
+    text[State][0] = '\0';
+  }
+  else
+  {
+    text[Rssi][0] = '\0';
+    copyText(text[State], " (conn...)");
+  }
+}
+
+uint8_t StatusScreen::update(U8G2& u8g2, const UiStatus& s)
+{
+  char text[kCount][kMaxText];
+  compose(s, text);
+
+  u8g2.setFont(ui_font_6x12);
+  const bool full = !valid_;
+
+  // Lay out: a widget is dirty if its text changed or it moved
+  bool dirty[kCount];
+  int16_t newX[kCount];
+  uint16_t newW[kCount];
+  uint8_t count = 0;
+  int16_t x = 0;
+  for (uint8_t i = 0; i < kCount; i++)
+  {
+    if (i > 0 && kBaseline[i] != kBaseline[i - 1])
+      x = 0;
+    const Widget& w = widgets_[i];
+    const bool changed = full || strcmp(w.text, text[i]) != 0;
+    newX[i] = x;
+    newW[i] = changed ? glyphCache().strAdvance(u8g2, text[i]) : w.w;
+    dirty[i] = changed || (x != w.x && (w.w > 0 || newW[i] > 0));
+    x += (int16_t)newW[i];
+    if (dirty[i])
+      count++;
+  }
+  const bool tickerChanged = ticker_.setText(u8g2, s.ticker ? s.ticker : "");
+  if (tickerChanged)
+    count++;
+  if (count == 0)
+    return 0;
+
+  // Box rows of a line: the font's full height around the baseline
+  const u8g2_t* g = u8g2.getU8g2();
+  const int16_t above = g->font_info.max_char_height + g->font_info.y_offset;
+  const int16_t height = g->font_info.max_char_height;
+
+  if (full)
+  {
+    u8g2.clearBuffer();
+  }
+  else
+  {
+    // erase every old box first, so a moved widget cannot wipe a redrawn one
+    u8g2.setDrawColor(0);
+    for (uint8_t i = 0; i < kCount; i++)
+    {
+      const Widget& w = widgets_[i];
+      if (dirty[i] && w.w > 0)
+        u8g2.drawBox(w.x, kBaseline[i] - above, w.w, height);
+    }
+    u8g2.setDrawColor(1);
+  }
+
+  for (uint8_t i = 0; i < kCount; i++)
+  {
+    if (!dirty[i])
+      continue;
+    Widget& w = widgets_[i];
+    w.x = newX[i];
+    w.w = newW[i];
+    memcpy(w.text, text[i], kMaxText);
+    if (w.text[0])
+      glyphCache().drawStr(u8g2, w.x, kBaseline[i], w.text);
+  }
+  if (full || tickerChanged)
+    ticker_.draw(u8g2);
+  valid_ = true;
+  return count;
+}
+
+bool StatusScreen::animate(U8G2& u8g2, uint32_t nowMs)
+{
+  if (!valid_ || !ticker_.advance(nowMs))
+    return false;
+  ticker_.draw(u8g2);
+  return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "marquee.h"
+#include "ui_status.h"
+#include <Arduino.h>
+
+class U8G2;
+
+// Retained status screen: date, time, SSID, RSSI and link state are separate
+// text widgets laid out left to right on two lines. update() re-renders only
+// the widgets whose text changed (and those pushed sideways by a width
+// change), erasing their previous box first, and leaves the rest of the
+// frame buffer alone. Assumes glyph ink stays inside the advance width,
+// which holds for the fixed-width 6x12 font used here (ui_font_6x12, printable
+// ASCII only; see tools/font_subsets.txt). Text is measured and drawn
+// through glyphCache(). The ticker line below them is a Marquee.
+class StatusScreen
+{
+public:
+  static constexpr uint8_t kMaxText = 40; // per widget, bytes incl. terminator
+
+  StatusScreen();
+
+  // Brings the frame buffer in line with s. Returns the number of widgets
+  // redrawn; 0 means the buffer is unchanged.
+  uint8_t update(U8G2& u8g2, const UiStatus& s);
+  // Next update() clears the buffer and draws every widget.
+  void invalidate() { valid_ = false; }
+  // Scrolls the ticker on to nowMs. Returns true if the frame buffer changed.
+  bool animate(U8G2& u8g2, uint32_t nowMs);
+  const Marquee& ticker() const { return ticker_; }
+
+private:
+  enum Id : uint8_t
+  {
+    Date,
+    Time,
+    Label,
+    Ssid,
+    Rssi,  // " -61dBm" while connected
+    State, // " (conn...)" while not
+    kCount,
+  };
+
+  struct Widget
+  {
+    int16_t x;
+    uint16_t w; // advance of text, the widget's box width
+    char text[kMaxText];
+  };
+
+  static void compose(const UiStatus& s, char (&text)[kCount][kMaxText]);
+
+  Widget widgets_[kCount];
+  Marquee ticker_;
+  bool valid_;
+};
@@ -1,6 +1,9 @@
 // (intentionally empty)
 #include "wifi_mgr.h"
+#include "rtc_store.h"
+#include "telemetry.h"
 #include <ESP8266WiFi.h>
+#include <stddef.h>
 
 static const char* kSsid = "asusyo24";
 static const char* kPass = "cheche452";
@@ -13,33 +16,191 @@ static uint32_t nextTryMs = 0;
 static uint32_t backoffMs = 3000; // start 3s
 static const uint32_t kBackoffMax = 60000;
 
+// The core drops event handlers whose returned handle is released, so keep them.
+static WiFiEventHandler gotIpHandler;
+static WiFiEventHandler disconnectedHandler;
+static WiFiEventHandler connectedHandler;
+
+// Fast reconnect: last good AP (BSSID + channel) and DHCP lease, kept in RAM
+// and in RTC user memory so a warm boot skips the scan and DHCP too.
+static constexpr uint32_t kCacheMagic = 0x57464332UL; // "WFC2"
+static constexpr uint32_t kFastTimeoutMs = 3000;       // directed attempt, then full scan + DHCP
+// A static config never renews the lease it copies, so the router may hand
+// the address out again once the lease runs out. Reuse it only for half the
+// shortest lease home routers give (1 h), where a DHCP client would renew;
+// after that the directed join asks DHCP again, and a link still up on the
+// copy rejoins with DHCP (see WifiMgr::loop()).
+static constexpr uint32_t kLeaseReuseMs = 30UL * 60 * 1000;
+static constexpr uint32_t kCacheRefreshMs = 60000; // keeps leaseAgeS in RTC memory current
+
+struct WifiCache
+{
+  uint32_t magic;
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t reserved;
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t mask;
+  uint32_t dns;
+  uint32_t leaseAgeS; // time since the DHCP exchange behind ip/gateway/mask/dns, when written
+  uint32_t crc;       // over all fields above
+};
+static_assert(sizeof(WifiCache) % 4 == 0, "RTC memory is word addressed");
+
+static RtcStore* store = nullptr;
+static WifiCache cache;
+static bool cacheValid = false;
+static bool fastFailed = false; // last directed attempt failed, next one does a full scan
+static uint32_t leaseStartMs = 0; // millis() of the DHCP exchange (negative ages after a warm boot wrap)
+static uint32_t cacheSavedMs = 0;
+
+// Per-attempt connect timing
+static uint32_t attemptStartMs = 0;
+static bool attemptFast = false;
+static bool attemptStatic = false; // cached lease applied, no DHCP
+static bool attemptDone = true;
+static uint32_t lastConnectMs = 0;
+static bool lastConnectFast = false;
+
+static WifiMgr::Snapshot snap;
+static uint32_t rssiPeriodMs = WifiMgr::kRssiPeriodMs;
+static uint32_t lastRssiMs = 0;
+
+static uint32_t leaseAgeMs() { return millis() - leaseStartMs; }
+
+static void saveCache()
+{
+  // saturate, so a long-lived link cannot wrap the age around to fresh
+  if (leaseAgeMs() > kLeaseReuseMs)
+    leaseStartMs = millis() - kLeaseReuseMs;
+  cacheSavedMs = millis();
+  cache.magic = kCacheMagic;
+  cache.reserved = 0;
+  cache.leaseAgeS = leaseAgeMs() / 1000;
+  cache.crc = crc32(&cache, offsetof(WifiCache, crc));
+  cacheValid = true;
+  if (store)
+    store->write(kRtcSlotWifi, &cache, sizeof(cache));
+}
+
+static void loadCache()
+{
+  WifiCache c;
+  if (!store || !store->read(kRtcSlotWifi, &c, sizeof(c)))
+    return;
+  if (c.magic != kCacheMagic || c.crc != crc32(&c, offsetof(WifiCache, crc)))
+    return;
+  cache = c;
+  cacheValid = true;
+  // the reset itself took negligible time (see RtcStore::warmBoot())
+  leaseStartMs = millis() - c.leaseAgeS * 1000;
+  Serial.printf("[WiFi] cached AP %02X:%02X:%02X:%02X:%02X:%02X ch=%u, lease %u s old\n", c.bssid[0], c.bssid[1],
+                c.bssid[2], c.bssid[3], c.bssid[4], c.bssid[5], c.channel, (unsigned)c.leaseAgeS);
+}
+
+static void onConnected(const WiFiEventStationModeConnected& e)
+{
+  Serial.printf("[WiFi] CONNECTED to '%s' CH=%d\n", e.ssid.c_str(), e.channel);
+  snap.link = WifiMgr::Snapshot::Link::Associated;
+  const size_t n = e.ssid.length() < sizeof(snap.ssid) ? e.ssid.length() : sizeof(snap.ssid) - 1;
+  memcpy(snap.ssid, e.ssid.c_str(), n);
+  snap.ssid[n] = '\0';
+  memcpy(snap.bssid, e.bssid, sizeof(snap.bssid));
+  snap.channel = e.channel;
+  snap.associatedMs = millis();
+  snap.seq++;
+}
+
+static void onDisconnected(const WiFiEventStationModeDisconnected& e)
+{
+  Serial.printf("[WiFi] DISCONNECTED reason=%d\n", (int)e.reason);
+  snap.link = WifiMgr::Snapshot::Link::Down;
+  snap.ip = 0;
+  snap.rssi = 0;
+  snap.disconnectReason = (uint8_t)e.reason;
+  snap.disconnectedMs = millis();
+  snap.seq++;
+}
+
+static void onGotIp(const WiFiEventStationModeGotIP& e)
+{
+  const uint32_t now = millis();
+  Serial.printf("[WiFi] GOT IP: %u.%u.%u.%u\n", e.ip[0], e.ip[1], e.ip[2], e.ip[3]);
+  snap.link = WifiMgr::Snapshot::Link::Up;
+  snap.ip = (uint32_t)e.ip;
+  snap.gotIpMs = now;
+  // first reading right away, so the first frame with the link has one
+  snap.rssi = (int8_t)WiFi.RSSI();
+  lastRssiMs = now;
+  telemetry().record(Telemetry::Rssi, snap.rssi);
+  snap.seq++;
+
+  if (!attemptDone)
+  {
+    attemptDone = true;
+    lastConnectMs = now - attemptStartMs;
+    lastConnectFast = attemptFast;
+    Serial.printf("[WiFi] connected in %u ms (%s)\n", (unsigned)lastConnectMs, attemptFast ? "fast" : "full");
+  }
+  fastFailed = false;
+
+  // a static config keeps the age of the lease it came from
+  if (!attemptStatic)
+    leaseStartMs = now;
+  memcpy(cache.bssid, snap.bssid, sizeof(cache.bssid));
+  cache.channel = snap.channel;
+  cache.ip = (uint32_t)e.ip;
+  cache.gateway = (uint32_t)e.gw;
+  cache.mask = (uint32_t)e.mask;
+  cache.dns = (uint32_t)WiFi.dnsIP(0);
+  saveCache();
+}
+
 static void installWifiHandlersOnce()
 {
   if (installedHandlers)
     return;
   installedHandlers = true;
 
-  WiFi.onStationModeGotIP([](const WiFiEventStationModeGotIP& e)
-                          { Serial.printf("[WiFi] GOT IP: %s\n", e.ip.toString().c_str()); });
-
-  WiFi.onStationModeDisconnected([](const WiFiEventStationModeDisconnected& e)
-                                 { Serial.printf("[WiFi] DISCONNECTED reason=%d\n", (int)e.reason); });
-
-  WiFi.onStationModeConnected([](const WiFiEventStationModeConnected& e)
-                              { Serial.printf("[WiFi] CONNECTED to '%s' CH=%d\n", e.ssid.c_str(), e.channel); });
+  gotIpHandler = WiFi.onStationModeGotIP(onGotIp);
+  disconnectedHandler = WiFi.onStationModeDisconnected(onDisconnected);
+  connectedHandler = WiFi.onStationModeConnected(onConnected);
 }
 
 static void startConnect()
 {
-  Serial.printf("[WiFi] Connecting to '%s'...\n", kSsid);
+  const bool fast = cacheValid && !fastFailed;
+  const bool reuseLease = fast && leaseAgeMs() < kLeaseReuseMs;
+  Serial.printf("[WiFi] Connecting to '%s' (%s)...\n", kSsid,
+                reuseLease ? "fast" : fast ? "fast, DHCP" : "full");
 
   WiFi.mode(WIFI_STA);
   WiFi.persistent(false);
-  WiFi.setAutoReconnect(true);
+  // The SDK's own rejoin after a drop would keep the copied lease however old
+  // it gets; with one in use, loop()'s retry rejoins and checks its age first
+  WiFi.setAutoReconnect(!reuseLease);
   WiFi.setSleepMode(WIFI_NONE_SLEEP);
   WiFi.setOutputPower(20.5f);
 
-  // Soft reset of state (NOT erase):
+  attemptStartMs = millis();
+  attemptFast = fast;
+  attemptStatic = reuseLease;
+  attemptDone = false;
+
+  if (fast)
+  {
+    // Directed join: no channel scan, and no DHCP exchange while the lease is fresh
+    if (reuseLease)
+      WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.mask), IPAddress(cache.dns));
+    else
+      WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+    WiFi.begin(kSsid, kPass, cache.channel, cache.bssid);
+    return;
+  }
+
+  // Back to DHCP, then a soft reset of state (NOT erase):
+  WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
   WiFi.disconnect(false);
   delay(80);
 
@@ -51,23 +212,62 @@ static void startConnect()
 WifiMgr::WifiMgr() {}
 WifiMgr::~WifiMgr() {}
 
+void WifiMgr::attachStore(RtcStore* rtc) { store = rtc; }
+
+uint32_t WifiMgr::lastConnectMs() const { return ::lastConnectMs; }
+void WifiMgr::setRssiPeriod(uint32_t ms) { rssiPeriodMs = ms; }
+const WifiMgr::Snapshot& WifiMgr::snapshot() const { return snap; }
+uint32_t WifiMgr::seq() const { return snap.seq; }
+bool WifiMgr::lastConnectFast() const { return ::lastConnectFast; }
+
 void WifiMgr::init()
 {
   installWifiHandlersOnce();
+  loadCache();
   startConnect();
   nextTryMs = millis() + backoffMs;
 }
 
 void WifiMgr::loop()
 {
-  if (WiFi.status() == WL_CONNECTED)
+  const uint32_t now = millis();
+  if (snap.link == Snapshot::Link::Up)
   {
+    if (now - lastRssiMs >= rssiPeriodMs)
+    {
+      lastRssiMs = now;
+      const int8_t rssi = (int8_t)WiFi.RSSI();
+      telemetry().record(Telemetry::Rssi, rssi);
+      if (rssi != snap.rssi)
+      {
+        snap.rssi = rssi;
+        snap.seq++;
+      }
+    }
+    if (cacheValid && now - cacheSavedMs >= kCacheRefreshMs)
+      saveCache();
     backoffMs = 3000;
-    nextTryMs = millis() + backoffMs;
+    nextTryMs = now + backoffMs;
+    if (attemptStatic && leaseAgeMs() >= kLeaseReuseMs)
+    {
+      // nothing renews the copied lease while it is up: rejoin the same AP with DHCP
+      Serial.printf("[WiFi] copied lease %u s old, rejoining with DHCP\n", (unsigned)(leaseAgeMs() / 1000));
+      WiFi.disconnect(false);
+      startConnect();
+    }
+    return;
+  }
+
+  if (attemptFast && !attemptDone && now - attemptStartMs >= kFastTimeoutMs)
+  {
+    // cached AP/lease did not work (moved AP, new lease...): full scan + DHCP now
+    Serial.printf("[WiFi] fast connect timed out after %u ms\n", (unsigned)kFastTimeoutMs);
+    fastFailed = true;
+    startConnect();
+    nextTryMs = now + backoffMs;
     return;
   }
 
-  const uint32_t now = millis();
   if ((int32_t)(now - nextTryMs) >= 0)
   {
     Serial.printf("[WiFi] retry (backoff=%u ms)\n", backoffMs);
@@ -78,7 +278,48 @@ void WifiMgr::loop()
   }
 }
 
-String WifiMgr::ssid() const { return (WiFi.status() == WL_CONNECTED) ? WiFi.SSID() : String(kSsid); }
-String WifiMgr::ip() const { return (WiFi.status() == WL_CONNECTED) ? WiFi.localIP().toString() : String("-"); }
-bool WifiMgr::isConnected() const { return WiFi.status() == WL_CONNECTED; }
-int WifiMgr::rssi() const { return (WiFi.status() == WL_CONNECTED) ? WiFi.RSSI() : 0; }
+static void copyStr(char* dst, size_t cap, const char* src, size_t len)
+{
+  if (cap == 0)
+    return;
+  if (len >= cap)
+    len = cap - 1;
+  memcpy(dst, src, len);
+  dst[len] = '\0';
+}
+
+void WifiMgr::ssid(char* dst, size_t cap) const
+{
+  const char* s = isConnected() ? snap.ssid : kSsid;
+  copyStr(dst, cap, s, strlen(s));
+}
+
+void WifiMgr::ip(char* dst, size_t cap) const
+{
+  if (!isConnected())
+  {
+    copyStr(dst, cap, "-", 1);
+    return;
+  }
+  // IPAddress::toString() allocates; format the octets by hand
+  const IPAddress a(snap.ip);
+  char buf[16];
+  size_t n = 0;
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    uint8_t v = a[i];
+    if (i)
+      buf[n++] = '.';
+    if (v >= 100)
+      buf[n++] = (char)('0' + v / 100);
+    if (v >= 10)
+      buf[n++] = (char)('0' + (v / 10) % 10);
+    buf[n++] = (char)('0' + v % 10);
+  }
+  copyStr(dst, cap, buf, n);
+}
+
+String WifiMgr::ssid() const { return String(isConnected() ? snap.ssid : kSsid); }
+String WifiMgr::ip() const { return isConnected() ? IPAddress(snap.ip).toString() : String("-"); }
+bool WifiMgr::isConnected() const { return snap.link == Snapshot::Link::Up; }
+int WifiMgr::rssi() const { return isConnected() ? snap.rssi : 0; }
@@ -2,15 +2,65 @@
 #pragma once
 #include <Arduino.h>
 
+class RtcStore;
+
 class WifiMgr
 {
 public:
+  static constexpr uint32_t kRssiPeriodMs = 2000; // default RSSI refresh while connected
+
+  // Station state as last reported by the SDK. The onStationMode* events
+  // fill it and loop() refreshes the RSSI, so reading it never calls into
+  // the SDK. seq changes whenever any other field does.
+  struct Snapshot
+  {
+    enum class Link : uint8_t
+    {
+      Down,
+      Associated, // joined the AP, no IP yet
+      Up,         // has an IP: WiFi.status() == WL_CONNECTED
+    };
+
+    Link link;
+    char ssid[33];            // of the current/last association
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint32_t ip;              // 0 unless Up
+    int8_t rssi;              // dBm, 0 unless Up
+    uint8_t disconnectReason; // WiFiDisconnectReason of the last drop, 0 = none yet
+    uint32_t associatedMs;    // millis() of the last CONNECTED event
+    uint32_t gotIpMs;         // millis() of the last GOT_IP event
+    uint32_t disconnectedMs;  // millis() of the last DISCONNECTED event
+    uint32_t seq;
+  };
+
   WifiMgr();
   ~WifiMgr();
 
+  // Optional: keeps the fast-reconnect cache across warm boots; attach before init().
+  void attachStore(RtcStore* rtc);
+
   void init();
   void loop();
 
+  // How often loop() reads the RSSI while connected; takes effect at the next read.
+  void setRssiPeriod(uint32_t ms);
+
+  const Snapshot& snapshot() const;
+  // Cheap change check: consumers keep the last value and skip their work
+  // while it is unchanged.
+  uint32_t seq() const;
+
+  // Time from starting the last successful attempt to GOT_IP, and whether it
+  // used the cached BSSID/channel (plus the cached lease while that is fresh).
+  uint32_t lastConnectMs() const;
+  bool lastConnectFast() const;
+
+  // The accessors below read the snapshot.
+  // Allocation-free variants: always NUL-terminate, truncating to cap.
+  void ssid(char* dst, size_t cap) const;
+  void ip(char* dst, size_t cap) const;
+
   String ssid() const;
   String ip() const;
   bool isConnected() const;
@@ -0,0 +1,208 @@
+// civilFromEpoch() and civilAdvance() against the host's gmtime_r() over the
+// whole uint32_t epoch range (1970-01-01 .. 2106-02-07, so 2000 and 2100 on
+// both sides of the century leap rule), civilAdvance() chained second by
+// second over a few days, and what one call costs.
+#include "civil_time.h"
+#include <string.h>
+#include <time.h>
+#include <unity.h>
+
+static uint64_t hostNs()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t rng = 12345;
+static uint32_t nextRandom()
+{
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+static bool sameAsGmtime(uint32_t epoch, const CivilTime& c)
+{
+  const time_t t = (time_t)epoch;
+  tm g;
+  gmtime_r(&t, &g);
+  return c.year == g.tm_year + 1900 && c.month == g.tm_mon + 1 && c.day == g.tm_mday && c.hour == g.tm_hour &&
+         c.minute == g.tm_min && c.second == g.tm_sec;
+}
+
+static bool sameCivil(const CivilTime& a, const CivilTime& b)
+{
+  return a.year == b.year && a.month == b.month && a.day == b.day && a.hour == b.hour && a.minute == b.minute &&
+         a.second == b.second;
+}
+
+static void failAt(const char* what, uint32_t epoch)
+{
+  char msg[64];
+  snprintf(msg, sizeof(msg), "%s differs at epoch %lu", what, (unsigned long)epoch);
+  TEST_FAIL_MESSAGE(msg);
+}
+
+// Every day of the range at its first and last second, plus random instants.
+static void test_from_epoch_matches_gmtime()
+{
+  CivilTime c;
+  for (uint64_t day = 0; day * 86400ULL <= UINT32_MAX; day++)
+  {
+    const uint32_t first = (uint32_t)(day * 86400ULL);
+    civilFromEpoch(first, c);
+    if (!sameAsGmtime(first, c))
+      return failAt("civilFromEpoch", first);
+    if (first + 86399ULL > UINT32_MAX)
+      break;
+    civilFromEpoch(first + 86399, c);
+    if (!sameAsGmtime(first + 86399, c))
+      return failAt("civilFromEpoch", first + 86399);
+  }
+  for (int i = 0; i < 1000000; i++)
+  {
+    const uint32_t e = nextRandom();
+    civilFromEpoch(e, c);
+    if (!sameAsGmtime(e, c))
+      return failAt("civilFromEpoch", e);
+  }
+  civilFromEpoch(UINT32_MAX, c);
+  TEST_ASSERT_TRUE(sameAsGmtime(UINT32_MAX, c));
+}
+
+// The 1 s step the clock takes, walked across every midnight of the range.
+static void test_advance_across_every_midnight()
+{
+  CivilTime c;
+  for (uint32_t e = 86399; e < UINT32_MAX - 86400; e += 86400)
+  {
+    civilFromEpoch(e, c);
+    civilAdvance(c, 1);
+    if (!sameAsGmtime(e + 1, c))
+      return failAt("civilAdvance(1)", e + 1);
+  }
+}
+
+// The clock's own path: one CivilTime carried forward 1 s at a time, as
+// TimeMgr::civilAt() does frame to frame, and checked at every second of a
+// few days around a year boundary and each kind of February.
+static void test_advance_second_by_second()
+{
+  static const uint32_t kStarts[] = {
+      1703894400U, // 2023-12-30, into 2024
+      1708992000U, // 2024-02-27, through Feb 29
+      951609600U,  // 2000-02-27, leap by the 400-year rule
+      4107369600U, // 2100-02-27, not a leap year
+      4291574400U, // 2105-12-30, into 2106
+  };
+  for (uint32_t start : kStarts)
+  {
+    CivilTime c;
+    civilFromEpoch(start, c);
+    for (uint32_t e = start + 1; e <= start + 4 * 86400U; e++)
+    {
+      civilAdvance(c, 1);
+      if (!sameAsGmtime(e, c))
+        return failAt("civilAdvance(1) chain", e);
+    }
+  }
+}
+
+// Larger catch-up steps (a missed tick, a resync) from random instants.
+static void test_advance_random_steps()
+{
+  CivilTime c, want;
+  for (int i = 0; i < 200000; i++)
+  {
+    const uint32_t e = nextRandom() % (UINT32_MAX - 4000000U);
+    const uint32_t step = (i & 1) ? nextRandom() % 120 : nextRandom() % 4000000U;
+    civilFromEpoch(e, c);
+    civilAdvance(c, step);
+    civilFromEpoch(e + step, want);
+    if (!sameCivil(c, want) || !sameAsGmtime(e + step, c))
+      return failAt("civilAdvance", e + step);
+  }
+}
+
+static void test_format_matches_strftime()
+{
+  for (int i = 0; i < 10000; i++)
+  {
+    const uint32_t e = nextRandom();
+    CivilTime c;
+    civilFromEpoch(e, c);
+    const time_t t = (time_t)e;
+    tm g;
+    gmtime_r(&t, &g);
+    char want[16], got[16];
+    strftime(want, sizeof(want), "%H:%M:%S", &g);
+    TEST_ASSERT_TRUE(formatHms(c, got, sizeof(got)));
+    TEST_ASSERT_EQUAL_STRING(want, got);
+    strftime(want, sizeof(want), "%Y-%m-%d", &g);
+    TEST_ASSERT_TRUE(formatYmd(c, got, sizeof(got)));
+    TEST_ASSERT_EQUAL_STRING(want, got);
+  }
+  CivilTime c;
+  char small[8] = "x";
+  civilFromEpoch(0, c);
+  TEST_ASSERT_FALSE(formatHms(c, small, sizeof(small)));
+  TEST_ASSERT_FALSE(formatYmd(c, small, sizeof(small)));
+  TEST_ASSERT_EQUAL_STRING("x", small);
+}
+
+static void test_benchmark_per_call()
+{
+  static constexpr int kCalls = 2000000;
+  volatile uint32_t sink = 0;
+  CivilTime c;
+
+  uint64_t t0 = hostNs();
+  for (int i = 0; i < kCalls; i++)
+  {
+    civilFromEpoch(1700000000U + (uint32_t)i * 7919U, c);
+    sink = sink + c.day;
+  }
+  const double fromNs = (double)(hostNs() - t0) / kCalls;
+
+  civilFromEpoch(1700000000U, c);
+  t0 = hostNs();
+  for (int i = 0; i < kCalls; i++)
+  {
+    civilAdvance(c, 1);
+    sink = sink + c.second;
+  }
+  const double advanceNs = (double)(hostNs() - t0) / kCalls;
+
+  t0 = hostNs();
+  for (int i = 0; i < kCalls; i++)
+  {
+    const time_t t = (time_t)(1700000000U + (uint32_t)i * 7919U);
+    tm g;
+    gmtime_r(&t, &g);
+    sink = sink + (uint32_t)g.tm_mday;
+  }
+  const double gmNs = (double)(hostNs() - t0) / kCalls;
+
+  char msg[128];
+  snprintf(msg, sizeof(msg), "per call: civilFromEpoch %.1f ns, civilAdvance(1) %.1f ns, gmtime_r %.1f ns", fromNs,
+           advanceNs, gmNs);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE(advanceNs <= fromNs);
+}
+
+void setUp() {}
+void tearDown() {}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_from_epoch_matches_gmtime);
+  RUN_TEST(test_advance_across_every_midnight);
+  RUN_TEST(test_advance_second_by_second);
+  RUN_TEST(test_advance_random_steps);
+  RUN_TEST(test_format_matches_strftime);
+  RUN_TEST(test_benchmark_per_call);
+  return UNITY_END();
+}
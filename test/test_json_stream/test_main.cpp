@@ -0,0 +1,295 @@
+// JsonKeyScanner fed the way TimeMgr::stepReadBody() feeds it: 64-byte reads
+// from a Stream that hands the body out in TCP-sized pieces. Recorded time
+// API bodies, every way of splitting them, and corrupted or cut-off copies.
+#include "json_stream.h"
+#include <Arduino.h>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unity.h>
+
+static constexpr size_t kBodyChunk = 64; // as in time_mgr.cpp
+
+enum Key : uint8_t
+{
+  kUnixtime,
+  kUtcOffset,
+  kDateTime,
+};
+static const char* const kKeys[] = {"unixtime", "utc_offset", "datetime"};
+
+// worldtimeapi.org/api/ip as it came off the wire
+static const char kRecorded[] =
+    "{\"abbreviation\":\"MSK\",\"client_ip\":\"95.24.17.131\",\"datetime\":\"2024-10-03T21:14:07.412318+03:00\","
+    "\"day_of_week\":4,\"day_of_year\":277,\"dst\":false,\"dst_from\":null,\"dst_offset\":0,\"dst_until\":null,"
+    "\"raw_offset\":10800,\"timezone\":\"Europe/Moscow\",\"unixtime\":1727979247,"
+    "\"utc_datetime\":\"2024-10-03T18:14:07.412318+00:00\",\"utc_offset\":\"+03:00\",\"week_number\":40}";
+
+// Same keys behind nested values, escapes and an over-long key that shares
+// a prefix with a wanted one.
+static const char kNested[] =
+    "{ \"meta\" : {\"unixtime\": 1, \"tags\": [\"a\\\"}\", {\"utc_offset\":\"+99:99\"}], \"x\": []},\n"
+    "  \"unixtime_and_then_some\": 5, \"note\": \"say \\\"hi\\\" {[\",\r\n"
+    "  \"unixtime\" :\t4102444800 , \"utc_offset\":\"-05:30\", \"datetime\":\"2100-01-01T00:00:00.000000-05:30\",\n"
+    "  \"tail\": [1, 2, {\"datetime\": \"no\"}] }";
+
+struct Expected
+{
+  const char* unixtime;
+  const char* utcOffset;
+  const char* datetime;
+};
+static const Expected kRecordedValues = {"1727979247", "+03:00", "2024-10-03T21:14:07.412318+03:00"};
+static const Expected kNestedValues = {"4102444800", "-05:30", "2100-01-01T00:00:00.000000-05:30"};
+
+// Heap use while the scanner runs; it is meant to be zero.
+static size_t heapAllocs = 0;
+void* operator new(size_t n)
+{
+  heapAllocs++;
+  void* p = malloc(n ? n : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// Hands out `data` in pieces of the given sizes (cycled), one piece per
+// available() window, like pbufs arriving on a TcpConn.
+class FakeStream : public Stream
+{
+public:
+  FakeStream(const char* data, size_t len, const size_t* pieces, size_t pieceCount)
+      : data_(data), len_(len), pieces_(pieces), pieceCount_(pieceCount)
+  {
+    nextPiece();
+  }
+
+  int available() override { return (int)(windowEnd_ - pos_); }
+  int read() override
+  {
+    if (pos_ >= windowEnd_)
+      return -1;
+    const uint8_t c = (uint8_t)data_[pos_++];
+    if (pos_ == windowEnd_)
+      nextPiece();
+    return c;
+  }
+  size_t write(uint8_t) override { return 0; }
+
+  int read(uint8_t* buf, size_t n)
+  {
+    size_t got = 0;
+    while (got < n && available() > 0)
+      buf[got++] = (uint8_t)read();
+    return (int)got;
+  }
+
+  size_t windows() const { return windows_; }
+
+private:
+  void nextPiece()
+  {
+    const size_t piece = pieces_[windows_++ % pieceCount_];
+    windowEnd_ = pos_ + piece > len_ ? len_ : pos_ + piece;
+  }
+
+  const char* data_;
+  size_t len_;
+  const size_t* pieces_;
+  size_t pieceCount_;
+  size_t pos_ = 0;
+  size_t windowEnd_ = 0;
+  size_t windows_ = 0;
+};
+
+// stepReadBody() without the time slices: read, feed, stop once finished.
+static void drain(FakeStream& in, JsonKeyScanner& js)
+{
+  uint8_t chunk[kBodyChunk];
+  while (in.available() > 0)
+  {
+    const int n = in.read(chunk, sizeof(chunk));
+    if (n <= 0 || !js.feed(chunk, (size_t)n))
+      break;
+  }
+}
+
+static void scan(const char* body, size_t len, const size_t* pieces, size_t pieceCount, JsonKeyScanner& js)
+{
+  js.reset();
+  FakeStream in(body, len, pieces, pieceCount);
+  drain(in, js);
+}
+
+static void checkValues(const JsonKeyScanner& js, const Expected& want)
+{
+  TEST_ASSERT_TRUE(js.complete());
+  TEST_ASSERT_FALSE(js.failed());
+  TEST_ASSERT_EQUAL_STRING(want.unixtime, js.value(kUnixtime));
+  TEST_ASSERT_EQUAL_STRING(want.utcOffset, js.value(kUtcOffset));
+  TEST_ASSERT_EQUAL_STRING(want.datetime, js.value(kDateTime));
+  for (uint8_t i = 0; i < 3; i++)
+    TEST_ASSERT_FALSE(js.truncated(i));
+}
+
+// No matter what came in, values stay terminated inside their buffers.
+static void checkBounded(const JsonKeyScanner& js, size_t len)
+{
+  TEST_ASSERT_TRUE(js.bytesSeen() <= len);
+  for (uint8_t i = 0; i < 3; i++)
+    TEST_ASSERT_TRUE(strnlen(js.value(i), JsonKeyScanner::kMaxValueLen + 1) <= JsonKeyScanner::kMaxValueLen);
+}
+
+static void test_recorded_bodies()
+{
+  static const size_t kWhole[] = {4096};
+  JsonKeyScanner js(kKeys, 3);
+  scan(kRecorded, sizeof(kRecorded) - 1, kWhole, 1, js);
+  checkValues(js, kRecordedValues);
+  // utc_offset is the last wanted key: the tail after it is never read
+  TEST_ASSERT_TRUE(js.bytesSeen() < sizeof(kRecorded) - 1);
+  TEST_ASSERT_EQUAL_STRING(",\"week_number\":40}", kRecorded + js.bytesSeen());
+
+  scan(kNested, sizeof(kNested) - 1, kWhole, 1, js);
+  checkValues(js, kNestedValues);
+}
+
+// Every piece size from 1 byte up, then every single cut point.
+static void test_every_split()
+{
+  JsonKeyScanner js(kKeys, 3);
+  const struct
+  {
+    const char* body;
+    size_t len;
+    const Expected& want;
+  } kBodies[] = {{kRecorded, sizeof(kRecorded) - 1, kRecordedValues}, {kNested, sizeof(kNested) - 1, kNestedValues}};
+
+  for (const auto& b : kBodies)
+  {
+    for (size_t piece = 1; piece <= b.len; piece++)
+    {
+      scan(b.body, b.len, &piece, 1, js);
+      checkValues(js, b.want);
+    }
+    for (size_t cut = 1; cut < b.len; cut++)
+    {
+      const size_t pieces[] = {cut, b.len - cut};
+      scan(b.body, b.len, pieces, 2, js);
+      checkValues(js, b.want);
+    }
+    // uneven, TCP-like: MSS-sized, a sliver, a 1-byte segment
+    static const size_t kUneven[] = {536, 7, 1, 60, 3};
+    scan(b.body, b.len, kUneven, 5, js);
+    checkValues(js, b.want);
+  }
+}
+
+// The body cut off at every byte: a key is reported only if its whole value
+// arrived, and a partial value never leaks out.
+static void test_truncated_bodies()
+{
+  static const size_t kPieces[] = {13};
+  JsonKeyScanner js(kKeys, 3);
+  const size_t len = sizeof(kRecorded) - 1;
+  const Expected& want = kRecordedValues;
+  const char* const wantValues[] = {want.unixtime, want.utcOffset, want.datetime};
+  for (size_t cut = 0; cut < len; cut++)
+  {
+    scan(kRecorded, cut, kPieces, 1, js);
+    checkBounded(js, cut);
+    TEST_ASSERT_FALSE(js.failed());
+    for (uint8_t i = 0; i < 3; i++)
+    {
+      // a string value is complete once its closing quote is in
+      char quoted[64];
+      snprintf(quoted, sizeof(quoted), "\"%s\":%s%s%s", kKeys[i], i == kUnixtime ? "" : "\"", wantValues[i],
+               i == kUnixtime ? "," : "\"");
+      const char* at = strstr(kRecorded, quoted);
+      TEST_ASSERT_NOT_NULL(at);
+      const size_t valueEnd = (size_t)(at - kRecorded) + strlen(quoted);
+      TEST_ASSERT_EQUAL(cut >= valueEnd, js.has(i));
+      TEST_ASSERT_EQUAL_STRING(js.has(i) ? wantValues[i] : "", js.value(i));
+    }
+  }
+}
+
+// Every byte replaced by each structural or control character in turn.
+// Whatever the scanner makes of it, it stops cleanly and stays in bounds;
+// damage after the last wanted value changes nothing.
+static void test_corrupted_bodies()
+{
+  static const char kBad[] = {'"', '{', '}', '[', ']', ',', ':', '\\', '\0', '\x01', '\n', 'x'};
+  static const size_t kPieces[] = {kBodyChunk, 5};
+  JsonKeyScanner js(kKeys, 3);
+  const size_t len = sizeof(kRecorded) - 1;
+  char body[sizeof(kRecorded)];
+
+  scan(kRecorded, len, kPieces, 2, js);
+  const size_t lastUsed = js.bytesSeen();
+
+  uint32_t failed = 0, complete = 0;
+  for (size_t at = 0; at < len; at++)
+  {
+    for (char bad : kBad)
+    {
+      memcpy(body, kRecorded, sizeof(body));
+      body[at] = bad;
+      scan(body, len, kPieces, 2, js);
+      checkBounded(js, len);
+      failed += js.failed();
+      complete += js.complete();
+      if (at >= lastUsed)
+        checkValues(js, kRecordedValues);
+    }
+  }
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%u corrupted bodies: %u rejected as malformed, %u still complete",
+           (unsigned)(len * sizeof(kBad)), (unsigned)failed, (unsigned)complete);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE(failed > 0);
+}
+
+// Peak memory is the scanner plus one read chunk, whatever the body size:
+// a 32 KB body with the keys at the very end scans without a heap
+// allocation, where buffering it (the old getString()) needed all of it.
+static void test_peak_memory()
+{
+  std::string big = "{\"pad\":[";
+  while (big.size() < 32 * 1024)
+    big += "{\"unixtime\":1,\"s\":\"}]\\\"\"},";
+  big += "0],\"unixtime\":4102444800,\"utc_offset\":\"-05:30\",\"datetime\":\"2100-01-01T00:00:00.000000-05:30\"}";
+
+  static const size_t kMss[] = {536};
+  JsonKeyScanner js(kKeys, 3);
+  const size_t before = heapAllocs;
+  scan(big.data(), big.size(), kMss, 1, js);
+  TEST_ASSERT_EQUAL(before, heapAllocs);
+  checkValues(js, kNestedValues);
+  TEST_ASSERT_EQUAL(big.size() - 1, js.bytesSeen()); // all but the closing brace
+
+  char msg[160];
+  snprintf(msg, sizeof(msg),
+           "peak memory: scanner %u B + read chunk %u B = %u B for a %u B body (recorded body: %u B); heap allocs: 0",
+           (unsigned)sizeof(JsonKeyScanner), (unsigned)kBodyChunk, (unsigned)(sizeof(JsonKeyScanner) + kBodyChunk),
+           (unsigned)big.size(), (unsigned)(sizeof(kRecorded) - 1));
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE(sizeof(JsonKeyScanner) + kBodyChunk < 512);
+}
+
+void setUp() {}
+void tearDown() {}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_recorded_bodies);
+  RUN_TEST(test_every_split);
+  RUN_TEST(test_truncated_bodies);
+  RUN_TEST(test_corrupted_bodies);
+  RUN_TEST(test_peak_memory);
+  return UNITY_END();
+}
@@ -0,0 +1,205 @@
+// Warm-boot restore of TimeMgr's RTC checkpoint against a fake RtcStore:
+// only an intact, recent record after a warm reset is trusted, and the sync
+// that confirms it does not touch the frequency estimate.
+#include "rtc_store.h"
+#include "sim.h"
+#include "time_mgr.h"
+#include "wifi_mgr.h"
+#include <stddef.h>
+#include <string.h>
+#include <unity.h>
+#include <user_interface.h>
+
+// Same layout as TimeCheckpoint in time_mgr.cpp
+struct Checkpoint
+{
+  uint32_t magic;
+  uint32_t utcMsLo;
+  uint32_t utcMsHi;
+  uint32_t millisRef;
+  uint32_t syncAgeMs;
+  int32_t utcOffsetSec;
+  int32_t driftPpb;
+  uint32_t crc;
+};
+static constexpr uint32_t kMagic = 0x544D4331UL; // "TMC1"
+static constexpr int32_t kDriftPpb = -40000;     // the sim crystal's default 40 ppm, corrected
+
+class FakeRtcStore : public RtcStore
+{
+public:
+  uint32_t words[128] = {};
+  bool warm = true;
+
+  bool read(uint32_t offsetWords, void* data, size_t bytes) override
+  {
+    if (offsetWords * 4 + bytes > sizeof(words))
+      return false;
+    memcpy(data, words + offsetWords, bytes);
+    return true;
+  }
+  bool write(uint32_t offsetWords, const void* data, size_t bytes) override
+  {
+    if (offsetWords * 4 + bytes > sizeof(words))
+      return false;
+    memcpy(words + offsetWords, data, bytes);
+    return true;
+  }
+  bool warmBoot() const override { return warm; }
+
+  // What the previous boot left: a checkpoint reading utcMs at millis() == 0
+  // of this one, as if the reset took no time at all.
+  Checkpoint& checkpoint(int64_t utcMs, uint32_t syncAgeMs)
+  {
+    Checkpoint& cp = *reinterpret_cast<Checkpoint*>(words + kRtcSlotTime);
+    cp.magic = kMagic;
+    cp.utcMsLo = (uint32_t)utcMs;
+    cp.utcMsHi = (uint32_t)((uint64_t)utcMs >> 32);
+    cp.millisRef = 3600000;
+    cp.syncAgeMs = syncAgeMs;
+    cp.utcOffsetSec = simConfig().utcOffsetSec;
+    cp.driftPpb = kDriftPpb;
+    seal();
+    return cp;
+  }
+  void seal()
+  {
+    Checkpoint& cp = *reinterpret_cast<Checkpoint*>(words + kRtcSlotTime);
+    cp.crc = crc32(&cp, offsetof(Checkpoint, crc));
+  }
+};
+
+static FakeRtcStore store;
+static WifiMgr wifi;
+static TimeMgr* timeMgr;
+
+// The device clock keeps running across cases, so "now" stands for the
+// moment of the reset: the record reads true UTC minus millis().
+static int64_t bootUtcMs() { return simTrueUtcMs() - millis(); }
+
+static void boot()
+{
+  delete timeMgr;
+  timeMgr = new TimeMgr();
+  timeMgr->attachStore(&store);
+  timeMgr->attachWifi(&wifi);
+  timeMgr->init();
+}
+
+void setUp()
+{
+  simConfig() = SimConfig();
+  memset(store.words, 0, sizeof(store.words));
+  store.warm = true;
+}
+
+void tearDown() {}
+
+static void test_intact_checkpoint_restores()
+{
+  store.checkpoint(bootUtcMs(), 3600000);
+  boot();
+  TEST_ASSERT_TRUE(timeMgr->isRestored());
+  TEST_ASSERT_TRUE(timeMgr->isSynced());
+  TEST_ASSERT_INT64_WITHIN(5, 0, timeMgr->clock().utcAt(millis()) - simTrueUtcMs());
+  TEST_ASSERT_EQUAL_INT32(kDriftPpb, timeMgr->clock().driftPpb());
+}
+
+static void test_cold_boot_ignores_checkpoint()
+{
+  store.checkpoint(bootUtcMs(), 3600000);
+  store.warm = false;
+  boot();
+  TEST_ASSERT_FALSE(timeMgr->isRestored());
+  TEST_ASSERT_FALSE(timeMgr->isSynced());
+}
+
+static void test_bad_crc_rejected()
+{
+  Checkpoint& cp = store.checkpoint(bootUtcMs(), 3600000);
+  cp.utcMsLo ^= 0x100; // a bit lost in RTC memory
+  boot();
+  TEST_ASSERT_FALSE(timeMgr->isSynced());
+}
+
+static void test_bad_magic_rejected()
+{
+  Checkpoint& cp = store.checkpoint(bootUtcMs(), 3600000);
+  cp.magic = 0x544D4330UL; // an older record format, CRC intact
+  store.seal();
+  boot();
+  TEST_ASSERT_FALSE(timeMgr->isSynced());
+}
+
+static void test_stale_sync_rejected()
+{
+  store.checkpoint(bootUtcMs(), 24UL * 3600 * 1000 + 1000);
+  boot();
+  TEST_ASSERT_FALSE(timeMgr->isSynced());
+
+  store.checkpoint(bootUtcMs(), 24UL * 3600 * 1000 - 1000);
+  boot();
+  TEST_ASSERT_TRUE(timeMgr->isRestored());
+}
+
+static void test_confirming_sync_only_steps()
+{
+  // the reset gap shows up as an offset on the restored clock
+  store.checkpoint(bootUtcMs() - 800, 3600000);
+  boot();
+  const uint32_t pollMs = timeMgr->clock().pollIntervalMs();
+
+  // long enough for addSample() to turn that offset into a frequency change
+  delay(120000);
+  wifi.loop();
+  const uint32_t start = millis();
+  while (timeMgr->isRestored() && millis() - start < 20000)
+  {
+    wifi.loop();
+    timeMgr->update();
+    delay(10);
+  }
+  TEST_ASSERT_FALSE(timeMgr->isRestored());
+  TEST_ASSERT_EQUAL_INT32(kDriftPpb, timeMgr->clock().driftPpb());
+  TEST_ASSERT_EQUAL_UINT32(pollMs, timeMgr->clock().pollIntervalMs());
+  TEST_ASSERT_INT64_WITHIN(100, 0, timeMgr->clock().utcAt(millis()) - simTrueUtcMs());
+}
+
+static void test_reset_reasons()
+{
+  static const struct
+  {
+    uint32_t reason;
+    bool warm;
+  } kCases[] = {
+      {REASON_DEFAULT_RST, false},  {REASON_WDT_RST, true},          {REASON_EXCEPTION_RST, true},
+      {REASON_SOFT_WDT_RST, true},  {REASON_SOFT_RESTART, true},     {REASON_DEEP_SLEEP_AWAKE, false},
+      {REASON_EXT_SYS_RST, false},
+  };
+  EspRtcStore esp;
+  for (const auto& c : kCases)
+  {
+    simConfig().resetReason = c.reason;
+    TEST_ASSERT_EQUAL(c.warm, esp.warmBoot());
+  }
+}
+
+int main()
+{
+  wifi.init();
+  while (!wifi.isConnected())
+  {
+    wifi.loop();
+    delay(10);
+  }
+  UNITY_BEGIN();
+  RUN_TEST(test_intact_checkpoint_restores);
+  RUN_TEST(test_cold_boot_ignores_checkpoint);
+  RUN_TEST(test_bad_crc_rejected);
+  RUN_TEST(test_bad_magic_rejected);
+  RUN_TEST(test_stale_sync_rejected);
+  RUN_TEST(test_confirming_sync_only_steps);
+  RUN_TEST(test_reset_reasons);
+  delete timeMgr;
+  return UNITY_END();
+}
@@ -0,0 +1,207 @@
+// Scheduler on a virtual clock: thousands of tasks run in deadline order,
+// periodic ones do not drift (across the millis() wrap too), and the heap
+// work per run grows with log(tasks) only (host timings are reported, not
+// asserted).
+#include "scheduler.h"
+#include <time.h>
+#include <unity.h>
+
+static constexpr uint16_t kMany = 4000;
+
+static uint32_t vnow;
+static uint32_t virtualClock() { return vnow; }
+
+static uint32_t rng = 12345;
+static uint32_t nextRandom()
+{
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+static uint64_t hostNs()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+struct Shot
+{
+  Scheduler::TaskId id;
+  uint32_t due;
+  uint32_t ranAt;
+  uint16_t runs;
+};
+static Shot shots[kMany];
+static Shot* order[kMany];
+static uint16_t ran;
+
+static void shotFn(void* ctx)
+{
+  Shot* s = static_cast<Shot*>(ctx);
+  s->ranAt = vnow;
+  s->runs++;
+  order[ran++] = s;
+}
+
+static void noop(void*) {}
+
+void setUp()
+{
+  vnow = 0xFFFFF000UL; // a few seconds before millis() wraps
+  ran = 0;
+}
+
+void tearDown() {}
+
+static void test_one_shots_run_in_deadline_order()
+{
+  auto* sched = new StaticScheduler<kMany>(virtualClock);
+  for (uint16_t i = 0; i < kMany; i++)
+  {
+    const uint32_t delay = nextRandom() % 10000;
+    shots[i] = Shot{sched->after("shot", delay, shotFn, &shots[i]), vnow + delay, 0, 0};
+    TEST_ASSERT_EQUAL(i, shots[i].id);
+  }
+  TEST_ASSERT_EQUAL(Scheduler::kNoTask, sched->after("full", 0, noop, nullptr));
+
+  // every third one is cancelled, every fifth moved later
+  for (uint16_t i = 0; i < kMany; i += 3)
+    TEST_ASSERT_TRUE(sched->cancel(shots[i].id));
+  for (uint16_t i = 1; i < kMany; i += 5)
+  {
+    if (i % 3 == 0)
+    {
+      TEST_ASSERT_FALSE(sched->runIn(shots[i].id, 0));
+      continue;
+    }
+    const uint32_t delay = 10000 + nextRandom() % 5000;
+    TEST_ASSERT_TRUE(sched->runIn(shots[i].id, delay));
+    shots[i].due = vnow + delay;
+  }
+
+  const uint32_t start = vnow;
+  while (vnow - start < 16000)
+  {
+    const uint32_t wait = sched->runDue();
+    vnow += wait ? 1 + nextRandom() % wait : 1;
+  }
+  TEST_ASSERT_EQUAL(0, sched->count());
+
+  uint16_t expected = 0;
+  for (uint16_t i = 0; i < kMany; i++)
+  {
+    const Shot& s = shots[i];
+    if (i % 3 == 0)
+    {
+      TEST_ASSERT_EQUAL(0, s.runs);
+      continue;
+    }
+    expected++;
+    TEST_ASSERT_EQUAL(1, s.runs);
+    TEST_ASSERT_TRUE((int32_t)(s.ranAt - s.due) >= 0);
+  }
+  TEST_ASSERT_EQUAL(expected, ran);
+  for (uint16_t i = 1; i < ran; i++)
+  {
+    const int32_t d = (int32_t)(order[i]->due - order[i - 1]->due);
+    TEST_ASSERT_TRUE(d > 0 || (d == 0 && order[i]->id > order[i - 1]->id));
+  }
+  delete sched;
+}
+
+static void test_periodic_tasks_do_not_drift()
+{
+  static constexpr uint16_t kTasks = 1000;
+  static constexpr uint32_t kSpanMs = 100000;
+  auto* sched = new StaticScheduler<kTasks>(virtualClock);
+  const uint32_t start = vnow;
+  for (uint16_t i = 0; i < kTasks; i++)
+    sched->every("tick", 10 + i, noop, nullptr);
+  for (; vnow - start <= kSpanMs; vnow++)
+    sched->runDue();
+
+  for (uint16_t i = 0; i < kTasks; i++)
+  {
+    const Scheduler::TaskStats* s = sched->stats(i);
+    TEST_ASSERT_NOT_NULL(s);
+    TEST_ASSERT_EQUAL(kSpanMs / (10 + i) + 1, s->runs);
+    TEST_ASSERT_EQUAL(0, s->lateMaxMs);
+  }
+  delete sched;
+}
+
+// Heap steps and host ns per task run with n periodic tasks due one after
+// another, and per runDue() with nothing due.
+struct Overhead
+{
+  double stepsPerRun;
+  uint32_t idleSteps;
+  double perRunNs;
+  double idleNs;
+};
+
+static Overhead measure(Scheduler& sched, uint16_t n)
+{
+  Overhead o;
+  for (uint16_t i = 0; i < n; i++)
+    sched.every("load", n, noop, nullptr, i); // one due every ms
+  const uint32_t runs = 200000;
+  sched.resetStats();
+  uint64_t t0 = hostNs();
+  for (uint32_t i = 0; i < runs; i++, vnow++)
+    sched.runDue();
+  o.perRunNs = (double)(hostNs() - t0) / runs;
+  o.stepsPerRun = (double)sched.heapSteps() / runs;
+
+  vnow--; // everything due has run
+  sched.resetStats();
+  t0 = hostNs();
+  for (uint32_t i = 0; i < runs; i++)
+    sched.runDue();
+  o.idleNs = (double)(hostNs() - t0) / runs;
+  o.idleSteps = sched.heapSteps();
+  return o;
+}
+
+static unsigned floorLog2(unsigned n)
+{
+  unsigned l = 0;
+  while (n >>= 1)
+    l++;
+  return l;
+}
+
+static void test_overhead_grows_with_log_of_tasks()
+{
+  auto* small = new StaticScheduler<16>(virtualClock);
+  auto* large = new StaticScheduler<kMany>(virtualClock);
+  const Overhead s = measure(*small, 16);
+  const Overhead l = measure(*large, kMany);
+  char msg[192];
+  snprintf(msg, sizeof(msg),
+           "per run: %.2f heap steps, %.0f ns with 16 tasks; %.2f steps, %.0f ns with %u; nothing due: %.0f / %.0f ns",
+           s.stepsPerRun, s.perRunNs, l.stepsPerRun, l.perRunNs, (unsigned)kMany, s.idleNs, l.idleNs);
+  TEST_MESSAGE(msg);
+
+  // the task that ran is now due last and sinks at most the heap's depth
+  TEST_ASSERT_TRUE(s.stepsPerRun <= floorLog2(16));
+  TEST_ASSERT_TRUE(l.stepsPerRun <= floorLog2(kMany));
+  TEST_ASSERT_TRUE(l.stepsPerRun > s.stepsPerRun);
+  // nothing due is a peek at the heap top
+  TEST_ASSERT_EQUAL(0, s.idleSteps);
+  TEST_ASSERT_EQUAL(0, l.idleSteps);
+  delete small;
+  delete large;
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_one_shots_run_in_deadline_order);
+  RUN_TEST(test_periodic_tasks_do_not_drift);
+  RUN_TEST(test_overhead_grows_with_log_of_tasks);
+  return UNITY_END();
+}
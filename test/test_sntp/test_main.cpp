@@ -0,0 +1,154 @@
+// SntpClient against the fake NTP servers in sim/sim_net.cpp with injected
+// per-server delay and random jitter on each leg: the round has to pick the
+// sample with the smallest round trip, and its offset has to be within half
+// that round trip of the reference UTC.
+#include "sim.h"
+#include "sntp_client.h"
+#include "wifi_mgr.h"
+#include <unity.h>
+
+static constexpr uint32_t kPollGapMs = 10; // App polls the time task about this often
+static constexpr uint32_t kRounds = 300;
+
+static WifiMgr wifi;
+
+static uint32_t rng = 12345;
+static uint32_t nextRandom()
+{
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+struct Round
+{
+  bool ok;
+  SntpSample best;
+  int64_t errorMs;      // chosen offset against the reference UTC
+  uint32_t answered[3]; // per server, in this round
+  uint32_t rttMs[3];    // true round trip per server, if answered
+};
+
+static Round runRound(SntpClient& sntp)
+{
+  Round r{};
+  uint32_t before[3];
+  for (uint8_t i = 0; i < 3; i++)
+    before[i] = simNtpExchange(i).answered;
+
+  sntp.start(millis());
+  while (sntp.poll(millis()))
+    delay(kPollGapMs);
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    const SimNtpExchange& x = simNtpExchange(i);
+    r.answered[i] = x.answered - before[i];
+    r.rttMs[i] = x.upMs + x.downMs;
+  }
+  r.ok = sntp.hasResult();
+  if (r.ok)
+  {
+    r.best = sntp.best();
+    r.errorMs = r.best.offsetMs + (int64_t)millis() - simTrueUtcMs();
+  }
+  return r;
+}
+
+void setUp()
+{
+  simConfig() = SimConfig();
+  while (!wifi.isConnected())
+  {
+    wifi.loop();
+    delay(kPollGapMs);
+  }
+}
+
+void tearDown() {}
+
+// Fixed delays, no jitter: the nearest server wins and the offset is exact
+// up to the poll gap.
+static void test_picks_nearest_server()
+{
+  SimConfig& c = simConfig();
+  c.ntpJitterMs = 0;
+  c.ntpServerMs[0] = 200;
+  c.ntpServerMs[1] = 15;
+  c.ntpServerMs[2] = 90;
+  SntpClient sntp;
+  const Round r = runRound(sntp);
+  TEST_ASSERT_TRUE(r.ok);
+  TEST_ASSERT_EQUAL(3, sntp.samples());
+  TEST_ASSERT_EQUAL(1, r.best.server);
+  TEST_ASSERT_UINT32_WITHIN(kPollGapMs, r.rttMs[1], r.best.delayMs);
+  TEST_ASSERT_INT64_WITHIN(kPollGapMs / 2 + 1, 0, r.errorMs);
+}
+
+// Random per-server delays with jitter on each leg, so the path is
+// asymmetric by up to the jitter: over many rounds the chosen sample is
+// always (up to the poll gap) the fastest one, and its error never exceeds
+// half its measured round trip.
+static void test_jitter_keeps_error_within_half_delay()
+{
+  SimConfig& c = simConfig();
+  c.ntpJitterMs = 80;
+  SntpClient sntp;
+  int64_t worst = 0;
+  uint32_t picks[3] = {0, 0, 0};
+  for (uint32_t i = 0; i < kRounds; i++)
+  {
+    for (uint8_t s = 0; s < 3; s++)
+      c.ntpServerMs[s] = nextRandom() % 150;
+    const Round r = runRound(sntp);
+    TEST_ASSERT_TRUE(r.ok);
+    TEST_ASSERT_EQUAL(3, sntp.samples());
+
+    uint32_t fastest = UINT32_MAX;
+    for (uint8_t s = 0; s < 3; s++)
+    {
+      TEST_ASSERT_EQUAL(1, r.answered[s]);
+      fastest = r.rttMs[s] < fastest ? r.rttMs[s] : fastest;
+    }
+    TEST_ASSERT_TRUE(r.rttMs[r.best.server] <= fastest + kPollGapMs);
+    TEST_ASSERT_INT64_WITHIN(r.best.delayMs / 2 + 1, 0, r.errorMs);
+    // the asymmetry alone is below jitter / 2; late polling adds to both
+    TEST_ASSERT_INT64_WITHIN((c.ntpJitterMs + kPollGapMs) / 2 + 1, 0, r.errorMs);
+    worst = r.errorMs < 0 ? (-r.errorMs > worst ? -r.errorMs : worst) : (r.errorMs > worst ? r.errorMs : worst);
+    picks[r.best.server]++;
+  }
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%u rounds, jitter %u ms: worst offset error %lld ms, picks %u/%u/%u",
+           (unsigned)kRounds, (unsigned)c.ntpJitterMs, (long long)worst, (unsigned)picks[0], (unsigned)picks[1],
+           (unsigned)picks[2]);
+  TEST_MESSAGE(msg);
+  for (uint8_t s = 0; s < 3; s++)
+    TEST_ASSERT_TRUE(picks[s] > 0);
+}
+
+// A server slower than the reply timeout is skipped; the round still ends
+// with the other two.
+static void test_late_reply_is_dropped()
+{
+  SimConfig& c = simConfig();
+  c.ntpJitterMs = 20;
+  c.ntpServerMs[0] = 700; // 1.4 s round trip, past kReplyTimeoutMs
+  SntpClient sntp;
+  const Round r = runRound(sntp);
+  TEST_ASSERT_TRUE(r.ok);
+  TEST_ASSERT_EQUAL(2, sntp.samples());
+  TEST_ASSERT_TRUE(r.best.server != 0);
+  TEST_ASSERT_INT64_WITHIN(r.best.delayMs / 2 + 1, 0, r.errorMs);
+  delay(1000); // let the late reply arrive and be discarded with the socket
+}
+
+int main()
+{
+  wifi.init();
+  UNITY_BEGIN();
+  RUN_TEST(test_picks_nearest_server);
+  RUN_TEST(test_jitter_keeps_error_within_half_delay);
+  RUN_TEST(test_late_reply_is_dropped);
+  return UNITY_END();
+}
@@ -0,0 +1,314 @@
+// wrapNextLine() against the wrapper it replaced: the same break positions on
+// Russian and ASCII text at several widths, and the time both take on long
+// Russian paragraphs and on words too long for a line (reported, not
+// asserted: host timings are too noisy to gate on). Then the line-break index
+// behind drawWrappedUTF8(): a page is wrapped from its own first line.
+#include "oled.h"
+#include "text_layout.h"
+#include "text_wrap.h"
+#include "ui_fonts.h"
+#include <U8g2lib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <unity.h>
+#include <vector>
+
+static const char kRussian[] =
+    "Микроконтроллер просыпается, подключается к точке доступа, узнаёт точное время и рисует его на маленьком "
+    "экране. Всё это должно происходить быстро, без заметных пауз, даже если сеть медленная или сервер времени "
+    "отвечает с опозданием. Каждая строка текста переносится по словам, а слишком длинное слово разбивается "
+    "на части, чтобы не выйти за границы экрана. Шрифт содержит кириллицу, латиницу, цифры и знаки препинания: "
+    "точки, запятые, двоеточия, тире - и даже номер № и букву Ё.";
+
+static const char kAscii[] =
+    "The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor jugs. Sphinx of black "
+    "quartz, judge my vow! How vexingly quick daft zebras jump; the five boxing wizards jump quickly.";
+
+static Oled oled;
+
+static uint64_t hostNs()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static bool isSpaceByte(uint8_t b) { return b == ' ' || b == '\t' || b == '\n' || b == '\r'; }
+
+// The line breaking of drawWrappedUTF8() before the single-pass rewrite: every
+// candidate line rebuilt and measured with getUTF8Width(), lines of words
+// joined by one space, words cut at 95 bytes. A word wider than w is hard
+// broken byte by byte, the chunk rebuilt and measured for every byte, and the
+// rest carried over unmeasured. That path can split a codepoint, so the break
+// comparisons keep every word narrower than w and it is only timed.
+static std::vector<std::string> legacyWrap(U8G2& u8g2, int w, const char* utf8)
+{
+  std::vector<std::string> lines;
+  char line[192];
+  char word[96];
+  line[0] = '\0';
+  const char* p = utf8;
+  while (*p)
+  {
+    while (*p && isSpaceByte((uint8_t)*p))
+      p++;
+    size_t n = 0;
+    while (*p && !isSpaceByte((uint8_t)*p) && n + 1 < sizeof(word))
+      word[n++] = *p++;
+    word[n] = '\0';
+    if (!n)
+      break;
+
+    char test[192];
+    snprintf(test, sizeof(test), "%s%s%s", line, line[0] ? " " : "", word);
+    if (u8g2.getUTF8Width(test) <= w)
+    {
+      strcpy(line, test);
+      continue;
+    }
+    if (line[0])
+      lines.push_back(line);
+    strcpy(line, word);
+    if (u8g2.getUTF8Width(word) <= w)
+      continue;
+
+    char chunk[192] = "";
+    size_t k = 0;
+    for (; word[k]; k++)
+    {
+      char tmp[192];
+      snprintf(tmp, sizeof(tmp), "%s%c", chunk, word[k]);
+      if (u8g2.getUTF8Width(tmp) > w)
+        break;
+      strcpy(chunk, tmp);
+    }
+    if (chunk[0])
+      lines.push_back(chunk);
+    strcpy(line, word + k);
+  }
+  if (line[0])
+    lines.push_back(line);
+  return lines;
+}
+
+static std::vector<std::string> newWrap(U8G2& u8g2, int w, const char* utf8)
+{
+  std::vector<std::string> lines;
+  WrapCursor cur;
+  WrapLine line;
+  while (wrapNextLine(u8g2, utf8, w, cur, line))
+  {
+    // whitespace runs collapse to one space, as drawWrapLine() draws them
+    std::string s;
+    bool gap = false;
+    for (size_t i = line.start; i < line.end; i++)
+    {
+      if (isSpaceByte((uint8_t)utf8[i]))
+      {
+        gap = true;
+        continue;
+      }
+      if (gap)
+        s += ' ';
+      gap = false;
+      s += utf8[i];
+    }
+    lines.push_back(s);
+  }
+  return lines;
+}
+
+static void checkSameBreaks(const uint8_t* font, const char* text)
+{
+  U8G2& g = oled.gfx();
+  g.setFont(font);
+  static const int kWidths[] = {128, 127, 121, 110, 103, 97, 90};
+  for (int w : kWidths)
+  {
+    const std::vector<std::string> want = legacyWrap(g, w, text);
+    const std::vector<std::string> got = newWrap(g, w, text);
+    char msg[64];
+    snprintf(msg, sizeof(msg), "line count at w=%d", w);
+    TEST_ASSERT_EQUAL_MESSAGE(want.size(), got.size(), msg);
+    for (size_t i = 0; i < want.size(); i++)
+    {
+      TEST_ASSERT_EQUAL_STRING(want[i].c_str(), got[i].c_str());
+      TEST_ASSERT_TRUE(g.getUTF8Width(got[i].c_str()) <= w);
+    }
+  }
+}
+
+static void test_cyrillic_breaks_match_legacy() { checkSameBreaks(ui_font_6x12_cyr, kRussian); }
+
+static void test_ascii_breaks_match_legacy() { checkSameBreaks(ui_font_6x12, kAscii); }
+
+static void test_hard_break_stays_on_codepoints()
+{
+  U8G2& g = oled.gfx();
+  g.setFont(ui_font_6x12_cyr);
+  static const char kWord[] = "Превысокомногорассмотрительствующий";
+  const std::vector<std::string> lines = newWrap(g, 40, kWord);
+  std::string joined;
+  for (const std::string& l : lines)
+  {
+    TEST_ASSERT_TRUE(g.getUTF8Width(l.c_str()) <= 40);
+    TEST_ASSERT_TRUE(((uint8_t)l[0] & 0xC0) != 0x80); // no line starts mid-codepoint
+    joined += l;
+  }
+  TEST_ASSERT_EQUAL_STRING(kWord, joined.c_str());
+}
+
+// Times both wrappers on text at 128 px; sameBreaks when its words all fit a line.
+static void benchmark(const char* label, const std::string& text, bool sameBreaks)
+{
+  U8G2& g = oled.gfx();
+  g.setFont(ui_font_6x12_cyr);
+  const int kRuns = 20;
+  size_t legacyLines = 0, lines = 0;
+  uint64_t t0 = hostNs();
+  for (int i = 0; i < kRuns; i++)
+    legacyLines = legacyWrap(g, 128, text.c_str()).size();
+  const double legacyUs = (double)(hostNs() - t0) / kRuns / 1000.0;
+  t0 = hostNs();
+  for (int i = 0; i < kRuns; i++)
+    lines = newWrap(g, 128, text.c_str()).size();
+  const double newUs = (double)(hostNs() - t0) / kRuns / 1000.0;
+  if (sameBreaks)
+    TEST_ASSERT_EQUAL(legacyLines, lines);
+
+  char msg[192];
+  snprintf(msg, sizeof(msg), "%s: %u bytes, %u lines at 128 px: getUTF8Width wrapper %.1f us, wrapNextLine %.1f us (%.1fx)",
+           label, (unsigned)text.size(), (unsigned)lines, legacyUs, newUs, legacyUs / newUs);
+  TEST_MESSAGE(msg);
+}
+
+static void test_benchmark_long_paragraphs()
+{
+  std::string text;
+  for (int i = 0; i < 8; i++)
+    (text += kRussian) += ' ';
+  benchmark("paragraphs", text, true);
+}
+
+// Unbroken runs (a URL, a hash, a long compound) take the hard-break path,
+// which the old wrapper measured once per byte added to the chunk.
+static void test_benchmark_long_words()
+{
+  std::string text;
+  for (int i = 0; i < 8; i++)
+  {
+    for (int j = 0; j < 4; j++)
+      text += "Превысокомногорассмотрительствующий";
+    text += ' ';
+  }
+  benchmark("long words", text, false);
+}
+
+// Page `first` of the box drawn by wrapping the text from its start.
+static void drawPageFromStart(U8G2& u8g2, const char* utf8, int w, uint16_t first, int h, int lineH)
+{
+  WrapCursor cur;
+  WrapLine line;
+  for (uint16_t i = 0; i < first && wrapNextLine(u8g2, utf8, w, cur, line); i++)
+  {
+  }
+  int baseline = lineH - 2;
+  for (int i = 0; i < h / lineH && wrapNextLine(u8g2, utf8, w, cur, line); i++)
+  {
+    drawWrapLine(u8g2, 0, baseline, utf8, line);
+    baseline += lineH;
+  }
+}
+
+// Draws every page of text through cache and checks the pixels against a wrap
+// from the start; returns the most lines any page wrapped beyond its own.
+static uint32_t checkPages(TextLayoutCache& cache, const char* text)
+{
+  U8G2& g = oled.gfx();
+  g.setFont(ui_font_6x12_cyr);
+  const int kLineH = 12;
+  const int kPageLines = 64 / kLineH;
+  const size_t kBufBytes = 128 * 64 / 8;
+  static uint8_t want[kBufBytes];
+
+  const TextLayout& layout = cache.get(g, text, 128);
+  uint32_t extra = 0;
+  for (uint16_t first = 0; first < layout.lines; first += kPageLines)
+  {
+    g.clearBuffer();
+    drawPageFromStart(g, text, 128, first, 64, kLineH);
+    memcpy(want, g.getBufferPtr(), kBufBytes);
+
+    g.clearBuffer();
+    const uint32_t before = cache.linesWrapped();
+    const uint16_t drawn = cache.drawLines(g, cache.get(g, text, 128), text, first, 0, kLineH - 2, 64, kLineH);
+    const uint32_t wrapped = cache.linesWrapped() - before;
+    TEST_ASSERT_EQUAL(layout.lines - first < kPageLines ? layout.lines - first : kPageLines, drawn);
+    TEST_ASSERT_EQUAL_MEMORY(want, g.getBufferPtr(), kBufBytes);
+    if (wrapped - drawn > extra)
+      extra = wrapped - drawn;
+  }
+  return extra;
+}
+
+static void test_page_wraps_only_its_lines()
+{
+  TextLayoutCache cache;
+  TEST_ASSERT_EQUAL(0, checkPages(cache, kRussian));
+  const TextLayout& layout = cache.get(oled.gfx(), kRussian, 128);
+  TEST_ASSERT_TRUE(layout.lines > 3 * 5); // several pages
+  TEST_ASSERT_EQUAL(1, layout.stride);
+  TEST_ASSERT_EQUAL(1, cache.misses());
+}
+
+// Past kSlots lines a page may start between two kept line starts.
+static void test_long_text_seek_is_bounded()
+{
+  std::string text;
+  for (int i = 0; i < 8; i++)
+    (text += kRussian) += ' ';
+  TextLayoutCache cache;
+  const uint32_t extra = checkPages(cache, text.c_str());
+  const TextLayout& layout = cache.get(oled.gfx(), text.c_str(), 128);
+  TEST_ASSERT_TRUE(layout.lines > TextLayout::kSlots);
+  TEST_ASSERT_TRUE(layout.stride > 1);
+  TEST_ASSERT_TRUE(extra < layout.stride);
+}
+
+static void test_layout_cache_evicts_least_recent()
+{
+  U8G2& g = oled.gfx();
+  g.setFont(ui_font_6x12_cyr);
+  static const char* const kTexts[] = {"один два", "три четыре", "пять шесть", "семь восемь", "девять десять"};
+  TextLayoutCache cache;
+  for (int i = 0; i < 4; i++)
+    cache.get(g, kTexts[i], 128);
+  cache.get(g, kTexts[0], 128); // now the most recent
+  cache.get(g, kTexts[4], 128); // evicts kTexts[1]
+  TEST_ASSERT_EQUAL(5, cache.misses());
+  cache.get(g, kTexts[0], 128);
+  TEST_ASSERT_EQUAL(2, cache.hits());
+  cache.get(g, kTexts[1], 128);
+  TEST_ASSERT_EQUAL(6, cache.misses());
+  cache.get(g, kTexts[0], 64); // another width is another layout
+  TEST_ASSERT_EQUAL(7, cache.misses());
+}
+
+void setUp() {}
+void tearDown() {}
+
+int main()
+{
+  oled.init();
+  UNITY_BEGIN();
+  RUN_TEST(test_cyrillic_breaks_match_legacy);
+  RUN_TEST(test_ascii_breaks_match_legacy);
+  RUN_TEST(test_hard_break_stays_on_codepoints);
+  RUN_TEST(test_benchmark_long_paragraphs);
+  RUN_TEST(test_benchmark_long_words);
+  RUN_TEST(test_page_wraps_only_its_lines);
+  RUN_TEST(test_long_text_seek_is_bounded);
+  RUN_TEST(test_layout_cache_evicts_least_recent);
+  return UNITY_END();
+}
@@ -0,0 +1,200 @@
+// TimeMgr's sync state machine on the virtual clock: every update() has to
+// return within its slice budget while the time API is slow, refuses to
+// answer or answers normally, and the round still ends synced. The one call
+// allowed over budget is BearSSL's key exchange, which the sim leaves out
+// (tlsKeyExchangeMs) except where that call is what is tested.
+#include "sim.h"
+#include "time_mgr.h"
+#include "wifi_mgr.h"
+#include <time.h>
+#include <unity.h>
+
+static constexpr uint32_t kCallBudgetUs = 5000; // kSliceBudgetMs plus a little
+static constexpr uint64_t kHostBudgetNs = 50ULL * 1000000; // loose: a shared CI host
+static constexpr uint32_t kLoopGapMs = 10;      // App runs the time task about this often
+
+static WifiMgr wifi;
+
+struct SyncRun
+{
+  uint32_t calls;
+  uint64_t maxCallUs; // virtual time spent inside one update()
+  uint64_t maxCallNs; // host time spent inside one update()
+  uint32_t longCalls; // over kCallBudgetUs
+  uint32_t tookMs;
+  bool synced;
+};
+
+static uint64_t hostNs()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Runs a fresh TimeMgr until a sync round finishes or limitMs passes.
+static SyncRun runSync(uint32_t limitMs, int64_t toleranceMs = 200)
+{
+  TimeMgr t;
+  t.attachWifi(&wifi);
+  t.init();
+
+  SyncRun r{};
+  const uint32_t start = millis();
+  while (millis() - start < limitMs)
+  {
+    wifi.loop();
+    const uint64_t v0 = simDeviceUs();
+    const uint64_t h0 = hostNs();
+    t.update();
+    const uint64_t ns = hostNs() - h0;
+    const uint64_t us = simDeviceUs() - v0;
+    r.calls++;
+    r.maxCallUs = us > r.maxCallUs ? us : r.maxCallUs;
+    r.longCalls += us > kCallBudgetUs;
+    r.maxCallNs = ns > r.maxCallNs ? ns : r.maxCallNs;
+    if (t.isSynced() && !t.isSyncing())
+    {
+      r.synced = true;
+      // UTC: without the time API there is no zone offset
+      TEST_ASSERT_INT64_WITHIN(toleranceMs, 0, t.clock().utcAt(millis()) - simTrueUtcMs());
+      break;
+    }
+    delay(kLoopGapMs);
+  }
+  r.tookMs = millis() - start;
+  return r;
+}
+
+static void checkBudget(const SyncRun& r)
+{
+  TEST_ASSERT_TRUE(r.synced);
+  TEST_ASSERT_UINT32_WITHIN(kCallBudgetUs, 0, (uint32_t)r.maxCallUs);
+  TEST_ASSERT_TRUE(r.maxCallNs < kHostBudgetNs);
+}
+
+void setUp()
+{
+  simConfig() = SimConfig();
+  simConfig().tlsKeyExchangeMs = 0;
+  while (!wifi.isConnected())
+  {
+    wifi.loop();
+    delay(kLoopGapMs);
+  }
+}
+
+void tearDown() {}
+
+static void test_http_then_sntp()
+{
+  const SyncRun r = runSync(20000);
+  checkBudget(r);
+  TEST_ASSERT_TRUE(r.calls > 10); // the handshake and response span many calls
+}
+
+static void test_slow_handshake_and_response()
+{
+  simConfig().tcpRttMs = 900;
+  simConfig().httpLatencyMs = 1500;
+  const SyncRun r = runSync(20000);
+  checkBudget(r);
+  TEST_ASSERT_TRUE(r.tookMs >= 3 * 900 + 1500); // SYN and both TLS flights, then the response
+}
+
+// BearSSL's key exchange cannot be split: it is the only long call, and only
+// as long as the key exchange itself.
+static void test_key_exchange_is_one_call()
+{
+  simConfig().tlsKeyExchangeMs = 600;
+  const SyncRun r = runSync(20000);
+  TEST_ASSERT_TRUE(r.synced);
+  TEST_ASSERT_EQUAL_UINT32(1, r.longCalls);
+  TEST_ASSERT_UINT32_WITHIN(kCallBudgetUs, 600 * 1000, (uint32_t)r.maxCallUs);
+}
+
+static void test_tls_alert_falls_back_to_sntp()
+{
+  simConfig().tlsAlert = true;
+  checkBudget(runSync(20000));
+}
+
+static void test_unanswered_syn_falls_back_to_sntp()
+{
+  simConfig().httpDown = true;
+  const SyncRun r = runSync(20000);
+  checkBudget(r);
+  TEST_ASSERT_TRUE(r.tookMs >= 3000); // waited out the connect timeout, one slice at a time
+}
+
+static void test_http_errors_fall_back_to_sntp()
+{
+  simConfig().httpFailPct = 100;
+  checkBudget(runSync(20000));
+}
+
+// Without SNTP the time API's own time has to hold: unixtime plus the
+// datetime's fraction is off by the response's trip, not by whole seconds.
+static void test_http_time_to_the_ms()
+{
+  simConfig().ntpLatencyMs = 60000;
+  checkBudget(runSync(20000, ClockDiscipline::kMaxErrorMs));
+}
+
+// A unixtime past INT32_MAX end to end: scanned, parsed and set as the clock
+static void test_unixtime_past_2038()
+{
+  simConfig().startUtcMs = 4102444800000LL - simDeviceUs() / 1000; // 2100-01-01 now
+  simConfig().ntpLatencyMs = 60000; // no SNTP answer in time, the HTTP time has to carry it
+  checkBudget(runSync(20000, 1000)); // whole seconds only
+}
+
+// A body with only the datetime key, as of when the response will be out
+static const char* datetimeBody(const char* hms)
+{
+  static char body[96];
+  const time_t t = (time_t)((simTrueUtcMs() + 500) / 1000);
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  char now[9];
+  snprintf(now, sizeof(now), "%02d:%02d:%02d", tm.tm_hour, tm.tm_min, tm.tm_sec);
+  snprintf(body, sizeof(body), "{\"datetime\":\"%04d-%02d-%02dT%s.000000+00:00\",\"utc_offset\":\"+00:00\"}",
+           tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, hms ? hms : now);
+  return body;
+}
+
+static void test_datetime_fallback()
+{
+  simConfig().httpBody = datetimeBody(nullptr);
+  simConfig().ntpLatencyMs = 60000; // the datetime has to carry it
+  checkBudget(runSync(20000, 1500));
+}
+
+// Out-of-range fields are rejected rather than carried into the epoch
+static void test_malformed_datetime_is_ignored()
+{
+  simConfig().ntpLatencyMs = 60000;
+  for (const char* hms : {"99:99:99", "24:00:00", "23:60:00", "23:59:61"})
+  {
+    simConfig().httpBody = datetimeBody(hms);
+    const SyncRun r = runSync(8000);
+    TEST_ASSERT_FALSE_MESSAGE(r.synced, hms);
+  }
+}
+
+int main()
+{
+  wifi.init();
+  UNITY_BEGIN();
+  RUN_TEST(test_http_then_sntp);
+  RUN_TEST(test_slow_handshake_and_response);
+  RUN_TEST(test_unanswered_syn_falls_back_to_sntp);
+  RUN_TEST(test_http_errors_fall_back_to_sntp);
+  RUN_TEST(test_http_time_to_the_ms);
+  RUN_TEST(test_unixtime_past_2038);
+  RUN_TEST(test_key_exchange_is_one_call);
+  RUN_TEST(test_tls_alert_falls_back_to_sntp);
+  RUN_TEST(test_datetime_fallback);
+  RUN_TEST(test_malformed_datetime_is_ignored);
+  return UNITY_END();
+}
@@ -0,0 +1,377 @@
+"""Build-time u8g2 font subsetting.
+
+Reads the subsets declared in tools/font_subsets.txt, pulls the source fonts
+out of U8g2's u8g2_fonts.c and writes src/ui_fonts.h and src/ui_fonts.cpp
+with one u8g2 font array per subset, holding only the declared glyphs.
+
+Runs as a PlatformIO pre-script (see platformio.ini) or by hand:
+
+    python tools/font_subset.py --fonts .pio/libdeps/nodemcuv2/U8g2/src/clib/u8g2_fonts.c
+
+Font layout (u8g2 font format, as read by u8g2_font_get_glyph_data()):
+  23-byte header; bytes 17/19/21 hold big-endian offsets, from the end of the
+  header, of the first glyph >= 'A', the first glyph >= 'a' and the unicode
+  jump table.
+  Glyphs 0..255: [encoding, record size, bitmap...], ended by a zero size.
+  Jump table: [offset hi, offset lo, last encoding hi, lo] per block, the
+  offsets cumulative from the table start, the last entry's encoding 0xffff.
+  Glyphs >= 256: [encoding hi, lo, record size, bitmap...], ended by encoding 0.
+"""
+
+import argparse
+import glob
+import os
+import re
+import sys
+
+HEADER_SIZE = 23
+# Glyphs per unicode jump table block. u8g2 walks the table, then the block
+# glyph by glyph; around sqrt(glyph count) keeps both walks short.
+UNICODE_BLOCK_GLYPHS = 8
+
+# project root; PlatformIO runs extra scripts without __file__
+try:
+    ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+except NameError:
+    ROOT = None
+
+
+class FontError(Exception):
+    pass
+
+
+# --- C source helpers ---------------------------------------------------------
+
+STRING_RE = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+ESCAPES = {"n": 10, "t": 9, "r": 13, "a": 7, "b": 8, "f": 12, "v": 11, "\\": 92, '"': 34, "'": 39, "?": 63}
+
+
+def unescape_c(body):
+    """Bytes of a C string literal body."""
+    out = bytearray()
+    i = 0
+    while i < len(body):
+        c = body[i]
+        if c != "\\":
+            out += c.encode("utf-8")
+            i += 1
+            continue
+        i += 1
+        c = body[i]
+        if c in "01234567":
+            j = i
+            while j < len(body) and j < i + 3 and body[j] in "01234567":
+                j += 1
+            out.append(int(body[i:j], 8) & 0xFF)
+            i = j
+        elif c == "x":
+            j = i + 1
+            while j < len(body) and body[j] in "0123456789abcdefABCDEF":
+                j += 1
+            out.append(int(body[i + 1 : j], 16) & 0xFF)
+            i = j
+        else:
+            out.append(ESCAPES.get(c, ord(c)))
+            i += 1
+    return bytes(out)
+
+
+def load_font(source, name):
+    """The bytes of one font array from u8g2_fonts.c."""
+    m = re.search(r"\b%s\s*\[\s*(\d+)\s*\][^=]*=\s*((?:\s*\"(?:[^\"\\\n]|\\.)*\")+)\s*;" % re.escape(name), source)
+    if not m:
+        raise FontError("font %s not found" % name)
+    data = b"".join(unescape_c(s) for s in STRING_RE.findall(m.group(2)))
+    if len(data) + 1 != int(m.group(1)):
+        raise FontError("font %s: %d bytes parsed, array is declared as %s" % (name, len(data), m.group(1)))
+    return data
+
+
+# --- u8g2 font format --------------------------------------------------------
+
+
+def word(data, pos):
+    return (data[pos] << 8) | data[pos + 1]
+
+
+def parse_font(data):
+    """(header, {encoding: record bytes after the encoding/size prefix})."""
+    if len(data) < HEADER_SIZE + 2:
+        raise FontError("font too short")
+    header = bytes(data[:HEADER_SIZE])
+    glyphs = {}
+
+    pos = HEADER_SIZE
+    while data[pos + 1] != 0:
+        size = data[pos + 1]
+        glyphs[data[pos]] = bytes(data[pos + 2 : pos + size])
+        pos += size
+
+    table = HEADER_SIZE + word(data, 21)
+    if table + 4 <= len(data):
+        pos = table + word(data, table)  # the first block follows the table
+        while pos + 2 < len(data) and word(data, pos) != 0:
+            size = data[pos + 2]
+            glyphs[word(data, pos)] = bytes(data[pos + 3 : pos + size])
+            pos += size
+    return header, glyphs
+
+
+def build_font(header, glyphs):
+    """A font in u8g2 format holding exactly these glyphs."""
+    low = sorted(e for e in glyphs if e < 256)
+    high = sorted(e for e in glyphs if e >= 256)
+
+    body = bytearray()
+    upper_a = lower_a = None
+    for e in low:
+        rec = glyphs[e]
+        if len(rec) + 2 > 255:
+            raise FontError("glyph %d too large" % e)
+        if upper_a is None and e >= ord("A"):
+            upper_a = len(body)
+        if lower_a is None and e >= ord("a"):
+            lower_a = len(body)
+        body += bytes([e, len(rec) + 2]) + rec
+    # a lookup starting at a missing anchor must still find the terminator
+    if upper_a is None:
+        upper_a = len(body)
+    if lower_a is None:
+        lower_a = len(body)
+    body += b"\x00\x00"
+
+    unicode_pos = len(body)
+    blocks = [high[i : i + UNICODE_BLOCK_GLYPHS] for i in range(0, len(high), UNICODE_BLOCK_GLYPHS)]
+    block_data = []
+    for block in blocks:
+        b = bytearray()
+        for e in block:
+            rec = glyphs[e]
+            if len(rec) + 3 > 255:
+                raise FontError("glyph %d too large" % e)
+            b += bytes([e >> 8, e & 0xFF, len(rec) + 3]) + rec
+        block_data.append(bytes(b))
+
+    table = bytearray()
+    table_size = 4 * max(1, len(blocks))
+    if not blocks:
+        table += bytes([0, 4, 0xFF, 0xFF])  # lands on the terminator
+    for i, block in enumerate(blocks):
+        off = table_size if i == 0 else len(block_data[i - 1])
+        last = 0xFFFF if i == len(blocks) - 1 else block[-1]
+        table += bytes([off >> 8, off & 0xFF, last >> 8, last & 0xFF])
+    body += table
+    for b in block_data:
+        body += b
+    body += b"\x00\x00"
+
+    if len(body) > 0xFFFF:
+        raise FontError("font too large")
+    h = bytearray(header)
+    h[0] = min(len(glyphs), 255)
+    for pos, val in ((17, upper_a), (19, lower_a), (21, unicode_pos)):
+        h[pos] = val >> 8
+        h[pos + 1] = val & 0xFF
+    return bytes(h) + bytes(body)
+
+
+def find_glyph(font, encoding):
+    """u8g2_font_get_glyph_data(), for checking the output."""
+    pos = HEADER_SIZE
+    if encoding <= 255:
+        if encoding >= ord("a"):
+            pos += word(font, 19)
+        elif encoding >= ord("A"):
+            pos += word(font, 17)
+        while font[pos + 1] != 0:
+            if font[pos] == encoding:
+                return font[pos + 2 : pos + font[pos + 1]]
+            pos += font[pos + 1]
+        return None
+    table = pos = HEADER_SIZE + word(font, 21)
+    while True:
+        pos += word(font, table)
+        e = word(font, table + 2)
+        table += 4
+        if e >= encoding:
+            break
+    while word(font, pos) != 0:
+        if word(font, pos) == encoding:
+            return font[pos + 3 : pos + font[pos + 2]]
+        pos += font[pos + 2]
+    return None
+
+
+# --- subset declarations -----------------------------------------------------
+
+
+def parse_number(s):
+    return int(s, 16) if s.lower().startswith("0x") else int(s)
+
+
+def scan_literals(path):
+    chars = set()
+    with open(path, "r", encoding="utf-8", errors="replace") as f:
+        for body in STRING_RE.findall(f.read()):
+            chars.update(unescape_c(body).decode("utf-8", errors="ignore"))
+    return chars
+
+
+def read_spec(path):
+    """[(name, source font, set of code points)]"""
+    subsets = []
+    with open(path, "r", encoding="utf-8") as f:
+        for n, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].strip() if not line.strip().startswith("chars") else line.strip()
+            if not line:
+                continue
+            where = "%s:%d" % (os.path.relpath(path, ROOT), n)
+            kw, _, rest = line.partition(" ")
+            rest = rest.strip()
+            if kw == "subset":
+                m = re.match(r"(\w+)\s+from\s+(\w+)$", rest)
+                if not m:
+                    raise FontError("%s: expected 'subset <name> from <font>'" % where)
+                subsets.append((m.group(1), m.group(2), set()))
+                continue
+            if not subsets:
+                raise FontError("%s: '%s' outside a subset" % (where, kw))
+            points = subsets[-1][2]
+            if kw == "range":
+                m = re.match(r"(\w+)\s*-\s*(\w+)$", rest)
+                if not m:
+                    raise FontError("%s: expected 'range <first>-<last>'" % where)
+                points.update(range(parse_number(m.group(1)), parse_number(m.group(2)) + 1))
+            elif kw == "chars":
+                m = re.match(r'"(.*)"', rest)
+                if not m:
+                    raise FontError('%s: expected chars "<text>"' % where)
+                points.update(ord(c) for c in unescape_c(m.group(1)).decode("utf-8"))
+            elif kw == "scan":
+                files = sorted(glob.glob(os.path.join(ROOT, rest)))
+                if not files:
+                    raise FontError("%s: no files match %s" % (where, rest))
+                for p in files:
+                    points.update(ord(c) for c in scan_literals(p))
+            else:
+                raise FontError("%s: unknown keyword '%s'" % (where, kw))
+    for _, _, points in subsets:
+        points.difference_update(range(0x20))  # control characters have no glyphs
+    return subsets
+
+
+# --- output ------------------------------------------------------------------
+
+
+def c_array(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join("0x%02x" % b for b in data[i : i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def write_if_changed(path, text):
+    if os.path.exists(path):
+        with open(path, "r", encoding="utf-8") as f:
+            if f.read() == text:
+                return False
+    with open(path, "w", encoding="utf-8") as f:
+        f.write(text)
+    return True
+
+
+def generate(fonts_c):
+    with open(fonts_c, "r", encoding="utf-8", errors="replace") as f:
+        source = f.read()
+
+    h = [
+        "#pragma once",
+        "// Generated by tools/font_subset.py from tools/font_subsets.txt, do not edit.",
+        "#include <U8g2lib.h>",
+        "",
+    ]
+    cpp = [
+        "// Generated by tools/font_subset.py from tools/font_subsets.txt, do not edit.",
+        '#include "ui_fonts.h"',
+        "",
+    ]
+    table = []
+    total_src = total_out = 0
+    for name, font_name, points in read_spec(os.path.join(ROOT, "tools", "font_subsets.txt")):
+        src = load_font(source, font_name)
+        header, glyphs = parse_font(src)
+        missing = sorted(p for p in points if p not in glyphs)
+        if missing:
+            print(
+                "[fonts] %s: %d character(s) not in %s: %s"
+                % (name, len(missing), font_name, " ".join("U+%04X" % p for p in missing[:16]))
+            )
+        kept = {e: g for e, g in glyphs.items() if e in points}
+        out = build_font(header, kept)
+        for e, g in kept.items():
+            if find_glyph(out, e) != g:
+                raise FontError("%s: glyph U+%04X does not read back" % (name, e))
+
+        print(
+            "[fonts] %-18s %3d of %3d glyphs from %-28s %5d -> %5d bytes (%d saved)"
+            % (name, len(kept), len(glyphs), font_name, len(src) + 1, len(out), len(src) + 1 - len(out))
+        )
+        total_src += len(src) + 1
+        total_out += len(out)
+        h.append('extern const uint8_t %s[] U8G2_FONT_SECTION("%s");' % (name, name))
+        cpp.append('const uint8_t %s[%d] U8G2_FONT_SECTION("%s") = {' % (name, len(out), name))
+        cpp.append(c_array(out))
+        cpp.append("};")
+        cpp.append("")
+        table.append("  X(%s, %s, %d, %d, %d, %d)" % (name, font_name, len(out), len(src) + 1, len(kept), len(glyphs)))
+    print("[fonts] total %d -> %d bytes of flash (%d saved)" % (total_src, total_out, total_src - total_out))
+
+    h += [
+        "",
+        "// X(subset, source font, subset bytes, source bytes, subset glyphs, source glyphs)",
+        "#define UI_FONT_SUBSETS(X) \\",
+        " \\\n".join(table),
+        "",
+    ]
+    changed = write_if_changed(os.path.join(ROOT, "src", "ui_fonts.h"), "\n".join(h))
+    changed = write_if_changed(os.path.join(ROOT, "src", "ui_fonts.cpp"), "\n".join(cpp)) or changed
+    return changed
+
+
+def find_fonts_c(search_dirs):
+    for d in search_dirs:
+        hits = glob.glob(os.path.join(d, "**", "clib", "u8g2_fonts.c"), recursive=True)
+        if hits:
+            return sorted(hits)[0]
+    return None
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("--fonts", help="path to U8g2's src/clib/u8g2_fonts.c")
+    args = ap.parse_args()
+    fonts_c = args.fonts or find_fonts_c([os.path.join(ROOT, ".pio", "libdeps")])
+    if not fonts_c:
+        sys.exit("u8g2_fonts.c not found, pass --fonts")
+    try:
+        generate(fonts_c)
+    except FontError as e:
+        sys.exit("font_subset: %s" % e)
+
+
+if __name__ == "__main__":
+    main()
+elif "Import" in globals():
+    # PlatformIO pre-script: regenerate before the sources are collected
+    Import("env")  # noqa: F821  (SCons global)
+    ROOT = env.subst("$PROJECT_DIR")  # noqa: F821
+
+    _fonts = find_fonts_c([env.subst("$PROJECT_LIBDEPS_DIR/$PIOENV"), env.subst("$PROJECT_LIBDEPS_DIR")])  # noqa: F821
+    if not _fonts:
+        sys.stderr.write("font_subset: u8g2_fonts.c not found under .pio/libdeps, is U8g2 in lib_deps?\n")
+        env.Exit(1)  # noqa: F821
+    try:
+        generate(_fonts)
+    except FontError as e:
+        sys.stderr.write("font_subset: %s\n" % e)
+        env.Exit(1)  # noqa: F821